@@ -2,6 +2,7 @@ BUILD=$(ROOT)/build
 BUILD_SRC=$(BUILD)/src
 BUILD_OBJ=$(BUILD)/obj
 BUILD_BIN=$(BUILD)/bin
+BUILD_LIB=$(BUILD)/lib
 SRC=$(ROOT)/src
 HTML=$(ROOT)/html
 ART_WORK=$(ROOT)/art-work
@@ -0,0 +1,658 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <ball-array.hh>
+#include <cmath>
+#include <cstdlib>
+#include <velocity-op.hh>
+#include <counter-rng.hh>
+#include <log.hh>
+
+template<class T>
+Ball_array<T>::Ball_array(const uint32_t capacity) :
+  _capacity(capacity)
+{
+  _count = 0;
+  _px = (T *)alloc_aligned(capacity, sizeof(T));
+  _py = (T *)alloc_aligned(capacity, sizeof(T));
+  _vx = (T *)alloc_aligned(capacity, sizeof(T));
+  _vy = (T *)alloc_aligned(capacity, sizeof(T));
+  _random_seed = (uint32_t *)alloc_aligned(capacity, sizeof(uint32_t));
+  _random_index = (uint32_t *)alloc_aligned(capacity, sizeof(uint32_t));
+  _substep_count = (uint64_t *)alloc_aligned(capacity, sizeof(uint64_t));
+  _mass = (double *)alloc_aligned(capacity, sizeof(double));
+  _radius = (double *)alloc_aligned(capacity, sizeof(double));
+  _contact_dvx = (double *)alloc_aligned(capacity, sizeof(double));
+  _contact_dvy = (double *)alloc_aligned(capacity, sizeof(double));
+  _boundary_hit_count = (uint32_t *)alloc_aligned(capacity, sizeof(uint32_t));
+  _clamp_count = (uint32_t *)alloc_aligned(capacity, sizeof(uint32_t));
+  _max_vx = (T *)alloc_aligned(capacity, sizeof(T));
+  _max_vy = (T *)alloc_aligned(capacity, sizeof(T));
+  _width = 0;
+  _height = 0;
+  _geometry_correction_x = from_coefficient(1.0);
+  _geometry_correction_y = from_coefficient(1.0);
+  _ops = 0;
+}
+
+template<class T>
+Ball_array<T>::~Ball_array()
+{
+  free(_px);
+  _px = 0;
+  free(_py);
+  _py = 0;
+  free(_vx);
+  _vx = 0;
+  free(_vy);
+  _vy = 0;
+  free(_random_seed);
+  _random_seed = 0;
+  free(_random_index);
+  _random_index = 0;
+  free(_substep_count);
+  _substep_count = 0;
+  free(_mass);
+  _mass = 0;
+  free(_radius);
+  _radius = 0;
+  free(_contact_dvx);
+  _contact_dvx = 0;
+  free(_contact_dvy);
+  _contact_dvy = 0;
+  free(_boundary_hit_count);
+  _boundary_hit_count = 0;
+  free(_clamp_count);
+  _clamp_count = 0;
+  free(_max_vx);
+  _max_vx = 0;
+  free(_max_vy);
+  _max_vy = 0;
+  _count = 0;
+  _ops = 0;
+}
+
+template<class T>
+void *
+Ball_array<T>::alloc_aligned(const uint32_t count, const size_t size)
+{
+  // round up to full blocks, such that vector loops need no scalar
+  // remainder handling for the array bounds
+  const uint32_t blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  const size_t bytes = (blocks > 0 ? blocks : 1) * BLOCK_SIZE * size;
+  void *ptr;
+  if (posix_memalign(&ptr, 64, bytes)) {
+    Log::fatal("Ball_array::alloc_aligned(): not enough memory");
+  }
+  return ptr;
+}
+
+template<class T>
+const bool
+Ball_array<T>::is_representable_velocity(const double velocity)
+{
+  return true;
+}
+
+template<class T>
+const T
+Ball_array<T>::from_position(const double position)
+{
+  return position;
+}
+
+template<class T>
+const double
+Ball_array<T>::to_position(const T position)
+{
+  return position;
+}
+
+template<class T>
+const T
+Ball_array<T>::from_velocity(const double velocity)
+{
+  return velocity;
+}
+
+template<class T>
+const double
+Ball_array<T>::to_velocity(const T velocity)
+{
+  return velocity;
+}
+
+template<class T>
+const T
+Ball_array<T>::from_coefficient(const double coefficient)
+{
+  return coefficient;
+}
+
+template<class T>
+const uint32_t
+Ball_array<T>::get_count() const
+{
+  return _count;
+}
+
+/*
+ * Copies the state of the balls into the arrays.  Returns false, if
+ * the balls do not fit, do not share the same forces, or move too
+ * fast for the scalar type.
+ */
+template<class T>
+const bool
+Ball_array<T>::load(const std::vector<Ball *> *balls)
+{
+  if (balls->size() > _capacity) {
+    return false;
+  }
+  if (balls->empty()) {
+    _count = 0;
+    return true;
+  }
+  const Ball *first = balls->front();
+  const Ball_forces *forces = first->get_forces();
+  if (!forces) {
+    return false;
+  }
+  for (const Ball *ball : *balls) {
+    if (ball->get_forces() != forces) {
+      return false;
+    }
+    if (!is_representable_velocity(ball->get_velocity()->get_x()) ||
+        !is_representable_velocity(ball->get_velocity()->get_y())) {
+      return false;
+    }
+  }
+  _width = forces->get_width();
+  _height = forces->get_height();
+  _ops = forces->get_ops();
+  _geometry_correction_x =
+    from_coefficient(first->get_geometry_correction_x());
+  _geometry_correction_y =
+    from_coefficient(first->get_geometry_correction_y());
+  _count = balls->size();
+  for (uint32_t i = 0; i < _count; i++) {
+    const Ball *ball = balls->at(i);
+    _px[i] = from_position(ball->get_position()->get_x());
+    _py[i] = from_position(ball->get_position()->get_y());
+    _vx[i] = from_velocity(ball->get_velocity()->get_x());
+    _vy[i] = from_velocity(ball->get_velocity()->get_y());
+    _random_seed[i] = ball->get_random_seed();
+    _random_index[i] = ball->get_random_index();
+    _substep_count[i] = ball->get_substep_count();
+    _mass[i] = ball->get_mass();
+    _radius[i] = ball->get_radius();
+    _contact_dvx[i] = 0.0;
+    _contact_dvy[i] = 0.0;
+    _boundary_hit_count[i] = 0;
+    _clamp_count[i] = 0;
+    _max_vx[i] = from_velocity(0.0);
+    _max_vy[i] = from_velocity(0.0);
+  }
+  return true;
+}
+
+template<class T>
+void
+Ball_array<T>::store(std::vector<Ball *> *balls) const
+{
+  if (balls->size() != _count) {
+    Log::fatal("Ball_array::store(): ball count mismatch");
+  }
+  for (uint32_t i = 0; i < _count; i++) {
+    Ball *ball = balls->at(i);
+    ball->set_position(to_position(_px[i]), to_position(_py[i]));
+    ball->set_velocity(to_velocity(_vx[i]), to_velocity(_vy[i]));
+    ball->set_substep_count(_substep_count[i]);
+    ball->add_wall_contact(_contact_dvx[i], _contact_dvy[i]);
+#if PHYSICS_DIAGNOSTICS
+    const Ball::stats_t stats = {
+      to_velocity(_max_vx[i]), to_velocity(_max_vy[i]),
+      _boundary_hit_count[i], _clamp_count[i]
+    };
+    ball->add_stats(&stats);
+#endif
+  }
+}
+
+/*
+ * Advances balls [first, first + count) by the given number of
+ * substeps.  Distinct ranges may be stepped concurrently.
+ */
+template<class T>
+void
+Ball_array<T>::step(const uint32_t first, const uint32_t count,
+                    const uint32_t substeps,
+                    const double pitch, const double roll)
+{
+  if (first + count > _count) {
+    Log::fatal("Ball_array::step(): range out of bounds");
+  }
+  const T delta_vx = from_velocity(Ball::PITCH_ACCELERATION * pitch);
+  const T delta_vy = from_velocity(Ball::ROLL_ACCELERATION * roll);
+  for (uint32_t block = first; block < first + count; block += BLOCK_SIZE) {
+    const uint32_t block_count =
+      first + count - block < BLOCK_SIZE ? first + count - block : BLOCK_SIZE;
+    for (uint32_t i = 0; i < substeps; i++) {
+      step_block(block, block_count, i, delta_vx, delta_vy);
+    }
+    for (uint32_t i = block; i < block + block_count; i++) {
+      _substep_count[i] += substeps;
+    }
+  }
+}
+
+template<class T>
+void
+Ball_array<T>::collide_balls(Ball_collisions *ball_collisions)
+{
+  _collision_px.resize(_count);
+  _collision_py.resize(_count);
+  _collision_vx.resize(_count);
+  _collision_vy.resize(_count);
+  for (uint32_t i = 0; i < _count; i++) {
+    _collision_px[i] = to_position(_px[i]);
+    _collision_py[i] = to_position(_py[i]);
+    _collision_vx[i] = to_velocity(_vx[i]);
+    _collision_vy[i] = to_velocity(_vy[i]);
+  }
+  ball_collisions->resolve(_count,
+                           _collision_px.data(), _collision_py.data(),
+                           _collision_vx.data(), _collision_vy.data(),
+                           _mass, _radius, _width, _height);
+  for (uint32_t i = 0; i < _count; i++) {
+    _vx[i] = from_velocity(_collision_vx[i]);
+    _vy[i] = from_velocity(_collision_vy[i]);
+  }
+}
+
+template<class T>
+void
+Ball_array<T>::step_block(const uint32_t first, const uint32_t count,
+                          const uint32_t substep,
+                          const T delta_vx, const T delta_vy)
+{
+  T * __restrict__ px = _px + first;
+  T * __restrict__ py = _py + first;
+  T * __restrict__ vx = _vx + first;
+  T * __restrict__ vy = _vy + first;
+#if PHYSICS_DIAGNOSTICS
+  uint32_t * __restrict__ boundary_hit_count = _boundary_hit_count + first;
+  uint32_t * __restrict__ clamp_count = _clamp_count + first;
+  T * __restrict__ max_vx = _max_vx + first;
+  T * __restrict__ max_vy = _max_vy + first;
+#endif
+  int32_t old_x[BLOCK_SIZE], old_y[BLOCK_SIZE];
+  int32_t new_x[BLOCK_SIZE], new_y[BLOCK_SIZE];
+  uint16_t ops[BLOCK_SIZE];
+  const T width = _width;
+  const T height = _height;
+  const T min_x = Ball::MIN_X;
+  const T max_x = Ball::MAX_X;
+  const T min_y = Ball::MIN_Y;
+  const T max_y = Ball::MAX_Y;
+
+  // move
+  for (uint32_t i = 0; i < count; i++) {
+    old_x[i] = (int32_t)(px[i] * width);
+    old_y[i] = (int32_t)(py[i] * height);
+    T x = px[i] + vx[i] * _geometry_correction_x;
+    T y = py[i] + vy[i] * _geometry_correction_y;
+    const bool is_overshoot_x = (x < min_x) || (x > max_x);
+    const bool is_overshoot_y = (y < min_y) || (y > max_y);
+    x = is_overshoot_x ? x - vx[i] : x;
+    y = is_overshoot_y ? y - vy[i] : y;
+    vx[i] = is_overshoot_x ? -vx[i] : vx[i];
+    vy[i] = is_overshoot_y ? -vy[i] : vy[i];
+#if PHYSICS_DIAGNOSTICS
+    boundary_hit_count[i] += is_overshoot_x + is_overshoot_y;
+#endif
+    px[i] = x;
+    py[i] = y;
+    new_x[i] = (int32_t)(x * width);
+    new_y[i] = (int32_t)(y * height);
+  }
+
+  // gather force ops
+  for (uint32_t i = 0; i < count; i++) {
+    ops[i] = _ops->get_op(new_x[i], new_y[i]);
+  }
+
+  // collisions are rare, hence handled per ball
+  for (uint32_t i = 0; i < count; i++) {
+    const uint16_t op = ops[i];
+    if (((new_x[i] != old_x[i]) || new_y[i] || old_y[i]) &&
+        Velocity_op::is_reflection(op) &&
+        !Velocity_op::is_exclusion_zone(op)) {
+      collide(first + i, substep, op, old_x[i], old_y[i], new_x[i]);
+    }
+  }
+
+  // boundaries and acceleration
+  for (uint32_t i = 0; i < count; i++) {
+    const T x = px[i];
+    const T y = py[i];
+    const T abs_vx = fabs(vx[i]);
+    const T abs_vy = fabs(vy[i]);
+    px[i] = x < min_x ? min_x : (x > max_x ? max_x : x);
+    py[i] = y < min_y ? min_y : (y > max_y ? max_y : y);
+    vx[i] = x < min_x ? abs_vx : (x > max_x ? -abs_vx : vx[i] + delta_vx);
+    vy[i] = y < min_y ? abs_vy : (y > max_y ? -abs_vy : vy[i] + delta_vy);
+#if PHYSICS_DIAGNOSTICS
+    clamp_count[i] +=
+      ((x < min_x) || (x > max_x)) + ((y < min_y) || (y > max_y));
+    const T speed_x = fabs(vx[i]);
+    const T speed_y = fabs(vy[i]);
+    max_vx[i] = speed_x > max_vx[i] ? speed_x : max_vx[i];
+    max_vy[i] = speed_y > max_vy[i] ? speed_y : max_vy[i];
+#endif
+  }
+}
+
+/*
+ * Keeps the strongest wall contact of a step, as Ball does.
+ */
+template<class T>
+void
+Ball_array<T>::add_wall_contact(const uint32_t index,
+                                const double dvx, const double dvy)
+{
+  if (dvx * dvx + dvy * dvy >
+      _contact_dvx[index] * _contact_dvx[index] +
+      _contact_dvy[index] * _contact_dvy[index]) {
+    _contact_dvx[index] = dvx;
+    _contact_dvy[index] = dvy;
+  }
+}
+
+template<class T>
+void
+Ball_array<T>::collide(const uint32_t index, const uint32_t substep,
+                       const uint16_t op,
+                       const int32_t old_x, const int32_t old_y,
+                       const int32_t new_x)
+{
+  const struct Velocity_op::reflection_t *reflection =
+    Velocity_op::get_reflection(op);
+  const T cos_2theta = reflection->cos_2theta;
+  const T sin_2theta = reflection->sin_2theta;
+  const T vx = _vx[index];
+  const T vy = _vy[index];
+  const T new_vx = -cos_2theta * vx + sin_2theta * vy;
+  const T new_vy = sin_2theta * vx + cos_2theta * vy;
+#if PHYSICS_DIAGNOSTICS
+  if (!(fabs(new_vx) <= 1.0)) {
+    Ball::velocity_out_of_range("Ball_array::collide()", "new_vx", new_vx);
+  }
+  if (!(fabs(new_vy) <= 1.0)) {
+    Ball::velocity_out_of_range("Ball_array::collide()", "new_vy", new_vy);
+  }
+#endif
+  _vx[index] = new_vx;
+  _vy[index] = new_vy;
+  add_wall_contact(index,
+                   to_velocity(new_vx) - to_velocity(vx),
+                   to_velocity(new_vy) - to_velocity(vy));
+
+  // same jitter as in Ball::update()
+  const T alpha =
+    0.45 + 0.1 * Counter_rng::get_uniform(_random_seed[index],
+                                          _random_index[index],
+                                          _substep_count[index] + substep);
+  if (new_x != old_x) {
+    _px[index] = (old_x + alpha) / _width;
+  } else {
+    _py[index] = (old_y + alpha) / _height;
+  }
+}
+
+/*
+ * With double, the collision arrays are the balls' arrays.
+ */
+template<>
+void
+Ball_array<double>::collide_balls(Ball_collisions *ball_collisions)
+{
+  ball_collisions->resolve(_count, _px, _py, _vx, _vy, _mass, _radius,
+                           _width, _height);
+}
+
+template<>
+const bool
+Ball_array<Fixed_point>::is_representable_velocity(const double velocity)
+{
+  // leave headroom for accelerating within a step
+  return Fixed_point::is_representable(2.0 * velocity,
+                                       Fixed_point::VELOCITY_BITS);
+}
+
+template<>
+const Fixed_point
+Ball_array<Fixed_point>::from_position(const double position)
+{
+  return Fixed_point::from_double(position, Fixed_point::POSITION_BITS);
+}
+
+template<>
+const double
+Ball_array<Fixed_point>::to_position(const Fixed_point position)
+{
+  return Fixed_point::to_double(position, Fixed_point::POSITION_BITS);
+}
+
+template<>
+const Fixed_point
+Ball_array<Fixed_point>::from_velocity(const double velocity)
+{
+  return Fixed_point::from_double(velocity, Fixed_point::VELOCITY_BITS);
+}
+
+template<>
+const double
+Ball_array<Fixed_point>::to_velocity(const Fixed_point velocity)
+{
+  return Fixed_point::to_double(velocity, Fixed_point::VELOCITY_BITS);
+}
+
+template<>
+const Fixed_point
+Ball_array<Fixed_point>::from_coefficient(const double coefficient)
+{
+  return Fixed_point::from_double(coefficient, Fixed_point::COEFFICIENT_BITS);
+}
+
+template<>
+void
+Ball_array<Fixed_point>::collide(const uint32_t index, const uint32_t substep,
+                                 const uint16_t op,
+                                 const int32_t old_x, const int32_t old_y,
+                                 const int32_t new_x)
+{
+  const struct Velocity_op::fixed_reflection_t *reflection =
+    Velocity_op::get_fixed_reflection(op);
+  const int64_t cos_2theta = reflection->cos_2theta.raw;
+  const int64_t sin_2theta = reflection->sin_2theta.raw;
+  const int64_t vx = _vx[index].raw;
+  const int64_t vy = _vy[index].raw;
+  const int64_t new_vx =
+    (-cos_2theta * vx + sin_2theta * vy) >> Fixed_point::COEFFICIENT_BITS;
+  const int64_t new_vy =
+    (sin_2theta * vx + cos_2theta * vy) >> Fixed_point::COEFFICIENT_BITS;
+#if PHYSICS_DIAGNOSTICS
+  if ((new_vx <= INT32_MIN) || (new_vx >= INT32_MAX)) {
+    Ball::velocity_out_of_range("Ball_array::collide()", "new_vx",
+                                ldexp((double)new_vx,
+                                      -Fixed_point::VELOCITY_BITS));
+  }
+  if ((new_vy <= INT32_MIN) || (new_vy >= INT32_MAX)) {
+    Ball::velocity_out_of_range("Ball_array::collide()", "new_vy",
+                                ldexp((double)new_vy,
+                                      -Fixed_point::VELOCITY_BITS));
+  }
+#endif
+  add_wall_contact(index,
+                   ldexp((double)(new_vx - vx), -Fixed_point::VELOCITY_BITS),
+                   ldexp((double)(new_vy - vy), -Fixed_point::VELOCITY_BITS));
+  _vx[index].raw = (int32_t)new_vx;
+  _vy[index].raw = (int32_t)new_vy;
+
+  // same jitter as in Ball::update(), i.e. 0.45 + 0.1 * [0, 1)
+  const uint64_t random =
+    Counter_rng::get_bits(_random_seed[index], _random_index[index],
+                          _substep_count[index] + substep) >> 32;
+  const int64_t alpha =
+    from_position(0.45).raw + ((random * from_position(0.1).raw) >> 32);
+  if (new_x != old_x) {
+    _px[index].raw =
+      (int32_t)(((((int64_t)old_x) << Fixed_point::POSITION_BITS) + alpha) /
+                _width);
+  } else {
+    _py[index].raw =
+      (int32_t)(((((int64_t)old_y) << Fixed_point::POSITION_BITS) + alpha) /
+                _height);
+  }
+}
+
+// shifts from velocity times coefficient to position, and from
+// velocity to position
+#define FIXED_MOVE_SHIFT \
+  (Fixed_point::VELOCITY_BITS + Fixed_point::COEFFICIENT_BITS - \
+   Fixed_point::POSITION_BITS)
+#define FIXED_VELOCITY_SHIFT \
+  (Fixed_point::VELOCITY_BITS - Fixed_point::POSITION_BITS)
+
+/*
+ * Same as the floating point kernel, in integer arithmetic.  Pixel
+ * coordinates are rounded towards zero like in the floating point
+ * kernel, and positions slightly below zero, that may result from
+ * rounding when reflecting at the field's border, map onto pixel 0.
+ */
+template<>
+void
+Ball_array<Fixed_point>::step_block(const uint32_t first,
+                                    const uint32_t count,
+                                    const uint32_t substep,
+                                    const Fixed_point delta_vx,
+                                    const Fixed_point delta_vy)
+{
+  Fixed_point * __restrict__ px = _px + first;
+  Fixed_point * __restrict__ py = _py + first;
+  Fixed_point * __restrict__ vx = _vx + first;
+  Fixed_point * __restrict__ vy = _vy + first;
+#if PHYSICS_DIAGNOSTICS
+  uint32_t * __restrict__ boundary_hit_count = _boundary_hit_count + first;
+  uint32_t * __restrict__ clamp_count = _clamp_count + first;
+  Fixed_point * __restrict__ max_vx = _max_vx + first;
+  Fixed_point * __restrict__ max_vy = _max_vy + first;
+#endif
+  int32_t old_x[BLOCK_SIZE], old_y[BLOCK_SIZE];
+  int32_t new_x[BLOCK_SIZE], new_y[BLOCK_SIZE];
+  uint16_t ops[BLOCK_SIZE];
+  const int64_t width = _width;
+  const int64_t height = _height;
+  const int64_t geometry_correction_x = _geometry_correction_x.raw;
+  const int64_t geometry_correction_y = _geometry_correction_y.raw;
+  const int32_t min_x = from_position(Ball::MIN_X).raw;
+  const int32_t max_x = from_position(Ball::MAX_X).raw;
+  const int32_t min_y = from_position(Ball::MIN_Y).raw;
+  const int32_t max_y = from_position(Ball::MAX_Y).raw;
+
+  // move
+  for (uint32_t i = 0; i < count; i++) {
+    const int64_t x0 = px[i].raw < 0 ? 0 : px[i].raw;
+    const int64_t y0 = py[i].raw < 0 ? 0 : py[i].raw;
+    old_x[i] = (int32_t)((x0 * width) >> Fixed_point::POSITION_BITS);
+    old_y[i] = (int32_t)((y0 * height) >> Fixed_point::POSITION_BITS);
+    int64_t x = px[i].raw + ((vx[i].raw * geometry_correction_x) >>
+                             FIXED_MOVE_SHIFT);
+    int64_t y = py[i].raw + ((vy[i].raw * geometry_correction_y) >>
+                             FIXED_MOVE_SHIFT);
+    const bool is_overshoot_x = (x < min_x) || (x > max_x);
+    const bool is_overshoot_y = (y < min_y) || (y > max_y);
+    x = is_overshoot_x ? x - (vx[i].raw >> FIXED_VELOCITY_SHIFT) : x;
+    y = is_overshoot_y ? y - (vy[i].raw >> FIXED_VELOCITY_SHIFT) : y;
+    vx[i].raw = is_overshoot_x ? -vx[i].raw : vx[i].raw;
+    vy[i].raw = is_overshoot_y ? -vy[i].raw : vy[i].raw;
+#if PHYSICS_DIAGNOSTICS
+    boundary_hit_count[i] += is_overshoot_x + is_overshoot_y;
+#endif
+    px[i].raw = (int32_t)x;
+    py[i].raw = (int32_t)y;
+    const int64_t x1 = x < 0 ? 0 : x;
+    const int64_t y1 = y < 0 ? 0 : y;
+    new_x[i] = (int32_t)((x1 * width) >> Fixed_point::POSITION_BITS);
+    new_y[i] = (int32_t)((y1 * height) >> Fixed_point::POSITION_BITS);
+  }
+
+  // gather force ops
+  for (uint32_t i = 0; i < count; i++) {
+    ops[i] = _ops->get_op(new_x[i], new_y[i]);
+  }
+
+  // collisions are rare, hence handled per ball
+  for (uint32_t i = 0; i < count; i++) {
+    const uint16_t op = ops[i];
+    if (((new_x[i] != old_x[i]) || new_y[i] || old_y[i]) &&
+        Velocity_op::is_reflection(op) &&
+        !Velocity_op::is_exclusion_zone(op)) {
+      collide(first + i, substep, op, old_x[i], old_y[i], new_x[i]);
+    }
+  }
+
+  // boundaries and acceleration
+  for (uint32_t i = 0; i < count; i++) {
+    const int32_t x = px[i].raw;
+    const int32_t y = py[i].raw;
+    const int32_t abs_vx = vx[i].raw < 0 ? -vx[i].raw : vx[i].raw;
+    const int32_t abs_vy = vy[i].raw < 0 ? -vy[i].raw : vy[i].raw;
+    px[i].raw = x < min_x ? min_x : (x > max_x ? max_x : x);
+    py[i].raw = y < min_y ? min_y : (y > max_y ? max_y : y);
+    vx[i].raw =
+      x < min_x ? abs_vx : (x > max_x ? -abs_vx : vx[i].raw + delta_vx.raw);
+    vy[i].raw =
+      y < min_y ? abs_vy : (y > max_y ? -abs_vy : vy[i].raw + delta_vy.raw);
+#if PHYSICS_DIAGNOSTICS
+    clamp_count[i] +=
+      ((x < min_x) || (x > max_x)) + ((y < min_y) || (y > max_y));
+    const int32_t speed_x = vx[i].raw < 0 ? -vx[i].raw : vx[i].raw;
+    const int32_t speed_y = vy[i].raw < 0 ? -vy[i].raw : vy[i].raw;
+    max_vx[i].raw = speed_x > max_vx[i].raw ? speed_x : max_vx[i].raw;
+    max_vy[i].raw = speed_y > max_vy[i].raw ? speed_y : max_vy[i].raw;
+#endif
+  }
+}
+
+template class Ball_array<double>;
+template class Ball_array<float>;
+template class Ball_array<Fixed_point>;
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
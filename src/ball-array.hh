@@ -0,0 +1,124 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef BALL_ARRAY_HH
+#define BALL_ARRAY_HH
+
+#include <inttypes.h>
+#include <vector>
+#include <fixed-point.hh>
+#include <ball.hh>
+#include <ball-collisions.hh>
+
+/*
+ * Structure-of-arrays storage of the state of many balls that share
+ * the same precomputed forces.  Balls are advanced in blocks: Moving
+ * the balls, gathering their force ops, and applying boundaries and
+ * acceleration are branch-free loops over contiguous, aligned arrays
+ * that the compiler vectorizes; only the rare collisions are handled
+ * per ball.  With T = double, results are identical to stepping Ball
+ * objects.
+ *
+ * The scalar type T of positions and velocities is one of double,
+ * float or Fixed_point.  Ball objects keep their state in double;
+ * it is converted when loading and storing the arrays.
+ */
+template<class T>
+class Ball_array
+{
+public:
+  static const uint16_t BLOCK_SIZE = 64;
+  Ball_array(const uint32_t capacity);
+  virtual ~Ball_array();
+  const uint32_t get_count() const;
+  const bool load(const std::vector<Ball *> *balls);
+  void store(std::vector<Ball *> *balls) const;
+  void step(const uint32_t first, const uint32_t count,
+            const uint32_t substeps, const double pitch, const double roll);
+  void collide_balls(Ball_collisions *ball_collisions);
+private:
+  const uint32_t _capacity;
+  uint32_t _count;
+  T *_px;
+  T *_py;
+  T *_vx;
+  T *_vy;
+  uint32_t *_random_seed;
+  uint32_t *_random_index;
+  uint64_t *_substep_count;
+  double *_mass;
+  double *_radius;
+  double *_contact_dvx;
+  double *_contact_dvy;
+  uint32_t *_boundary_hit_count;
+  uint32_t *_clamp_count;
+  T *_max_vx;
+  T *_max_vy;
+  uint16_t _width;
+  uint16_t _height;
+  T _geometry_correction_x;
+  T _geometry_correction_y;
+  const Narrow_band *_ops;
+  std::vector<double> _collision_px;
+  std::vector<double> _collision_py;
+  std::vector<double> _collision_vx;
+  std::vector<double> _collision_vy;
+  static void *alloc_aligned(const uint32_t count, const size_t size);
+  static const bool is_representable_velocity(const double velocity);
+  static const T from_position(const double position);
+  static const double to_position(const T position);
+  static const T from_velocity(const double velocity);
+  static const double to_velocity(const T velocity);
+  static const T from_coefficient(const double coefficient);
+  void step_block(const uint32_t first, const uint32_t count,
+                  const uint32_t substep,
+                  const T delta_vx, const T delta_vy);
+  void add_wall_contact(const uint32_t index,
+                        const double dvx, const double dvy);
+  void collide(const uint32_t index, const uint32_t substep,
+               const uint16_t op,
+               const int32_t old_x, const int32_t old_y,
+               const int32_t new_x);
+};
+
+/*
+ * Scalar type of the balls' array kernel, selected at compile time
+ * (see PHYSICS_SCALAR in the Makefile).
+ */
+#if defined(PHYSICS_SCALAR_FIXED)
+typedef Fixed_point physics_scalar_t;
+#elif defined(PHYSICS_SCALAR_FLOAT)
+typedef float physics_scalar_t;
+#else
+typedef double physics_scalar_t;
+#endif
+
+#endif /* BALL_ARRAY_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,113 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <ball-collisions.hh>
+#include <cmath>
+#include <log.hh>
+
+Ball_collisions::Ball_collisions()
+{
+  _collision_count = 0;
+}
+
+Ball_collisions::~Ball_collisions()
+{
+  _collision_count = 0;
+}
+
+/*
+ * Positions are given in field coordinates [0, 1] and converted to
+ * pixels of the given playing field extent, where radii are given.
+ * Velocities are isotropic in pixel space (see
+ * Ball::geometry_changed()), hence normals in pixel space apply to
+ * them without conversion.
+ */
+void
+Ball_collisions::resolve(const uint32_t count,
+                         const double *px, const double *py,
+                         double *vx, double *vy,
+                         const double *mass, const double *radius,
+                         const uint16_t width, const uint16_t height)
+{
+  if (count < 2) {
+    return;
+  }
+  _x.resize(count);
+  _y.resize(count);
+  double max_radius = 0.0;
+  for (uint32_t i = 0; i < count; i++) {
+    _x[i] = px[i] * width;
+    _y[i] = py[i] * height;
+    max_radius = radius[i] > max_radius ? radius[i] : max_radius;
+  }
+  if (max_radius <= 0.0) {
+    return;
+  }
+  _spatial_hash.build(_x.data(), _y.data(), count, 2.0 * max_radius);
+  _pairs.clear();
+  _spatial_hash.find_pairs(2.0 * max_radius, &_pairs);
+
+  for (const struct Spatial_hash::pair_t &pair : _pairs) {
+    const uint32_t i = pair.first;
+    const uint32_t j = pair.second;
+    const double delta_x = _x[j] - _x[i];
+    const double delta_y = _y[j] - _y[i];
+    const double distance = sqrt(delta_x * delta_x + delta_y * delta_y);
+    if ((distance >= radius[i] + radius[j]) || (distance <= 0.0)) {
+      continue;
+    }
+    const double normal_x = delta_x / distance;
+    const double normal_y = delta_y / distance;
+    const double approach =
+      (vx[j] - vx[i]) * normal_x + (vy[j] - vy[i]) * normal_y;
+    if (approach >= 0.0) {
+      // already separating
+      continue;
+    }
+    const double total_mass = mass[i] + mass[j];
+    if (total_mass <= 0.0) {
+      Log::fatal("Ball_collisions::resolve(): non-positive mass");
+    }
+    const double impulse_i = 2.0 * mass[j] / total_mass * approach;
+    const double impulse_j = 2.0 * mass[i] / total_mass * approach;
+    vx[i] += impulse_i * normal_x;
+    vy[i] += impulse_i * normal_y;
+    vx[j] -= impulse_j * normal_x;
+    vy[j] -= impulse_j * normal_y;
+    _collision_count++;
+  }
+}
+
+const uint64_t
+Ball_collisions::get_collision_count() const
+{
+  return _collision_count;
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
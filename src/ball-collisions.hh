@@ -0,0 +1,65 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef BALL_COLLISIONS_HH
+#define BALL_COLLISIONS_HH
+
+#include <inttypes.h>
+#include <vector>
+#include <spatial-hash.hh>
+
+/*
+ * Elastic collisions between balls.  Candidate pairs are found with
+ * a spatial hash; pairs that overlap and approach each other exchange
+ * momentum along the line through their centers.  Pairs are resolved
+ * serially in a fixed order, such that the outcome neither depends on
+ * the number of threads nor on the ball storage.
+ */
+class Ball_collisions
+{
+public:
+  Ball_collisions();
+  virtual ~Ball_collisions();
+  void resolve(const uint32_t count,
+               const double *px, const double *py,
+               double *vx, double *vy,
+               const double *mass, const double *radius,
+               const uint16_t width, const uint16_t height);
+  const uint64_t get_collision_count() const;
+private:
+  Spatial_hash _spatial_hash;
+  std::vector<double> _x;
+  std::vector<double> _y;
+  std::vector<struct Spatial_hash::pair_t> _pairs;
+  uint64_t _collision_count;
+};
+
+#endif /* BALL_COLLISIONS_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,143 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <ball-footprint.hh>
+#include <log.hh>
+
+const Ball_footprint
+Ball_footprint::DEFAULT(16, 16, 7, 7, 7);
+
+Ball_footprint::Ball_footprint(const uint16_t width, const uint16_t height,
+                               const uint16_t origin_x,
+                               const uint16_t origin_y,
+                               const uint16_t radius) :
+  _width(width),
+  _height(height),
+  _origin_x(origin_x),
+  _origin_y(origin_y),
+  _radius(radius)
+{
+  if (origin_x >= width) {
+    Log::fatal("Ball_footprint(): origin_x out of range");
+  }
+  if (origin_y >= height) {
+    Log::fatal("Ball_footprint(): origin_y out of range");
+  }
+  create_runs();
+}
+
+Ball_footprint::~Ball_footprint()
+{
+}
+
+const uint16_t
+Ball_footprint::get_width() const
+{
+  return _width;
+}
+
+const uint16_t
+Ball_footprint::get_height() const
+{
+  return _height;
+}
+
+const uint16_t
+Ball_footprint::get_origin_x() const
+{
+  return _origin_x;
+}
+
+const uint16_t
+Ball_footprint::get_origin_y() const
+{
+  return _origin_y;
+}
+
+const uint16_t
+Ball_footprint::get_radius() const
+{
+  return _radius;
+}
+
+const double
+Ball_footprint::get_potential(const uint16_t x, const uint16_t y) const
+{
+  if (x >= _width) {
+    Log::fatal("Ball_footprint::get_potential(): x out of range");
+  }
+  if (y >= _height) {
+    Log::fatal("Ball_footprint::get_potential(): y out of range");
+  }
+  const int16_t dx = x - _origin_x;
+  const int16_t dy = y - _origin_y;
+  const uint32_t r2 = dx * dx + dy * dy;
+  return r2 < ((uint32_t)_radius) * _radius ? 1.0 : 0.0;
+}
+
+void
+Ball_footprint::create_runs()
+{
+  for (uint16_t y = 0; y < _height; y++) {
+    uint16_t x = 0;
+    while (x < _width) {
+      if (get_potential(x, y) > 0.0) {
+        struct run_t run;
+        run.dy = y - _origin_y;
+        run.dx_begin = x - _origin_x;
+        while ((x < _width) && (get_potential(x, y) > 0.0)) {
+          x++;
+        }
+        run.dx_end = x - _origin_x;
+        _runs.push_back(run);
+      } else {
+        x++;
+      }
+    }
+  }
+}
+
+const std::vector<struct Ball_footprint::run_t> *
+Ball_footprint::get_runs() const
+{
+  return &_runs;
+}
+
+const bool
+Ball_footprint::equals(const Ball_footprint *other) const
+{
+  return
+    (_width == other->_width) &&
+    (_height == other->_height) &&
+    (_origin_x == other->_origin_x) &&
+    (_origin_y == other->_origin_y) &&
+    (_radius == other->_radius);
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,80 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef BALL_FOOTPRINT_HH
+#define BALL_FOOTPRINT_HH
+
+#include <inttypes.h>
+#include <vector>
+
+/*
+ * The footprint of a ball is the disc of pixels around the ball's
+ * origin that is considered when computing the forces that walls
+ * apply onto the ball.  Balls with equal footprints share the same
+ * precomputed forces.
+ */
+class Ball_footprint
+{
+public:
+  /*
+   * A horizontal run of footprint pixels with positive potential,
+   * given as offsets relative to the origin: row dy, columns
+   * [dx_begin, dx_end).
+   */
+  struct run_t {
+    int16_t dy;
+    int16_t dx_begin;
+    int16_t dx_end;
+  };
+  static const Ball_footprint DEFAULT;
+  Ball_footprint(const uint16_t width, const uint16_t height,
+                 const uint16_t origin_x, const uint16_t origin_y,
+                 const uint16_t radius);
+  virtual ~Ball_footprint();
+  const uint16_t get_width() const;
+  const uint16_t get_height() const;
+  const uint16_t get_origin_x() const;
+  const uint16_t get_origin_y() const;
+  const uint16_t get_radius() const;
+  const double get_potential(const uint16_t x, const uint16_t y) const;
+  const std::vector<struct run_t> *get_runs() const;
+  const bool equals(const Ball_footprint *other) const;
+private:
+  uint16_t _width;
+  uint16_t _height;
+  uint16_t _origin_x;
+  uint16_t _origin_y;
+  uint16_t _radius;
+  std::vector<struct run_t> _runs;
+  void create_runs();
+};
+
+#endif /* BALL_FOOTPRINT_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
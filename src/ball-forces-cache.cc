@@ -0,0 +1,96 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <ball-forces-cache.hh>
+#include <log.hh>
+
+pthread_mutex_t
+Ball_forces_cache::_lock = PTHREAD_MUTEX_INITIALIZER;
+
+std::vector<struct Ball_forces_cache::entry_t>
+Ball_forces_cache::_entries;
+
+const Ball_forces *
+Ball_forces_cache::acquire(const Force_field *force_field,
+                           const Ball_footprint *footprint)
+{
+  if (!force_field) {
+    Log::fatal("Ball_forces_cache::acquire(): force_field is null");
+  }
+  if (!footprint) {
+    Log::fatal("Ball_forces_cache::acquire(): footprint is null");
+  }
+  const uint32_t generation = force_field->get_generation();
+  pthread_mutex_lock(&_lock);
+  for (struct entry_t &entry : _entries) {
+    if ((entry.forces->get_generation() == generation) &&
+        entry.forces->get_footprint()->equals(footprint)) {
+      entry.ref_count++;
+      pthread_mutex_unlock(&_lock);
+      return entry.forces;
+    }
+  }
+  // Computing the forces while holding the lock ensures that
+  // concurrent requests for the same key compute the forces only
+  // once.
+  struct entry_t entry;
+  entry.forces = new Ball_forces(force_field, footprint);
+  if (!entry.forces) {
+    pthread_mutex_unlock(&_lock);
+    Log::fatal("Ball_forces_cache::acquire(): not enough memory");
+  }
+  entry.ref_count = 1;
+  _entries.push_back(entry);
+  pthread_mutex_unlock(&_lock);
+  return entry.forces;
+}
+
+void
+Ball_forces_cache::release(const Ball_forces *forces)
+{
+  if (!forces) {
+    return;
+  }
+  pthread_mutex_lock(&_lock);
+  for (std::vector<struct entry_t>::iterator it = _entries.begin();
+       it != _entries.end(); it++) {
+    if (it->forces == forces) {
+      if (!--it->ref_count) {
+        delete it->forces;
+        _entries.erase(it);
+      }
+      pthread_mutex_unlock(&_lock);
+      return;
+    }
+  }
+  pthread_mutex_unlock(&_lock);
+  Log::fatal("Ball_forces_cache::release(): forces not in cache");
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,62 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef BALL_FORCES_CACHE_HH
+#define BALL_FORCES_CACHE_HH
+
+#include <pthread.h>
+#include <vector>
+#include <ball-footprint.hh>
+#include <ball-forces.hh>
+#include <force-field.hh>
+
+/*
+ * Reference counted cache of precomputed ball forces, keyed by force
+ * field generation and ball footprint.  All balls with the same
+ * footprint on the same force field thus share a single table that
+ * is computed only once.
+ */
+class Ball_forces_cache
+{
+public:
+  static const Ball_forces *acquire(const Force_field *force_field,
+                                    const Ball_footprint *footprint);
+  static void release(const Ball_forces *forces);
+private:
+  struct entry_t {
+    Ball_forces *forces;
+    uint32_t ref_count;
+  };
+  static pthread_mutex_t _lock;
+  static std::vector<struct entry_t> _entries;
+};
+
+#endif /* BALL_FORCES_CACHE_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
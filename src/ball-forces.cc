@@ -0,0 +1,541 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <ball-forces.hh>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <chrono.hh>
+#include <log.hh>
+#include <op-table-cache.hh>
+#include <worker-pool.hh>
+
+Ball_forces::aggregation_t
+Ball_forces::_default_aggregation = AGGREGATION_SUMMED_AREA;
+
+void
+Ball_forces::set_default_aggregation(const aggregation_t aggregation)
+{
+  _default_aggregation = aggregation;
+}
+
+const Ball_forces::aggregation_t
+Ball_forces::get_default_aggregation()
+{
+  return _default_aggregation;
+}
+
+Ball_forces::Ball_forces(const Force_field *force_field,
+                         const Ball_footprint *footprint,
+                         const aggregation_t aggregation) :
+  _generation(force_field->get_generation()),
+  _footprint(*footprint)
+{
+  Chrono chrono("ball forces");
+  chrono.start();
+
+  _width = force_field->get_width();
+  _height = force_field->get_height();
+  _ops = 0;
+  Op_table_cache *op_table_cache =
+    force_field->get_level_hash() ? Op_table_cache::get_default() : 0;
+  const Op_table_cache::key_t key =
+    Op_table_cache::get_key(force_field->get_level_hash(),
+                            _width, _height, footprint);
+  if (op_table_cache) {
+    _ops = op_table_cache->load(&key);
+  }
+  if (!_ops) {
+    precompute(force_field, aggregation);
+    if (op_table_cache) {
+      op_table_cache->store(&key, _ops);
+    }
+  }
+
+  chrono.stop();
+}
+
+void
+Ball_forces::precompute(const Force_field *force_field,
+                        const aggregation_t aggregation)
+{
+  const uint32_t pixels = ((uint32_t)_width) * _height;
+  _field_ops = force_field->get_ops();
+  _dense_ops = 0;
+  _cos_theta = 0;
+  _sin_theta = 0;
+  _reflections = 0;
+  _exclusions = 0;
+
+  Worker_pool *worker_pool = Worker_pool::get_default();
+  switch (aggregation) {
+  case AGGREGATION_BRUTE_FORCE:
+    {
+      _dense_ops = (uint16_t *)calloc(pixels, sizeof(uint16_t));
+      _cos_theta = (float *)calloc(pixels, sizeof(float));
+      _sin_theta = (float *)calloc(pixels, sizeof(float));
+      _reflections = (float *)calloc(pixels, sizeof(float));
+      _exclusions = (uint8_t *)calloc(pixels, sizeof(uint8_t));
+      if (!_dense_ops ||
+          !_cos_theta || !_sin_theta || !_reflections || !_exclusions) {
+        Log::fatal("Ball_forces::precompute(): not enough memory");
+      }
+      _rows_per_band = BRUTE_FORCE_ROWS_PER_BAND;
+      const uint32_t bands = (_height + _rows_per_band - 1) / _rows_per_band;
+      _phase = PHASE_CHANNELS;
+      worker_pool->run(this, bands);
+      _phase = PHASE_OPS;
+      worker_pool->run(this, bands);
+      free(_cos_theta);
+      _cos_theta = 0;
+      free(_sin_theta);
+      _sin_theta = 0;
+      free(_reflections);
+      _reflections = 0;
+      free(_exclusions);
+      _exclusions = 0;
+      _ops = new Narrow_band(_width, _height, _dense_ops);
+      if (!_ops) {
+        Log::fatal("Ball_forces::precompute(): not enough memory");
+      }
+      free(_dense_ops);
+      _dense_ops = 0;
+    }
+    break;
+  case AGGREGATION_SUMMED_AREA:
+    {
+      _ops = new Narrow_band(_width, _height);
+      if (!_ops) {
+        Log::fatal("Ball_forces::precompute(): not enough memory");
+      }
+      _footprint_dx_min = 0;
+      _footprint_dx_max = 0;
+      for (const struct Ball_footprint::run_t &run : *_footprint.get_runs()) {
+        if (run.dx_begin < _footprint_dx_min) {
+          _footprint_dx_min = run.dx_begin;
+        }
+        if (run.dx_end - 1 > _footprint_dx_max) {
+          _footprint_dx_max = run.dx_end - 1;
+        }
+      }
+      // one band per row of blocks
+      _rows_per_band = Narrow_band::BLOCK_SIZE;
+      const uint32_t bands = _ops->get_block_rows();
+      _phase = PHASE_BLOCKS;
+      worker_pool->run(this, bands);
+      _ops->allocate();
+      _phase = PHASE_SUMMED_AREA_OPS;
+      worker_pool->run(this, bands);
+    }
+    break;
+  default:
+    Log::fatal("Ball_forces::precompute(): unexpected case fall-through");
+  }
+  _field_ops = 0;
+}
+
+Ball_forces::~Ball_forces()
+{
+  delete _ops;
+  _ops = 0;
+  _width = 0;
+  _height = 0;
+}
+
+/*
+ * Opposite tangents within the footprint cancel out.  Then, the
+ * direction of the sum is undefined and, due to rounding, would
+ * depend on the order of summation.  Snapping near-zero components
+ * to zero keeps results independent of the aggregation method.
+ */
+const double
+Ball_forces::average_theta(const double sum_cos, const double sum_sin)
+{
+  const double epsilon = 0.001;
+  return atan2(fabs(sum_sin) < epsilon ? 0.0 : sum_sin,
+               fabs(sum_cos) < epsilon ? 0.0 : sum_cos);
+}
+
+void
+Ball_forces::run_task(const uint32_t index)
+{
+  const uint16_t y0 = index * _rows_per_band;
+  const uint16_t y1 =
+    y0 + _rows_per_band < _height ? y0 + _rows_per_band : _height;
+  switch (_phase) {
+  case PHASE_CHANNELS:
+    load_channels(y0, y1);
+    break;
+  case PHASE_OPS:
+    precompute_forces(y0, y1);
+    break;
+  case PHASE_BLOCKS:
+    classify_blocks(index);
+    break;
+  case PHASE_SUMMED_AREA_OPS:
+    precompute_forces_summed_area(y0, y1);
+    break;
+  default:
+    Log::fatal("Ball_forces::run_task(): unexpected case fall-through");
+  }
+}
+
+/*
+ * Splits the force field's packed ops into separate channels, such
+ * that the footprint aggregation reduces to plain additions of
+ * contiguous rows.
+ */
+void
+Ball_forces::load_channels(const uint16_t y0, const uint16_t y1)
+{
+  uint16_t *field_ops = (uint16_t *)malloc(_width * sizeof(uint16_t));
+  if (!field_ops) {
+    Log::fatal("Ball_forces::load_channels(): not enough memory");
+  }
+  for (uint16_t y = y0; y < y1; y++) {
+    _field_ops->get_row(y, field_ops);
+    for (uint16_t x = 0; x < _width; x++) {
+      const uint32_t i = y * _width + x;
+      const uint16_t op = field_ops[x];
+      if (Velocity_op::is_reflection(op)) {
+        const struct Velocity_op::direction_t *direction =
+          Velocity_op::get_direction(op);
+        _cos_theta[i] = direction->cos_theta;
+        _sin_theta[i] = direction->sin_theta;
+        _reflections[i] = 1.0f;
+      }
+      _exclusions[i] = Velocity_op::is_exclusion_zone(op) ? 1 : 0;
+    }
+  }
+  free(field_ops);
+}
+
+void
+Ball_forces::precompute_forces(const uint16_t y0, const uint16_t y1)
+{
+  // For arithmetically averaging angles, we have to consider them as
+  // 2D coordinates on a circle, and then compute the average point.
+  float *sum_cos = (float *)malloc(_width * sizeof(float));
+  float *sum_sin = (float *)malloc(_width * sizeof(float));
+  float *sum_reflections = (float *)malloc(_width * sizeof(float));
+  uint8_t *any_exclusion = (uint8_t *)malloc(_width * sizeof(uint8_t));
+  if (!sum_cos || !sum_sin || !sum_reflections || !any_exclusion) {
+    Log::fatal("Ball_forces::precompute_forces(): not enough memory");
+  }
+  const std::vector<struct Ball_footprint::run_t> *runs =
+    _footprint.get_runs();
+  for (uint16_t y = y0; y < y1; y++) {
+    memset(sum_cos, 0, _width * sizeof(float));
+    memset(sum_sin, 0, _width * sizeof(float));
+    memset(sum_reflections, 0, _width * sizeof(float));
+    memset(any_exclusion, 0, _width * sizeof(uint8_t));
+    for (const struct Ball_footprint::run_t &run : *runs) {
+      const int32_t field_y = y + run.dy;
+      if ((field_y < 0) || (field_y >= _height)) {
+        continue;
+      }
+      for (int32_t dx = run.dx_begin; dx < run.dx_end; dx++) {
+        // add the field row, shifted by dx, onto the sums, clipped
+        // at the field's left and right border
+        int32_t x0 = -dx;
+        int32_t x1 = _width - dx;
+        x0 = x0 < 0 ? 0 : (x0 > _width ? _width : x0);
+        x1 = x1 < 0 ? 0 : (x1 > _width ? _width : x1);
+        if (x0 >= x1) {
+          // field narrower than the shift
+          continue;
+        }
+        const uint32_t offset = field_y * _width + x0 + dx;
+        const float *cos_theta = _cos_theta + offset;
+        const float *sin_theta = _sin_theta + offset;
+        const float *reflections = _reflections + offset;
+        const uint8_t *exclusions = _exclusions + offset;
+        float *row_cos = sum_cos + x0;
+        float *row_sin = sum_sin + x0;
+        float *row_reflections = sum_reflections + x0;
+        uint8_t *row_exclusion = any_exclusion + x0;
+        for (int32_t i = 0; i < x1 - x0; i++) {
+          row_cos[i] += cos_theta[i];
+          row_sin[i] += sin_theta[i];
+          row_reflections[i] += reflections[i];
+          row_exclusion[i] |= exclusions[i];
+        }
+      }
+    }
+    uint16_t *ops = _dense_ops + y * _width;
+    for (uint16_t x = 0; x < _width; x++) {
+      const bool is_reflection = sum_reflections[x] > 0.0f;
+      const double theta =
+        is_reflection ? average_theta(sum_cos[x], sum_sin[x]) : 0.0;
+      ops[x] = Velocity_op::encode(theta, is_reflection, any_exclusion[x]);
+    }
+  }
+  free(sum_cos);
+  free(sum_sin);
+  free(sum_reflections);
+  free(any_exclusion);
+}
+
+/*
+ * Classifies the blocks of a row of blocks: If all field pixels
+ * that the footprints of a block's pixels cover share the same op
+ * without reflection, then the ops of all of the block's pixels
+ * aggregate to that same op without reflection, since each
+ * footprint covers at least the pixel itself.
+ */
+void
+Ball_forces::classify_blocks(const uint16_t block_y)
+{
+  const std::vector<struct Ball_footprint::run_t> *runs =
+    _footprint.get_runs();
+  if (runs->empty()) {
+    // no footprint => neither reflection nor exclusion zone
+    const uint16_t op = Velocity_op::encode(0.0, false, false);
+    for (uint16_t block_x = 0; block_x < _ops->get_block_columns();
+         block_x++) {
+      _ops->set_uniform(block_x, block_y, op);
+    }
+    return;
+  }
+  const uint8_t bits = Narrow_band::BLOCK_BITS;
+  const int32_t y0 = block_y << bits;
+  const int32_t y1 = (y0 + Narrow_band::BLOCK_SIZE < _height ?
+                      y0 + Narrow_band::BLOCK_SIZE : _height) - 1;
+  // runs are ordered by dy
+  const int32_t field_y0 = y0 + runs->front().dy > 0 ?
+    y0 + runs->front().dy : 0;
+  const int32_t field_y1 = y1 + runs->back().dy < _height - 1 ?
+    y1 + runs->back().dy : _height - 1;
+  for (uint16_t block_x = 0; block_x < _ops->get_block_columns(); block_x++) {
+    const int32_t x0 = block_x << bits;
+    const int32_t x1 = (x0 + Narrow_band::BLOCK_SIZE < _width ?
+                        x0 + Narrow_band::BLOCK_SIZE : _width) - 1;
+    const int32_t field_x0 = x0 + _footprint_dx_min > 0 ?
+      x0 + _footprint_dx_min : 0;
+    const int32_t field_x1 = x1 + _footprint_dx_max < _width - 1 ?
+      x1 + _footprint_dx_max : _width - 1;
+    const uint16_t op =
+      _field_ops->get_uniform_op(field_x0 >> bits, field_y0 >> bits);
+    bool is_uniform = !Velocity_op::is_reflection(op);
+    for (int32_t field_block_y = field_y0 >> bits;
+         (field_block_y <= field_y1 >> bits) && is_uniform; field_block_y++) {
+      for (int32_t field_block_x = field_x0 >> bits;
+           field_block_x <= field_x1 >> bits; field_block_x++) {
+        if (!_field_ops->is_uniform(field_block_x, field_block_y) ||
+            (_field_ops->get_uniform_op(field_block_x, field_block_y) !=
+             op)) {
+          is_uniform = false;
+          break;
+        }
+      }
+    }
+    if (is_uniform) {
+      _ops->set_uniform(block_x, block_y,
+                        Velocity_op::encode(0.0, false,
+                                            Velocity_op::is_exclusion_zone(op)));
+    } else {
+      _ops->set_dense(block_x, block_y);
+    }
+  }
+}
+
+/*
+ * Computes prefix sums of each field row that the footprint touches
+ * for this band of rows, such that the aggregate of a horizontal run
+ * of the footprint is the difference of two prefix sums.  The band
+ * is a row of blocks; only its dense blocks are aggregated.
+ */
+void
+Ball_forces::precompute_forces_summed_area(const uint16_t y0,
+                                           const uint16_t y1)
+{
+  const std::vector<struct Ball_footprint::run_t> *runs =
+    _footprint.get_runs();
+  const uint16_t block_y = y0 >> Narrow_band::BLOCK_BITS;
+  std::vector<uint16_t> dense_blocks;
+  for (uint16_t block_x = 0; block_x < _ops->get_block_columns(); block_x++) {
+    if (!_ops->is_uniform(block_x, block_y)) {
+      dense_blocks.push_back(block_x);
+    }
+  }
+  if (dense_blocks.empty()) {
+    // no walls nearby => nothing to aggregate
+    return;
+  }
+  // runs are ordered by dy
+  const int32_t window_y0 =
+    y0 + runs->front().dy > 0 ? y0 + runs->front().dy : 0;
+  const int32_t window_y1 =
+    y1 + runs->back().dy < _height ? y1 + runs->back().dy : _height;
+  const uint32_t stride = _width + 1;
+  const uint32_t window_size =
+    window_y1 > window_y0 ? (window_y1 - window_y0) * stride : 0;
+  double *prefix_cos = (double *)malloc(window_size * sizeof(double));
+  double *prefix_sin = (double *)malloc(window_size * sizeof(double));
+  uint32_t *prefix_reflections =
+    (uint32_t *)malloc(window_size * sizeof(uint32_t));
+  uint32_t *prefix_exclusions =
+    (uint32_t *)malloc(window_size * sizeof(uint32_t));
+  double *sum_cos = (double *)malloc(_width * sizeof(double));
+  double *sum_sin = (double *)malloc(_width * sizeof(double));
+  uint32_t *sum_reflections = (uint32_t *)malloc(_width * sizeof(uint32_t));
+  uint32_t *sum_exclusions = (uint32_t *)malloc(_width * sizeof(uint32_t));
+  uint16_t *field_ops = (uint16_t *)malloc(_width * sizeof(uint16_t));
+  if ((window_size &&
+       (!prefix_cos || !prefix_sin ||
+        !prefix_reflections || !prefix_exclusions)) ||
+      !sum_cos || !sum_sin || !sum_reflections || !sum_exclusions ||
+      !field_ops) {
+    Log::fatal("Ball_forces::precompute_forces_summed_area(): "
+               "not enough memory");
+  }
+
+  for (int32_t field_y = window_y0; field_y < window_y1; field_y++) {
+    _field_ops->get_row(field_y, field_ops);
+    const uint32_t row = (field_y - window_y0) * stride;
+    double cos_theta = 0.0, sin_theta = 0.0;
+    uint32_t reflections = 0, exclusions = 0;
+    for (uint16_t x = 0; x < _width; x++) {
+      prefix_cos[row + x] = cos_theta;
+      prefix_sin[row + x] = sin_theta;
+      prefix_reflections[row + x] = reflections;
+      prefix_exclusions[row + x] = exclusions;
+      const uint16_t op = field_ops[x];
+      if (Velocity_op::is_reflection(op)) {
+        const struct Velocity_op::direction_t *direction =
+          Velocity_op::get_direction(op);
+        cos_theta += direction->cos_theta;
+        sin_theta += direction->sin_theta;
+        reflections++;
+      }
+      if (Velocity_op::is_exclusion_zone(op)) {
+        exclusions++;
+      }
+    }
+    prefix_cos[row + _width] = cos_theta;
+    prefix_sin[row + _width] = sin_theta;
+    prefix_reflections[row + _width] = reflections;
+    prefix_exclusions[row + _width] = exclusions;
+  }
+
+  for (uint16_t y = y0; y < y1; y++) {
+    memset(sum_cos, 0, _width * sizeof(double));
+    memset(sum_sin, 0, _width * sizeof(double));
+    memset(sum_reflections, 0, _width * sizeof(uint32_t));
+    memset(sum_exclusions, 0, _width * sizeof(uint32_t));
+    for (const struct Ball_footprint::run_t &run : *runs) {
+      const int32_t field_y = y + run.dy;
+      if ((field_y < 0) || (field_y >= _height)) {
+        continue;
+      }
+      const uint32_t row = (field_y - window_y0) * stride;
+      for (const uint16_t block_x : dense_blocks) {
+        const int32_t block_x0 = block_x << Narrow_band::BLOCK_BITS;
+        const int32_t block_x1 = block_x0 + Narrow_band::BLOCK_SIZE < _width ?
+          block_x0 + Narrow_band::BLOCK_SIZE : _width;
+        for (int32_t x = block_x0; x < block_x1; x++) {
+          int32_t x0 = x + run.dx_begin;
+          int32_t x1 = x + run.dx_end;
+          x0 = x0 < 0 ? 0 : (x0 > _width ? _width : x0);
+          x1 = x1 < 0 ? 0 : (x1 > _width ? _width : x1);
+          sum_cos[x] += prefix_cos[row + x1] - prefix_cos[row + x0];
+          sum_sin[x] += prefix_sin[row + x1] - prefix_sin[row + x0];
+          sum_reflections[x] +=
+            prefix_reflections[row + x1] - prefix_reflections[row + x0];
+          sum_exclusions[x] +=
+            prefix_exclusions[row + x1] - prefix_exclusions[row + x0];
+        }
+      }
+    }
+    for (const uint16_t block_x : dense_blocks) {
+      uint16_t *ops = _ops->get_block(block_x, block_y);
+      const uint16_t block_x0 = block_x << Narrow_band::BLOCK_BITS;
+      const uint16_t block_x1 = block_x0 + Narrow_band::BLOCK_SIZE < _width ?
+        block_x0 + Narrow_band::BLOCK_SIZE : _width;
+      for (uint16_t x = block_x0; x < block_x1; x++) {
+        const bool is_reflection = sum_reflections[x] > 0;
+        const double theta =
+          is_reflection ? average_theta(sum_cos[x], sum_sin[x]) : 0.0;
+        ops[Narrow_band::get_block_offset(x, y)] =
+          Velocity_op::encode(theta, is_reflection, sum_exclusions[x] > 0);
+      }
+    }
+  }
+
+  free(prefix_cos);
+  free(prefix_sin);
+  free(prefix_reflections);
+  free(prefix_exclusions);
+  free(sum_cos);
+  free(sum_sin);
+  free(sum_reflections);
+  free(sum_exclusions);
+  free(field_ops);
+}
+
+const uint32_t
+Ball_forces::get_generation() const
+{
+  return _generation;
+}
+
+const Ball_footprint *
+Ball_forces::get_footprint() const
+{
+  return &_footprint;
+}
+
+const uint16_t
+Ball_forces::get_width() const
+{
+  return _width;
+}
+
+const uint16_t
+Ball_forces::get_height() const
+{
+  return _height;
+}
+
+const Narrow_band *
+Ball_forces::get_ops() const
+{
+  return _ops;
+}
+
+const uint16_t
+Ball_forces::get_op(const uint16_t x, const uint16_t y) const
+{
+  if ((x >= _width) || (y >= _height)) {
+    Log::fatal("Ball_forces::get_op(): x or y out of range");
+  }
+  return _ops->get_op(x, y);
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,118 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef BALL_FORCES_HH
+#define BALL_FORCES_HH
+
+#include <inttypes.h>
+#include <ball-footprint.hh>
+#include <force-field.hh>
+#include <velocity-op.hh>
+#include <narrow-band.hh>
+#include <iworker-task.hh>
+
+/*
+ * The forces of a force field, precomputed for a specific ball
+ * footprint: For each pixel, the velocity operation to apply when a
+ * ball with that footprint enters the pixel, packed as specified by
+ * class Velocity_op.  The precomputation runs row by row in bands of
+ * rows that are distributed across the default worker pool.
+ *
+ * Aggregating the footprint either adds up all footprint pixels
+ * (brute force, cost proportional to the footprint's area), or looks
+ * up row-wise prefix sums once per horizontal run of the footprint
+ * (summed area, cost proportional to the footprint's height).
+ *
+ * The ops are kept in narrow-band form (see Narrow_band).  With
+ * summed area aggregation, a block whose pixels' footprints cover
+ * only a single uniform op of the force field is uniform itself and
+ * not aggregated at all, such that precomputing scales with the
+ * walls' perimeter rather than with the field's area.
+ *
+ * If a default op table cache is set (see Op_table_cache), the ops
+ * are mapped from the cache rather than precomputed, if present.
+ */
+class Ball_forces : private IWorker_task
+{
+public:
+  enum aggregation_t {
+    AGGREGATION_BRUTE_FORCE,
+    AGGREGATION_SUMMED_AREA
+  };
+  static void set_default_aggregation(const aggregation_t aggregation);
+  static const aggregation_t get_default_aggregation();
+  Ball_forces(const Force_field *force_field,
+              const Ball_footprint *footprint,
+              const aggregation_t aggregation = get_default_aggregation());
+  virtual ~Ball_forces();
+  const uint32_t get_generation() const;
+  const Ball_footprint *get_footprint() const;
+  const uint16_t get_width() const;
+  const uint16_t get_height() const;
+  const Narrow_band *get_ops() const;
+  const uint16_t get_op(const uint16_t x, const uint16_t y) const;
+private:
+  static const uint16_t BRUTE_FORCE_ROWS_PER_BAND = 8;
+  static aggregation_t _default_aggregation;
+  enum phase_t {
+    PHASE_CHANNELS, PHASE_OPS, PHASE_BLOCKS, PHASE_SUMMED_AREA_OPS
+  };
+  const uint32_t _generation;
+  const Ball_footprint _footprint;
+  uint16_t _width;
+  uint16_t _height;
+  Narrow_band *_ops;
+
+  // per-pixel channels of the force field, only used while
+  // precomputing
+  enum phase_t _phase;
+  uint16_t _rows_per_band;
+  const Narrow_band *_field_ops;
+  uint16_t *_dense_ops;
+  int32_t _footprint_dx_min;
+  int32_t _footprint_dx_max;
+  float *_cos_theta;
+  float *_sin_theta;
+  float *_reflections;
+  uint8_t *_exclusions;
+
+  static const double average_theta(const double sum_cos,
+                                    const double sum_sin);
+  void precompute(const Force_field *force_field,
+                  const aggregation_t aggregation);
+  virtual void run_task(const uint32_t index);
+  void load_channels(const uint16_t y0, const uint16_t y1);
+  void precompute_forces(const uint16_t y0, const uint16_t y1);
+  void classify_blocks(const uint16_t block_y);
+  void precompute_forces_summed_area(const uint16_t y0, const uint16_t y1);
+};
+
+#endif /* BALL_FORCES_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -23,54 +23,48 @@
  */
 
 #include <ball.hh>
+#include <cmath>
+#include <cstdlib>
+#include <ball-forces-cache.hh>
 #include <log.hh>
-#include <chrono.hh>
-
-#define HAVE_SENSE_HAT 0
 
 // TODO: Deploy z coordinates to consider position energy.
 // -jr 2016-02-01
 
-/*const*/ QPixmap *
-Ball::DEFAULT_PIXMAP = 0;
-
-const uint16_t
-Ball::DEFAULT_PIXMAP_WIDTH = 16;
-
-const uint16_t
-Ball::DEFAULT_PIXMAP_HEIGHT = 16;
-
-const uint16_t
-Ball::DEFAULT_PIXMAP_ORIGIN_X = 7;
-
-const uint16_t
-Ball::DEFAULT_PIXMAP_ORIGIN_Y = 7;
-
 Ball::Ball(const double px, const double py,
            const double vx, const double vy,
-           const double mass) :
-  _mass(mass)
+           const double mass, const uint32_t random_seed,
+           const uint32_t random_index) :
+  _mass(mass),
+  _footprint(&Ball_footprint::DEFAULT)
 {
   _position = new Point_3D(px, py, 0.0);
   if (!_position) {
     Log::fatal("Ball(): not enough memory");
   }
+  _previous_position = new Point_3D(px, py, 0.0);
+  if (!_previous_position) {
+    Log::fatal("Ball(): not enough memory");
+  }
   _velocity = new Point_3D(vx, vy, 0.0);
   if (!_velocity) {
     Log::fatal("Ball(): not enough memory");
   }
 
-  // Qt: Must construct a QGuiApplication before a QPixmap
-  // => need lazy initialization of DEFAULT_PIXMAP.
-  if (!DEFAULT_PIXMAP) {
-    DEFAULT_PIXMAP = create_default_pixmap();
-  }
-
-  _pixmap = DEFAULT_PIXMAP;
   _is_in_goal = false;
-  _max_vx = 0.0;
-  _max_vy = 0.0;
-
+  _is_in_exclusion_zone = false;
+  _contact_dvx = 0.0;
+  _contact_dvy = 0.0;
+  // random numbers are keyed by seed, ball index and substep, such
+  // that the outcome does not depend on the order in which balls and
+  // substeps are computed
+  _random_seed = random_seed;
+  _random_index = random_index;
+  _substep_count = 0;
+  _iteration_count = 0;
+  reset_stats();
+
+  _forces = 0;
   _op_force_field = 0;
   _force_field_width = 0;
   _force_field_height = 0;
@@ -82,27 +76,48 @@ Ball::~Ball()
 {
   delete _position;
   _position = 0;
+  delete _previous_position;
+  _previous_position = 0;
   delete _velocity;
   _velocity = 0;
   //_mass = 0.0;
   _is_in_goal = false;
-  _max_vx = 0.0;
-  _max_vy = 0.0;
+  _is_in_exclusion_zone = false;
+  _contact_dvx = 0.0;
+  _contact_dvy = 0.0;
 
-  if (_op_force_field) {
-    delete [] _op_force_field;
-    _op_force_field = 0;
-  }
+  Ball_forces_cache::release(_forces);
+  _forces = 0;
+  _op_force_field = 0;
   _force_field_width = 0;
   _force_field_height = 0;
   _playing_field_width = 0;
   _playing_field_height = 0;
 }
 
-const double MIN_X = 0.000;
-const double MAX_X = 0.999;
-const double MIN_Y = 0.000;
-const double MAX_Y = 0.999;
+const double
+Ball::MIN_X = 0.000;
+
+const double
+Ball::MAX_X = 0.999;
+
+const double
+Ball::MIN_Y = 0.000;
+
+const double
+Ball::MAX_Y = 0.999;
+
+const double
+Ball::PITCH_ACCELERATION = 0.0000000003;
+
+const double
+Ball::ROLL_ACCELERATION = 0.0000000002;
+
+const uint16_t
+Ball::MAX_SWEEP_COLLISIONS = 64;
+
+const double
+Ball::SWEEP_EPSILON = 0.000001;
 
 void
 Ball::geometry_changed(const uint16_t width, const uint16_t height)
@@ -121,99 +136,16 @@ Ball::geometry_changed(const uint16_t width, const uint16_t height)
   }
 }
 
-/*const*/ QPixmap *
-Ball::create_default_pixmap()
-{
-  /*const*/ QPixmap *pixmap = new QPixmap("ball.png");
-  if (!pixmap) {
-    Log::fatal("Ball::create_default_pixmap(): not enough memory");
-  }
-  return pixmap;
-}
-
-void
-Ball::precompute_forces(const uint16_t x,
-                        const uint16_t y,
-                        const Force_field *force_field)
-{
-  const uint32_t ff0 = y * _force_field_width + x;
-  struct velocity_op_t *ball_op = &_op_force_field[ff0];
-  uint16_t reflection_count = 0;
-  // For arithmetically averaging angles, we have to consider them as
-  // 2D coordinates on a circle, and then compute the average point.
-  double theta_x = 0.0, theta_y = 0.0;
-  int16_t ball_y = y - get_pixmap_origin_y();
-  for (uint8_t pixmap_y = 0; pixmap_y < get_pixmap_height(); pixmap_y++) {
-    if ((ball_y >= 0) && (ball_y < _force_field_height)) {
-      int16_t ball_x = x - get_pixmap_origin_x();
-      for (uint8_t pixmap_x = 0; pixmap_x < get_pixmap_width(); pixmap_x++) {
-        if ((ball_x >= 0) && (ball_x < _force_field_width)) {
-          if (get_potential(pixmap_x, pixmap_y) > 0.0) {
-            //std::cout << "y";
-            ball_op->is_exclusion_zone |=
-              force_field->is_exclusion_zone(ball_x, ball_y);
-            if (force_field->is_reflection(ball_x, ball_y)) {
-              reflection_count++;
-              double theta = force_field->get_theta(ball_x, ball_y);
-              theta_x += cos(theta);
-              theta_y += sin(theta);
-            }
-          } else {
-            //std::cout << "n";
-          }
-        }
-        ball_x++;
-      }
-    }
-    ball_y++;
-  }
-  if (reflection_count > 0) {
-    const double theta = atan2(theta_y, theta_x);
-    ball_op->theta = theta;
-    ball_op->m00 = 1.0 * -cos(2.0 * theta);
-    ball_op->m01 = 1.0 * +sin(2.0 * theta);
-    ball_op->m10 = 1.0 * +sin(2.0 * theta);
-    ball_op->m11 = 1.0 * +cos(2.0 * theta);
-    ball_op->is_reflection = true;
-  } else {
-    ball_op->theta = 0.0;
-    ball_op->m00 = 1.0;
-    ball_op->m01 = 0.0;
-    ball_op->m10 = 0.0;
-    ball_op->m11 = 1.0;
-    ball_op->is_reflection = false;
-  }
-}
-
 void
 Ball::precompute_forces(const Force_field *force_field)
 {
-  Chrono chrono("ball forces");
-  chrono.start();
-
-  if (_op_force_field) {
-    delete [] _op_force_field;
-    _op_force_field = 0;
-    _force_field_width = 0;
-    _force_field_height = 0;
-  }
-
-  _force_field_width = force_field->get_width();
-  _force_field_height = force_field->get_height();
-  _op_force_field = (struct velocity_op_t *)
-    calloc(_force_field_width * _force_field_height,
-           sizeof(struct velocity_op_t));
-  if (!_op_force_field) {
-    Log::fatal("Force_field::load_field(): not enough memory");
-  }
-
-  for (uint16_t x = 0; x < _force_field_width; x++) {
-    for (uint16_t y = 0; y < _force_field_height; y++) {
-      precompute_forces(x, y, force_field);
-    }
-  }
-
-  chrono.stop();
+  const Ball_forces *forces =
+    Ball_forces_cache::acquire(force_field, _footprint);
+  Ball_forces_cache::release(_forces);
+  _forces = forces;
+  _op_force_field = forces->get_ops();
+  _force_field_width = forces->get_width();
+  _force_field_height = forces->get_height();
 }
 
 const double
@@ -223,37 +155,37 @@ Ball::abs(const double x)
 }
 
 const bool
-Ball::update_velocity(const struct velocity_op_t velocity_op,
+Ball::update_velocity(const uint16_t velocity_op,
                       Point_3D *velocity) const
 {
+  if (!Velocity_op::is_reflection(velocity_op)) {
+    return false;
+  }
+  const struct Velocity_op::reflection_t *reflection =
+    Velocity_op::get_reflection(velocity_op);
   double *vx = velocity->get_rx();
   double *vy = velocity->get_ry();
 
-  const double new_vx = velocity_op.m00 * (*vx) + velocity_op.m01 * (*vy);
-  if ((new_vx < -1.0) || (new_vx > 1.0) ||
-      std::isnan(new_vx) || std::isinf(new_vx)) {
-    std::stringstream msg;
-    msg << "new_vx=" << new_vx;
-    Log::debug(msg.str());
-    Log::fatal("Ball::update_velocity(): new_vx out of range");
+  const double new_vx =
+    -reflection->cos_2theta * (*vx) + reflection->sin_2theta * (*vy);
+  const double new_vy =
+    reflection->sin_2theta * (*vx) + reflection->cos_2theta * (*vy);
+#if PHYSICS_DIAGNOSTICS
+  if (!(abs(new_vx) <= 1.0)) {
+    velocity_out_of_range("Ball::update_velocity()", "new_vx", new_vx);
   }
-
-  const double new_vy = velocity_op.m10 * (*vx) + velocity_op.m11 * (*vy);
-  if ((new_vy < -1.0) || (new_vy > 1.0) ||
-      std::isnan(new_vy) || std::isinf(new_vy)) {
-    std::stringstream msg;
-    msg << "new_vy=" << new_vy;
-    Log::debug(msg.str());
-    Log::fatal("Ball::update_velocity(): new_vy out of range");
+  if (!(abs(new_vy) <= 1.0)) {
+    velocity_out_of_range("Ball::update_velocity()", "new_vy", new_vy);
   }
+#endif
 
   *vx = new_vx;
   *vy = new_vy;
-  return velocity_op.is_reflection;
+  return true;
 }
 
 void
-Ball::update(const Sensors *sensors)
+Ball::update(const ISensors *sensors)
 {
   if (!_playing_field_width || !_playing_field_height) {
     Log::fatal("Ball::update(): playing field has empty extent");
@@ -262,18 +194,15 @@ Ball::update(const Sensors *sensors)
     Log::fatal("Ball::update(): sensors is null");
   }
 
-#if HAVE_SENSE_HAT
-  double pitch = sensors->get_pitch();
-  double roll = sensors->get_roll();
-#else
-  double pitch = 0.0;
-  double roll = 0.0;
-#endif
+  const double pitch = sensors->get_pitch();
+  const double roll = sensors->get_roll();
 
   double *px = _position->get_rx();
   double *py = _position->get_ry();
   double *vx = _velocity->get_rx();
   double *vy = _velocity->get_ry();
+  _iteration_count++;
+  const uint64_t substep = _substep_count++;
 
   double old_px = *px;
   double old_py = *py;
@@ -283,23 +212,19 @@ Ball::update(const Sensors *sensors)
   *px += *vx * _geometry_correction_x;
   *py += *vy * _geometry_correction_y;
 
-  if (*px < MIN_X) {
-    Log::error("px < MIN");
-    *px -= *vx;
-    *vx = -*vx;
-  } else if (*px > MAX_X) {
-    Log::error("px > MAX");
+  if ((*px < MIN_X) || (*px > MAX_X)) {
     *px -= *vx;
     *vx = -*vx;
+#if PHYSICS_DIAGNOSTICS
+    _stats.boundary_hit_count++;
+#endif
   }
-  if (*py < MIN_Y) {
-    Log::error("py < MIN");
-    *py -= *vy;
-    *vy = -*vy;
-  } else if (*py > MAX_Y) {
-    Log::error("py > MAX");
+  if ((*py < MIN_Y) || (*py > MAX_Y)) {
     *py -= *vy;
     *vy = -*vy;
+#if PHYSICS_DIAGNOSTICS
+    _stats.boundary_hit_count++;
+#endif
   }
 
   double new_px = *px;
@@ -307,13 +232,16 @@ Ball::update(const Sensors *sensors)
   uint16_t new_x = (uint16_t)(new_px * _playing_field_width);
   uint16_t new_y = (uint16_t)(new_py * _playing_field_height);
 
-  const struct velocity_op_t velocity_op =
-    _op_force_field[new_y * _force_field_width + new_x];
+  const uint16_t velocity_op = _op_force_field->get_op(new_x, new_y);
 
   if ((new_x != old_x) || (new_y || old_y)) {
     // new position in force field => test for collision
-    if (!velocity_op.is_exclusion_zone) {
+    if (!Velocity_op::is_exclusion_zone(velocity_op)) {
+      const double previous_vx = *vx;
+      const double previous_vy = *vy;
       if (update_velocity(velocity_op, _velocity)) {
+        add_wall_contact(*vx - previous_vx, *vy - previous_vy);
+
         // collision => continue with previous position, but with
         // updated velocity
 
@@ -321,7 +249,9 @@ Ball::update(const Sensors *sensors)
         // one direction (px or py)) in order to avoid infinitive
         // loops due to rounding errors on the edge between adjacent
         // pixels.
-        const double alpha = 0.45 + 0.1 * ((double)rand() / RAND_MAX);
+        const double alpha =
+          0.45 + 0.1 * Counter_rng::get_uniform(_random_seed, _random_index,
+                                                substep);
         if (new_x != old_x) {
           *px = (old_x + alpha) / _playing_field_width;
         } else {
@@ -331,6 +261,11 @@ Ball::update(const Sensors *sensors)
     }
   }
 
+#if PHYSICS_DIAGNOSTICS
+  _stats.clamp_count +=
+    ((*px < MIN_X) || (*px > MAX_X)) + ((*py < MIN_Y) || (*py > MAX_Y));
+#endif
+
   if (*px < MIN_X) {
     *px = MIN_X;
     *vx = +abs(*vx);
@@ -338,13 +273,7 @@ Ball::update(const Sensors *sensors)
     *px = MAX_X;
     *vx = -abs(*vx);
   } else {
-    *vx += 0.0000000003 * pitch;
-    if (abs(*vx) > _max_vx) {
-      _max_vx = abs(*vx);
-      std::stringstream msg;
-      msg << "_max_vx=" << _max_vx;
-      Log::debug(msg.str());
-    }
+    *vx += PITCH_ACCELERATION * pitch;
   }
 
   if (*py < MIN_Y) {
@@ -354,56 +283,355 @@ Ball::update(const Sensors *sensors)
     *py = MAX_Y;
     *vy = -abs(*vy);
   } else {
-    *vy += 0.0000000002 * roll;
-    if (abs(*vy) > _max_vy) {
-      _max_vy = abs(*vy);
-      std::stringstream msg;
-      msg << "_max_vy=" << _max_vy;
-      Log::debug(msg.str());
+    *vy += ROLL_ACCELERATION * roll;
+  }
+
+#if PHYSICS_DIAGNOSTICS
+  _stats.max_vx = abs(*vx) > _stats.max_vx ? abs(*vx) : _stats.max_vx;
+  _stats.max_vy = abs(*vy) > _stats.max_vy ? abs(*vy) : _stats.max_vy;
+#endif
+}
+
+/*
+ * Continuous alternative to calling update() substeps times: Moves
+ * the ball along its velocity vector in one go, traversing all
+ * pixels on the way, and stops at the time of impact when entering a
+ * reflecting pixel.  There, the ball is placed on the border of the
+ * previous pixel and continues with the reflected velocity for the
+ * remaining time.  Acceleration is applied half before and half
+ * after the movement.  A ball that collides more often than
+ * MAX_SWEEP_COLLISIONS within a single sweep, e.g. when trapped in a
+ * corner, rests for the remaining time.
+ */
+void
+Ball::sweep(const ISensors *sensors, const uint32_t substeps)
+{
+  if (!_playing_field_width || !_playing_field_height) {
+    Log::fatal("Ball::sweep(): playing field has empty extent");
+  }
+  if (!sensors) {
+    Log::fatal("Ball::sweep(): sensors is null");
+  }
+
+  const double pitch = sensors->get_pitch();
+  const double roll = sensors->get_roll();
+  double *vx = _velocity->get_rx();
+  double *vy = _velocity->get_ry();
+  *vx += 0.5 * substeps * PITCH_ACCELERATION * pitch;
+  *vy += 0.5 * substeps * ROLL_ACCELERATION * roll;
+
+  // pixel coordinates
+  const double width = _playing_field_width;
+  const double height = _playing_field_height;
+  double x = _position->get_x() * width;
+  double y = _position->get_y() * height;
+  const double min_x = MIN_X * width;
+  const double max_x = MAX_X * width;
+  const double min_y = MIN_Y * height;
+  const double max_y = MAX_Y * height;
+
+  double remaining = substeps;
+  uint16_t collisions = 0;
+  while ((remaining > 0.0) && (collisions < MAX_SWEEP_COLLISIONS)) {
+    _iteration_count++;
+    // pixels per substep
+    const double dx = *vx * _geometry_correction_x * width;
+    const double dy = *vy * _geometry_correction_y * height;
+    int32_t cell_x = (int32_t)x;
+    int32_t cell_y = (int32_t)y;
+    const int32_t step_x = dx > 0.0 ? 1 : -1;
+    const int32_t step_y = dy > 0.0 ? 1 : -1;
+    double t_next_x =
+      dx != 0.0 ? ((dx > 0.0 ? cell_x + 1 : cell_x) - x) / dx : INFINITY;
+    double t_next_y =
+      dy != 0.0 ? ((dy > 0.0 ? cell_y + 1 : cell_y) - y) / dy : INFINITY;
+    const double t_delta_x = dx != 0.0 ? fabs(1.0 / dx) : INFINITY;
+    const double t_delta_y = dy != 0.0 ? fabs(1.0 / dy) : INFINITY;
+    const double t_border_x =
+      dx > 0.0 ? (max_x - x) / dx : (dx < 0.0 ? (min_x - x) / dx : INFINITY);
+    const double t_border_y =
+      dy > 0.0 ? (max_y - y) / dy : (dy < 0.0 ? (min_y - y) / dy : INFINITY);
+    const double t_border = t_border_x < t_border_y ? t_border_x : t_border_y;
+
+    double t;
+    bool is_collision = false;
+    while (true) {
+      const double t_cell = t_next_x < t_next_y ? t_next_x : t_next_y;
+      if ((t_border <= t_cell) && (t_border <= remaining)) {
+        // playing field border
+        t = t_border > 0.0 ? t_border : 0.0;
+        x += t * dx;
+        y += t * dy;
+        if (t_border_x <= t_border_y) {
+          *vx = -*vx;
+        } else {
+          *vy = -*vy;
+        }
+        is_collision = true;
+        break;
+      }
+      if (t_cell > remaining) {
+        t = remaining;
+        x += t * dx;
+        y += t * dy;
+        break;
+      }
+      t = t_cell;
+      const bool is_step_x = t_next_x < t_next_y;
+      if (is_step_x) {
+        cell_x += step_x;
+        t_next_x += t_delta_x;
+      } else {
+        cell_y += step_y;
+        t_next_y += t_delta_y;
+      }
+      const uint16_t op = _op_force_field->get_op(cell_x, cell_y);
+      if (Velocity_op::is_reflection(op) &&
+          !Velocity_op::is_exclusion_zone(op)) {
+        // time of impact: stay just inside the previous pixel
+        x += t * dx;
+        y += t * dy;
+        if (is_step_x) {
+          x = step_x > 0 ? cell_x - SWEEP_EPSILON : cell_x + 1 + SWEEP_EPSILON;
+        } else {
+          y = step_y > 0 ? cell_y - SWEEP_EPSILON : cell_y + 1 + SWEEP_EPSILON;
+        }
+        const double previous_vx = *vx;
+        const double previous_vy = *vy;
+        update_velocity(op, _velocity);
+        // the wall's tangent may be oblique to the pixel border that
+        // has been crossed; make sure not to re-enter the pixel
+        if (is_step_x && (*vx * step_x > 0.0)) {
+          *vx = -*vx;
+        } else if (!is_step_x && (*vy * step_y > 0.0)) {
+          *vy = -*vy;
+        }
+        add_wall_contact(*vx - previous_vx, *vy - previous_vy);
+        is_collision = true;
+        break;
+      }
+    }
+    remaining -= t;
+    if (is_collision) {
+      collisions++;
+    }
+  }
+
+  x = x < min_x ? min_x : (x > max_x ? max_x : x);
+  y = y < min_y ? min_y : (y > max_y ? max_y : y);
+  set_position(x / width, y / height);
+  _substep_count += substeps;
+  *vx += 0.5 * substeps * PITCH_ACCELERATION * pitch;
+  *vy += 0.5 * substeps * ROLL_ACCELERATION * roll;
+}
+
+/*
+ * Equivalent to calling update() substeps times, but as long as the
+ * distance field guarantees that the ball can not touch any wall
+ * within the next substeps, these are merged into a single step.
+ * Hence, balls in open space advance in a few steps, while balls
+ * close to walls fall back to single substeps.
+ */
+void
+Ball::update_adaptive(const ISensors *sensors, const uint32_t substeps,
+                      const Distance_field *distance_field)
+{
+  if (!distance_field) {
+    Log::fatal("Ball::update_adaptive(): distance_field is null");
+  }
+  if (!_playing_field_width || !_playing_field_height) {
+    Log::fatal("Ball::update_adaptive(): playing field has empty extent");
+  }
+  if (!sensors) {
+    Log::fatal("Ball::update_adaptive(): sensors is null");
+  }
+
+  const double pitch = sensors->get_pitch();
+  const double roll = sensors->get_roll();
+  const double ax = PITCH_ACCELERATION * pitch;
+  const double ay = ROLL_ACCELERATION * roll;
+  const double width = _playing_field_width;
+  const double height = _playing_field_height;
+  // Pixels of the ball's footprint reach up to the footprint's
+  // radius from the ball's center, and reflecting pixels extend up to
+  // two pixels beyond exclusion zones.
+  const double margin = _footprint->get_radius() + 3.0;
+  double *px = _position->get_rx();
+  double *py = _position->get_ry();
+  double *vx = _velocity->get_rx();
+  double *vy = _velocity->get_ry();
+
+  uint32_t remaining = substeps;
+  while (remaining > 0) {
+    const uint16_t x = (uint16_t)(*px * width);
+    const uint16_t y = (uint16_t)(*py * height);
+    const double free_distance = distance_field->get_distance(x, y) - margin;
+    uint32_t n = 0;
+    if (free_distance > 0.0) {
+      // upper bound of the speed in pixels per substep until the end
+      // of this update
+      const double speed_x =
+        (fabs(*vx) + remaining * fabs(ax)) * _geometry_correction_x * width;
+      const double speed_y =
+        (fabs(*vy) + remaining * fabs(ay)) * _geometry_correction_y * height;
+      const double speed = sqrt(speed_x * speed_x + speed_y * speed_y);
+      n = speed > 0.0 ? (uint32_t)(free_distance / speed) : remaining;
+      n = n < remaining ? n : remaining;
+    }
+    if (n > 1) {
+      // n substeps of uniform acceleration in closed form: move with
+      // the current velocity, then accelerate, n times
+      const double steps = n;
+      const double offsets = 0.5 * steps * (steps - 1.0);
+      *px += (steps * *vx + offsets * ax) * _geometry_correction_x;
+      *py += (steps * *vy + offsets * ay) * _geometry_correction_y;
+      *vx += steps * ax;
+      *vy += steps * ay;
+      remaining -= n;
+      _iteration_count++;
+      _substep_count += n;
+    } else {
+      update(sensors);
+      remaining--;
     }
   }
 }
 
+const uint64_t
+Ball::get_iteration_count() const
+{
+  return _iteration_count;
+}
+
 const Point_3D *
 Ball::get_position() const
 {
   return _position;
 }
 
+/*
+ * Returns the position as of the last call of save_position(), such
+ * that renderers can interpolate between the last two steps.
+ */
+const Point_3D *
+Ball::get_previous_position() const
+{
+  return _previous_position;
+}
+
+void
+Ball::save_position()
+{
+  *_previous_position->get_rx() = _position->get_x();
+  *_previous_position->get_ry() = _position->get_y();
+}
+
 const Point_3D *
 Ball::get_velocity() const
 {
   return _velocity;
 }
 
-const QPixmap *
-Ball::get_pixmap() const
+void
+Ball::set_position(const double px, const double py)
+{
+  *_position->get_rx() = px;
+  *_position->get_ry() = py;
+}
+
+void
+Ball::set_velocity(const double vx, const double vy)
 {
-  return _pixmap;
+  *_velocity->get_rx() = vx;
+  *_velocity->get_ry() = vy;
+}
+
+const double
+Ball::get_geometry_correction_x() const
+{
+  return _geometry_correction_x;
+}
+
+const double
+Ball::get_geometry_correction_y() const
+{
+  return _geometry_correction_y;
+}
+
+const uint32_t
+Ball::get_random_seed() const
+{
+  return _random_seed;
+}
+
+void
+Ball::set_random_seed(const uint32_t random_seed)
+{
+  _random_seed = random_seed;
+}
+
+const uint32_t
+Ball::get_random_index() const
+{
+  return _random_index;
+}
+
+/*
+ * Returns the number of substeps that the ball has been advanced,
+ * which serves as counter for the ball's random numbers.
+ */
+const uint64_t
+Ball::get_substep_count() const
+{
+  return _substep_count;
+}
+
+void
+Ball::set_substep_count(const uint64_t substep_count)
+{
+  _substep_count = substep_count;
+}
+
+const Ball_forces *
+Ball::get_forces() const
+{
+  return _forces;
+}
+
+const double
+Ball::get_mass() const
+{
+  return _mass;
+}
+
+const uint16_t
+Ball::get_radius() const
+{
+  return _footprint->get_radius();
 }
 
 const uint16_t
 Ball::get_pixmap_width() const
 {
-  return DEFAULT_PIXMAP_WIDTH;
+  return _footprint->get_width();
 }
 
 const uint16_t
 Ball::get_pixmap_height() const
 {
-  return DEFAULT_PIXMAP_HEIGHT;
+  return _footprint->get_height();
 }
 
 const uint16_t
 Ball::get_pixmap_origin_x() const
 {
-  return DEFAULT_PIXMAP_ORIGIN_X;
+  return _footprint->get_origin_x();
 }
 
 const uint16_t
 Ball::get_pixmap_origin_y() const
 {
-  return DEFAULT_PIXMAP_ORIGIN_Y;
+  return _footprint->get_origin_y();
 }
 
 const bool
@@ -413,18 +641,9 @@ Ball::get_is_in_goal() const
 }
 
 const double
-Ball::get_potential(const uint16_t x, const uint16_t y)
+Ball::get_potential(const uint16_t x, const uint16_t y) const
 {
-  if (x >= get_pixmap_width()) {
-    Log::fatal("Ball::get_potential(): x out of range");
-  }
-  if (y >= get_pixmap_height()) {
-    Log::fatal("Ball::get_potential(): y out of range");
-  }
-  const int8_t dx = x - get_pixmap_origin_x();
-  const int8_t dy = y - get_pixmap_origin_y();
-  const uint16_t r2 = dx * dx + dy * dy;
-  return r2 < 49 ? 1.0 : 0.0;
+  return _footprint->get_potential(x, y);
 }
 
 void
@@ -433,6 +652,124 @@ Ball::set_is_in_goal(const bool is_in_goal)
   _is_in_goal = is_in_goal;
 }
 
+/*
+ * Merges other into stats, i.e. takes the maximum speeds and sums
+ * up the counts.
+ */
+void
+Ball::merge_stats(stats_t *stats, const stats_t *other)
+{
+  stats->max_vx = other->max_vx > stats->max_vx ? other->max_vx : stats->max_vx;
+  stats->max_vy = other->max_vy > stats->max_vy ? other->max_vy : stats->max_vy;
+  stats->boundary_hit_count += other->boundary_hit_count;
+  stats->clamp_count += other->clamp_count;
+}
+
+/*
+ * Reports a velocity that is out of range or not a number, and
+ * terminates.  Kept out of line, such that formatting the message
+ * does not bloat the hot paths that check velocities.
+ */
+void
+Ball::velocity_out_of_range(const char *where, const char *name,
+                            const double velocity)
+{
+  std::stringstream msg;
+  msg << where << ": " << name << " out of range: " << velocity;
+  Log::fatal(msg.str());
+}
+
+/*
+ * Returns the statistics collected while stepping, i.e. the maximum
+ * speeds, the number of moves beyond the playing field's border
+ * (boundary hits), and the number of positions clamped to the
+ * border.  Without PHYSICS_DIAGNOSTICS, all statistics remain 0.
+ */
+const Ball::stats_t *
+Ball::get_stats() const
+{
+  return &_stats;
+}
+
+void
+Ball::add_stats(const stats_t *stats)
+{
+  merge_stats(&_stats, stats);
+}
+
+void
+Ball::reset_stats()
+{
+  _stats.max_vx = 0.0;
+  _stats.max_vy = 0.0;
+  _stats.boundary_hit_count = 0;
+  _stats.clamp_count = 0;
+}
+
+const bool
+Ball::get_is_in_exclusion_zone() const
+{
+  return _is_in_exclusion_zone;
+}
+
+void
+Ball::set_is_in_exclusion_zone(const bool is_in_exclusion_zone)
+{
+  _is_in_exclusion_zone = is_in_exclusion_zone;
+}
+
+/*
+ * Returns true, if the ball's center currently is on a pixel of an
+ * exclusion zone, i.e. inside a wall.
+ */
+const bool
+Ball::is_position_in_exclusion_zone() const
+{
+  if (!_op_force_field) {
+    return false;
+  }
+  const uint16_t x = (uint16_t)(_position->get_x() * _playing_field_width);
+  const uint16_t y = (uint16_t)(_position->get_y() * _playing_field_height);
+  if ((x >= _force_field_width) || (y >= _force_field_height)) {
+    return false;
+  }
+  return
+    Velocity_op::is_exclusion_zone(_op_force_field->get_op(x, y));
+}
+
+/*
+ * Records a reflection at a wall by its change of velocity.  Of all
+ * contacts until the next call of take_wall_contact(), only the
+ * strongest one is kept, such that recording never allocates.
+ */
+void
+Ball::add_wall_contact(const double dvx, const double dvy)
+{
+  if (dvx * dvx + dvy * dvy >
+      _contact_dvx * _contact_dvx + _contact_dvy * _contact_dvy) {
+    _contact_dvx = dvx;
+    _contact_dvy = dvy;
+  }
+}
+
+/*
+ * Returns the change of velocity of the strongest wall contact since
+ * the previous call, and clears it.  Returns false, if there has
+ * been no contact.
+ */
+const bool
+Ball::take_wall_contact(double *dvx, double *dvy)
+{
+  if ((_contact_dvx == 0.0) && (_contact_dvy == 0.0)) {
+    return false;
+  }
+  *dvx = _contact_dvx;
+  *dvy = _contact_dvy;
+  _contact_dvx = 0.0;
+  _contact_dvy = 0.0;
+  return true;
+}
+
 // DEBUG
 const double
 Ball::get_theta(const uint16_t x, const uint16_t y) const
@@ -440,7 +777,7 @@ Ball::get_theta(const uint16_t x, const uint16_t y) const
   if ((x >= _force_field_width) || (y >= _force_field_height)) {
     Log::fatal("Ball::get_theta(): x or y out of range");
   }
-  return _op_force_field[y * _force_field_width + x].theta;
+  return Velocity_op::get_theta(_op_force_field->get_op(x, y));
 }
 
 // DEBUG
@@ -450,7 +787,8 @@ Ball::is_reflection(const uint16_t x, const uint16_t y) const
   if ((x >= _force_field_width) || (y >= _force_field_height)) {
     Log::fatal("Ball::is_reflection(): x or y out of range");
   }
-  return _op_force_field[y * _force_field_width + x].is_reflection;
+  return
+    Velocity_op::is_reflection(_op_force_field->get_op(x, y));
 }
 
 // DEBUG
@@ -460,7 +798,8 @@ Ball::is_exclusion_zone(const uint16_t x, const uint16_t y) const
   if ((x >= _force_field_width) || (y >= _force_field_height)) {
     Log::fatal("Ball::is_reflection(): x or y out of range");
   }
-  return _op_force_field[y * _force_field_width + x].is_exclusion_zone;
+  return
+    Velocity_op::is_exclusion_zone(_op_force_field->get_op(x, y));
 }
 
 /*
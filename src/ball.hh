@@ -26,66 +26,116 @@
 #define BALL_HH
 
 #include <inttypes.h>
-#include <QtGui/QPixmap>
 #include <ifield-geometry-listener.hh>
-#include <sensors.hh>
+#include <isensors.hh>
 #include <point-3d.hh>
 #include <force-field.hh>
+#include <ball-footprint.hh>
+#include <ball-forces.hh>
+#include <distance-field.hh>
+#include <counter-rng.hh>
+
+/*
+ * Substep-level diagnostics, i.e. the balls' statistics counters and
+ * range checks of velocities, are compiled in unless building with
+ * PHYSICS_DIAGNOSTICS=0 (see Makefile).
+ */
+#ifndef PHYSICS_DIAGNOSTICS
+#define PHYSICS_DIAGNOSTICS 1
+#endif
 
 class Ball : public IField_geometry_listener
 {
 public:
+  static const double MIN_X;
+  static const double MAX_X;
+  static const double MIN_Y;
+  static const double MAX_Y;
+  static const double PITCH_ACCELERATION;
+  static const double ROLL_ACCELERATION;
+  struct stats_t {
+    double max_vx;
+    double max_vy;
+    uint64_t boundary_hit_count;
+    uint64_t clamp_count;
+  };
+  static void merge_stats(stats_t *stats, const stats_t *other);
+  static void velocity_out_of_range(const char *where, const char *name,
+                                    const double velocity);
   Ball(const double px = 0.5, const double py = 0.5,
        const double vx = 0.0, const double vy = 0.0,
-       const double mass = 1.0);
+       const double mass = 1.0, const uint32_t random_seed = 1,
+       const uint32_t random_index = 0);
   virtual ~Ball();
-  void update(const Sensors *sensors);
+  void update(const ISensors *sensors);
+  void sweep(const ISensors *sensors, const uint32_t substeps);
+  void update_adaptive(const ISensors *sensors, const uint32_t substeps,
+                       const Distance_field *distance_field);
+  const uint64_t get_iteration_count() const;
   const Point_3D *get_position() const;
+  const Point_3D *get_previous_position() const;
+  void save_position();
   const Point_3D *get_velocity() const;
-  const QPixmap *get_pixmap() const;
+  void set_position(const double px, const double py);
+  void set_velocity(const double vx, const double vy);
+  const double get_geometry_correction_x() const;
+  const double get_geometry_correction_y() const;
+  const uint32_t get_random_seed() const;
+  void set_random_seed(const uint32_t random_seed);
+  const uint32_t get_random_index() const;
+  const uint64_t get_substep_count() const;
+  void set_substep_count(const uint64_t substep_count);
+  const Ball_forces *get_forces() const;
+  const double get_mass() const;
+  const uint16_t get_radius() const;
   const uint16_t get_pixmap_width() const;
   const uint16_t get_pixmap_height() const;
   const uint16_t get_pixmap_origin_x() const;
   const uint16_t get_pixmap_origin_y() const;
-  const double get_potential(const uint16_t x, const uint16_t y);
+  const double get_potential(const uint16_t x, const uint16_t y) const;
   const bool get_is_in_goal() const;
   void set_is_in_goal(const bool is_in_goal);
+  const bool get_is_in_exclusion_zone() const;
+  void set_is_in_exclusion_zone(const bool is_in_exclusion_zone);
+  const bool is_position_in_exclusion_zone() const;
+  void add_wall_contact(const double dvx, const double dvy);
+  const bool take_wall_contact(double *dvx, double *dvy);
+  const stats_t *get_stats() const;
+  void add_stats(const stats_t *stats);
+  void reset_stats();
   void precompute_forces(const Force_field *force_field);
   const double get_theta(const uint16_t x, const uint16_t y) const; // DEBUG
   const double is_reflection(const uint16_t x, const uint16_t y) const; // DEBUG
   const double is_exclusion_zone(const uint16_t x, const uint16_t y) const; // DEBUG
   virtual void geometry_changed(const uint16_t width, const uint16_t height);
 private:
-  struct velocity_op_t {
-    double m00, m10, m01, m11, theta;
-    bool is_reflection;
-    bool is_exclusion_zone;
-  };
-  static /*const*/ QPixmap *DEFAULT_PIXMAP;
-  static const uint16_t DEFAULT_PIXMAP_WIDTH;
-  static const uint16_t DEFAULT_PIXMAP_HEIGHT;
-  static const uint16_t DEFAULT_PIXMAP_ORIGIN_X;
-  static const uint16_t DEFAULT_PIXMAP_ORIGIN_Y;
+  static const uint16_t MAX_SWEEP_COLLISIONS;
+  static const double SWEEP_EPSILON;
   static const double abs(const double x);
-  static /*const*/ QPixmap *create_default_pixmap();
   uint16_t _playing_field_width, _playing_field_height;
   double _geometry_correction_x;
   double _geometry_correction_y;
   Point_3D *_position;
+  Point_3D *_previous_position;
   Point_3D *_velocity;
   const double _mass;
-  const QPixmap *_pixmap;
+  const Ball_footprint *_footprint;
   bool _is_in_goal;
-  double _max_vx = 0.0;
-  double _max_vy = 0.0;
+  bool _is_in_exclusion_zone;
+  double _contact_dvx;
+  double _contact_dvy;
+  uint32_t _random_seed;
+  uint32_t _random_index;
+  uint64_t _substep_count;
+  uint64_t _iteration_count;
+  stats_t _stats;
 
-  const bool update_velocity(const struct velocity_op_t velocity_op,
+  const bool update_velocity(const uint16_t velocity_op,
                              Point_3D *velocity) const;
-  void precompute_forces(const uint16_t x, const uint16_t y,
-                         const Force_field *force_field);
+  const Ball_forces *_forces;
   uint16_t _force_field_width;
   uint16_t _force_field_height;
-  struct velocity_op_t *_op_force_field;
+  const Narrow_band *_op_force_field;
 };
 
 #endif /* BALL_HH */
@@ -23,15 +23,34 @@
  */
 
 #include <balls.hh>
+#include <chrono>
+#include <cmath>
+#include <type_traits>
+#include <ring-buffer.tcc>
 #include <log.hh>
 
 const uint16_t
 Balls::DEFAULT_OVERSAMPLING = 100;
 
+const uint32_t
+Balls::DEFAULT_RANDOM_SEED = 1;
+
+// enough for several steps' worth of events of all balls, as long as
+// the consumer polls at display rate
+const uint32_t
+Balls::EVENT_QUEUE_CAPACITY = 1024;
+
+// with the default config, yields about the pixels of the default
+// window size
+const uint16_t
+Balls::DEFAULT_CELLS_PER_TILE = 25;
+
 Balls::Balls(const std::vector<const Ball_init_data *> balls_init_data,
              const uint16_t rows,
              const uint16_t columns)
 {
+  _rows = rows;
+  _columns = columns;
   _balls = new std::vector<Ball *>();
   if (!_balls) {
     Log::fatal("Balls(): not enough memory");
@@ -46,36 +65,223 @@ Balls::Balls(const std::vector<const Ball_init_data *> balls_init_data,
     const double vx = ball_init_data->get_velocity_x();
     const double vy = ball_init_data->get_velocity_y();
     const double mass = ball_init_data->get_mass();
-    _balls->push_back(new Ball(x, y, vx, vy, mass));
+    _balls->push_back(new Ball(x, y, vx, vy, mass,
+                               DEFAULT_RANDOM_SEED, _balls->size()));
+    _initial_states.push_back({x, y, vx, vy});
   }
+  _own_force_field = new Force_field();
+  if (!_own_force_field) {
+    Log::fatal("Balls(): not enough memory");
+  }
+  _force_field = _own_force_field;
+  _distance_field = 0;
+  _potential_field = 0;
   _oversampling = DEFAULT_OVERSAMPLING;
   _sensors = 0;
+  _worker_pool = Worker_pool::get_default();
+  _substeps = 0;
+  // a scalar type other than double applies only to array storage
+  _storage =
+    std::is_same<physics_scalar_t, double>::value ?
+    STORAGE_OBJECTS : STORAGE_ARRAYS;
+  _collision_mode = COLLISION_OVERSAMPLING;
+  _colliding_balls = false;
+  _ball_collisions = new Ball_collisions();
+  if (!_ball_collisions) {
+    Log::fatal("Balls(): not enough memory");
+  }
+  _ball_array = new ball_array_t(_balls->size());
+  if (!_ball_array) {
+    Log::fatal("Balls(): not enough memory");
+  }
+  _is_stepping_array = false;
+  _pitch = 0.0;
+  _roll = 0.0;
+  _trace_recorder = 0;
+  _substep_budget = 0;
+  _events = new Ring_buffer<event_t>(EVENT_QUEUE_CAPACITY);
+  if (!_events) {
+    Log::fatal("Balls(): not enough memory");
+  }
+  _dropped_event_count = 0;
+  _step_count = 0;
+  _goal_count = 0;
 }
 
 Balls::~Balls()
 {
   _sensors = 0;
-  // TODO: Check: First delete vector elements before deleting the
-  // vector (memory leak)?
+  _potential_field = 0;
+  for (Ball *ball : *_balls) {
+    delete ball;
+  }
   delete _balls;
   _balls = 0;
+  delete _own_force_field;
+  _own_force_field = 0;
+  _force_field = 0;
+  delete _distance_field;
+  _distance_field = 0;
   _oversampling = 0;
+  _worker_pool = 0;
+  delete _ball_array;
+  _ball_array = 0;
+  delete _ball_collisions;
+  _ball_collisions = 0;
+  _trace_recorder = 0;
+  _substep_budget = 0;
+  delete _events;
+  _events = 0;
+}
+
+/*
+ * Puts all balls back to their initial positions and velocities,
+ * out of the goal, and discards pending events and statistics, such
+ * that another game can be played on the already loaded force field
+ * without recomputing it.  The random seed is kept.  Restarting
+ * while a trace recorder is attached is not recorded.  Since the
+ * event queue has a single consumer, no other thread may poll events
+ * (see poll_event()) while restarting.
+ */
+void
+Balls::restart()
+{
+  for (uint16_t i = 0; i < _balls->size(); i++) {
+    Ball *ball = _balls->at(i);
+    const initial_state_t *initial_state = &_initial_states[i];
+    ball->set_position(initial_state->px, initial_state->py);
+    ball->set_velocity(initial_state->vx, initial_state->vy);
+    ball->save_position();
+    ball->set_substep_count(0);
+    ball->set_is_in_goal(false);
+    ball->set_is_in_exclusion_zone(false);
+    double dvx, dvy;
+    ball->take_wall_contact(&dvx, &dvy);
+    ball->reset_stats();
+  }
+  event_t event;
+  while (_events->pop(&event));
+  _dropped_event_count = 0;
+  _step_count = 0;
+  _goal_count = 0;
 }
 
 void
-Balls::set_sensors(Sensors *sensors)
+Balls::set_sensors(const ISensors *sensors)
 {
   _sensors = sensors;
 }
 
-const uint8_t
+/*
+ * Loads the field onto a grid of the given size, usually of a fixed
+ * number of cells per tile (see get_grid_width(), get_grid_height())
+ * rather than the display's pixels, such that the cost and the
+ * outcome of the physics do not depend on the display.
+ */
+void
+Balls::load_field(const IPotential_field *potential_field,
+                  const uint16_t width, const uint16_t height)
+{
+  if (!potential_field) {
+    Log::fatal("Balls::load_field(): potential_field is null");
+  }
+  _potential_field = potential_field;
+  if (_trace_recorder) {
+    _trace_recorder->record_field(width, height);
+  }
+  Log::debug("loading force field");
+  _own_force_field->load_field(potential_field, width, height);
+  _force_field = _own_force_field;
+  attach_field(width, height);
+}
+
+/*
+ * Uses the force field that the given balls have loaded rather than
+ * loading it once again, since a loaded field is read only.  Balls
+ * with the same footprint thereby also share their precomputed
+ * forces (see Ball_forces_cache).  The given balls must neither
+ * reload their field nor be deleted as long as these balls use it.
+ */
+void
+Balls::share_field(const Balls *balls)
+{
+  if (!balls) {
+    Log::fatal("Balls::share_field(): balls is null");
+  }
+  if (!balls->_potential_field) {
+    Log::fatal("Balls::share_field(): no field loaded");
+  }
+  const uint16_t width = balls->_force_field->get_width();
+  const uint16_t height = balls->_force_field->get_height();
+  _potential_field = balls->_potential_field;
+  if (_trace_recorder) {
+    _trace_recorder->record_field(width, height);
+  }
+  _force_field = balls->_force_field;
+  attach_field(width, height);
+}
+
+void
+Balls::attach_field(const uint16_t width, const uint16_t height)
+{
+  Log::debug("compute forces field onto balls");
+  for (Ball *ball : *_balls) {
+    ball->geometry_changed(width, height);
+    ball->precompute_forces(_force_field);
+    ball->save_position();
+  }
+  // balls may have been restored, e.g. when replaying a trace
+  _goal_count = 0;
+  for (const Ball *ball : *_balls) {
+    if (ball->get_is_in_goal()) {
+      _goal_count++;
+    }
+  }
+}
+
+const Force_field *
+Balls::get_force_field() const
+{
+  return _force_field;
+}
+
+/*
+ * Returns the width of a grid of the given number of cells per tile
+ * for loading a field with the given number of columns onto.
+ */
+const uint16_t
+Balls::get_grid_width(const uint16_t columns,
+                      const uint16_t cells_per_tile)
+{
+  const uint32_t width = ((uint32_t)columns) * cells_per_tile;
+  if (!width || (width > UINT16_MAX)) {
+    Log::fatal("Balls::get_grid_width(): grid width out of range");
+  }
+  return width;
+}
+
+/*
+ * Returns the height of a grid of the given number of cells per tile
+ * for loading a field with the given number of rows onto.
+ */
+const uint16_t
+Balls::get_grid_height(const uint16_t rows, const uint16_t cells_per_tile)
+{
+  const uint32_t height = ((uint32_t)rows) * cells_per_tile;
+  if (!height || (height > UINT16_MAX)) {
+    Log::fatal("Balls::get_grid_height(): grid height out of range");
+  }
+  return height;
+}
+
+const uint16_t
 Balls::get_count() const
 {
   return _balls->size();
 }
 
 Ball *
-Balls::at(const uint8_t index) const
+Balls::at(const uint16_t index) const
 {
   if (index < 0) {
     Log::fatal("Balls::get_position(): index < 0");
@@ -86,56 +292,277 @@ Balls::at(const uint8_t index) const
   return _balls->at(index);
 }
 
+/*
+ * Advances all balls by the given number of substeps.  Reads the
+ * sensors only once, and holds their values for all substeps, such
+ * that sensors may be sampled concurrently.
+ */
 void
-Balls::update(IPlaying_field *playing_field)
+Balls::step(const uint32_t substeps)
 {
-  // TODO: Fix memory leaks from use of Point_3D.
+  if (!_sensors) {
+    Log::fatal("Balls::step(): sensors is null");
+  }
+  if (!_potential_field) {
+    Log::fatal("Balls::step(): no field loaded");
+  }
+  _pitch = _sensors->get_pitch();
+  _roll = _sensors->get_roll();
+  if (_trace_recorder) {
+    _trace_recorder->record_step(substeps, _pitch, _roll);
+  }
+  if ((_collision_mode == COLLISION_ADAPTIVE) &&
+      (!_distance_field ||
+       (_distance_field->get_generation() !=
+        _force_field->get_generation()))) {
+    delete _distance_field;
+    _distance_field = new Distance_field(_force_field);
+    if (!_distance_field) {
+      Log::fatal("Balls::step(): not enough memory");
+    }
+  }
   for (Ball *ball : *_balls) {
-    const uint16_t pixmap_width = ball->get_pixmap_width();
-    const uint16_t pixmap_height = ball->get_pixmap_height();
-    const uint16_t pixmap_origin_x = ball->get_pixmap_origin_x();
-    const uint16_t pixmap_origin_y = ball->get_pixmap_origin_y();
-
-    const double old_px = ball->get_position()->get_x();
-    const double old_py = ball->get_position()->get_y();
+    ball->save_position();
+  }
+  _is_stepping_array =
+    (_collision_mode == COLLISION_OVERSAMPLING) &&
+    (_storage == STORAGE_ARRAYS) && _ball_array->load(_balls);
+  uint32_t task_count;
+  if (_is_stepping_array) {
+    task_count =
+      (_balls->size() + ball_array_t::BLOCK_SIZE - 1) / ball_array_t::BLOCK_SIZE;
+  } else {
+    task_count = _balls->size();
+  }
+  if (_colliding_balls && (_collision_mode == COLLISION_OVERSAMPLING)) {
+    _substeps = 1;
+    for (uint32_t i = 0; i < substeps; i++) {
+      run_tasks(task_count);
+      collide_balls();
+    }
+  } else {
+    _substeps = substeps;
+    run_tasks(task_count);
+    if (_colliding_balls) {
+      collide_balls();
+    }
+  }
+  if (_is_stepping_array) {
+    _ball_array->store(_balls);
+  }
+  _step_count++;
+  detect_events();
+}
 
-    if (_sensors) {
-      for (uint16_t i = 0; i < _oversampling; i++) {
-        ball->update(_sensors);
+/*
+ * Checks all balls for events of the current step, and emits them.
+ * Balls in the goal stay there, hence are not checked again.
+ */
+void
+Balls::detect_events()
+{
+  for (uint16_t i = 0; i < _balls->size(); i++) {
+    Ball *ball = _balls->at(i);
+    double dvx, dvy;
+    if (ball->take_wall_contact(&dvx, &dvy)) {
+      const double dv = sqrt(dvx * dvx + dvy * dvy);
+      emit_event(EVENT_WALL_CONTACT, i, dvx / dv, dvy / dv,
+                 ball->get_mass() * dv);
+    }
+    const bool is_in_exclusion_zone = ball->is_position_in_exclusion_zone();
+    if (is_in_exclusion_zone && !ball->get_is_in_exclusion_zone()) {
+      emit_event(EVENT_EXCLUSION_ZONE, i, 0.0, 0.0, 0.0);
+    }
+    ball->set_is_in_exclusion_zone(is_in_exclusion_zone);
+    if (!ball->get_is_in_goal()) {
+      const double px = ball->get_position()->get_x();
+      const double py = ball->get_position()->get_y();
+      if (_potential_field->matches_goal(px, py)) {
+        ball->set_is_in_goal(true);
+        _goal_count++;
+        emit_event(EVENT_GOAL, i, 0.0, 0.0, 0.0);
       }
     }
+  }
+}
 
-    const double new_px = ball->get_position()->get_x();
-    const double new_py = ball->get_position()->get_y();
+/*
+ * Pushes an event into the preallocated queue.  A wall contact
+ * carries the wall's normal and the impulse of the strongest contact
+ * during the step.  If the queue is full, the event is dropped and
+ * counted rather than allocating.
+ */
+void
+Balls::emit_event(const event_type_t type, const uint16_t ball_index,
+                  const double normal_x, const double normal_y,
+                  const double impulse)
+{
+  const Ball *ball = _balls->at(ball_index);
+  const event_t event = {
+    type, ball_index, _step_count,
+    ball->get_position()->get_x(), ball->get_position()->get_y(),
+    normal_x, normal_y, impulse
+  };
+  if (!_events->push(event)) {
+    _dropped_event_count++;
+  }
+}
 
-    // schedule undrawing ball at old position
-    playing_field->invalidate_rect(old_px, old_py,
-                                   pixmap_width, pixmap_height,
-                                   pixmap_origin_x, pixmap_origin_y);
+/*
+ * Takes the oldest pending event.  Returns false, if there is none.
+ * May be called by one thread concurrently to stepping, but not to
+ * restarting (see restart()).
+ */
+const bool
+Balls::poll_event(event_t *event)
+{
+  return _events->pop(event);
+}
 
-    // schedule drawing ball at new position
-    playing_field->invalidate_rect(new_px, new_py,
-                                   pixmap_width, pixmap_height,
-                                   pixmap_origin_x, pixmap_origin_y);
+/*
+ * Returns the number of events dropped, because the queue was full.
+ */
+const uint64_t
+Balls::get_dropped_event_count() const
+{
+  return _dropped_event_count;
+}
 
-    if (playing_field->matches_goal(new_px, new_py)) {
-      ball->set_is_in_goal(true);
+void
+Balls::run_tasks(const uint32_t task_count)
+{
+  if (_worker_pool) {
+    _worker_pool->run(this, task_count);
+  } else {
+    for (uint32_t index = 0; index < task_count; index++) {
+      run_task(index);
     }
   }
 }
 
+void
+Balls::collide_balls()
+{
+  if (_is_stepping_array) {
+    _ball_array->collide_balls(_ball_collisions);
+    return;
+  }
+  const uint32_t count = _balls->size();
+  _collision_px.resize(count);
+  _collision_py.resize(count);
+  _collision_vx.resize(count);
+  _collision_vy.resize(count);
+  _collision_mass.resize(count);
+  _collision_radius.resize(count);
+  for (uint32_t i = 0; i < count; i++) {
+    const Ball *ball = _balls->at(i);
+    _collision_px[i] = ball->get_position()->get_x();
+    _collision_py[i] = ball->get_position()->get_y();
+    _collision_vx[i] = ball->get_velocity()->get_x();
+    _collision_vy[i] = ball->get_velocity()->get_y();
+    _collision_mass[i] = ball->get_mass();
+    _collision_radius[i] = ball->get_radius();
+  }
+  _ball_collisions->resolve(count,
+                            _collision_px.data(), _collision_py.data(),
+                            _collision_vx.data(), _collision_vy.data(),
+                            _collision_mass.data(),
+                            _collision_radius.data(),
+                            _force_field->get_width(),
+                            _force_field->get_height());
+  for (uint32_t i = 0; i < count; i++) {
+    _balls->at(i)->set_velocity(_collision_vx[i], _collision_vy[i]);
+  }
+}
+
+void
+Balls::run_task(const uint32_t index)
+{
+  if (_is_stepping_array) {
+    const uint32_t first = index * ball_array_t::BLOCK_SIZE;
+    const uint32_t count =
+      _balls->size() - first < ball_array_t::BLOCK_SIZE ?
+      _balls->size() - first : ball_array_t::BLOCK_SIZE;
+    _ball_array->step(first, count, _substeps, _pitch, _roll);
+    return;
+  }
+  Ball *ball = _balls->at(index);
+  if (_collision_mode == COLLISION_SWEPT) {
+    ball->sweep(this, _substeps);
+    return;
+  }
+  if (_collision_mode == COLLISION_ADAPTIVE) {
+    ball->update_adaptive(this, _substeps, _distance_field);
+    return;
+  }
+  for (uint32_t i = 0; i < _substeps; i++) {
+    ball->update(this);
+  }
+}
+
+/*
+ * Returns the pitch, as held for the current step.
+ */
+const double
+Balls::get_pitch() const
+{
+  return _pitch;
+}
+
+/*
+ * Returns the roll, as held for the current step.
+ */
+const double
+Balls::get_roll() const
+{
+  return _roll;
+}
+
+/*
+ * Runs a step with the substeps of the current speed, as far as the
+ * substep budget, if any, admits.
+ */
+void
+Balls::update()
+{
+  if (!_substep_budget) {
+    step(_oversampling);
+    return;
+  }
+  const uint32_t substeps = _substep_budget->begin_step(_oversampling);
+  const std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  step(substeps);
+  const std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+  _substep_budget->end_step(substeps, elapsed.count());
+}
+
+/*
+ * Returns the statistics of all balls merged (see Ball::get_stats()).
+ */
+void
+Balls::get_stats(Ball::stats_t *stats) const
+{
+  stats->max_vx = 0.0;
+  stats->max_vy = 0.0;
+  stats->boundary_hit_count = 0;
+  stats->clamp_count = 0;
+  for (const Ball *ball : *_balls) {
+    Ball::merge_stats(stats, ball->get_stats());
+  }
+}
+
 const bool
 Balls::all_balls_in_goal() const
 {
-  // TODO: Performance: Do not loop each time through all balls, but
-  // maintain a counter of the number of balls in goal.
-  for (uint16_t i = 0; i < _balls->size(); i++) {
-    Ball *ball = _balls->at(i);
-    if (!ball->get_is_in_goal()) {
-      return false;
-    }
-  }
-  return true;
+  return _goal_count == _balls->size();
+}
+
+const uint16_t
+Balls::get_goal_count() const
+{
+  return _goal_count;
 }
 
 void
@@ -150,6 +577,146 @@ Balls::get_oversampling()
   return _oversampling;
 }
 
+/*
+ * Sets the worker pool for concurrently updating balls.  A null pool
+ * updates all balls serially in the calling thread.
+ */
+void
+Balls::set_worker_pool(Worker_pool *worker_pool)
+{
+  _worker_pool = worker_pool;
+}
+
+Worker_pool *
+Balls::get_worker_pool() const
+{
+  return _worker_pool;
+}
+
+/*
+ * With array storage, each step copies the balls' state into a
+ * structure of arrays and advances it with a vectorized kernel,
+ * which pays off for many balls.  Balls that do not share the same
+ * forces, and swept or adaptive collision mode, fall back to
+ * stepping Ball objects.
+ */
+void
+Balls::set_storage(const storage_t storage)
+{
+  _storage = storage;
+}
+
+const Balls::storage_t
+Balls::get_storage() const
+{
+  return _storage;
+}
+
+/*
+ * In swept collision mode, each step moves each ball continuously by
+ * all substeps at once (see Ball::sweep()) rather than substep by
+ * substep.  In adaptive collision mode, substeps that according to
+ * a distance field can not touch any wall are merged (see
+ * Ball::update_adaptive()).
+ */
+void
+Balls::set_collision_mode(const collision_mode_t collision_mode)
+{
+  _collision_mode = collision_mode;
+  if (_trace_recorder) {
+    _trace_recorder->record_mode(_collision_mode, _colliding_balls);
+  }
+}
+
+const Balls::collision_mode_t
+Balls::get_collision_mode() const
+{
+  return _collision_mode;
+}
+
+/*
+ * Lets balls collide elastically with each other.
+ */
+void
+Balls::set_colliding_balls(const bool colliding_balls)
+{
+  _colliding_balls = colliding_balls;
+  if (_trace_recorder) {
+    _trace_recorder->record_mode(_collision_mode, _colliding_balls);
+  }
+}
+
+const bool
+Balls::get_colliding_balls() const
+{
+  return _colliding_balls;
+}
+
+const uint64_t
+Balls::get_ball_collision_count() const
+{
+  return _ball_collisions->get_collision_count();
+}
+
+/*
+ * Sets the seed that, together with each ball's index and substep,
+ * keys the balls' random numbers.
+ */
+void
+Balls::set_random_seed(const uint32_t random_seed)
+{
+  for (Ball *ball : *_balls) {
+    ball->set_random_seed(random_seed);
+  }
+  if (_trace_recorder) {
+    _trace_recorder->record_seed(random_seed);
+  }
+}
+
+/*
+ * Attaches a trace recorder that records all subsequent input,
+ * starting with a snapshot of the current state of all balls, or
+ * detaches the current recorder, if null.  The recorder is not
+ * owned by the balls.
+ */
+void
+Balls::set_trace_recorder(Trace_recorder *trace_recorder)
+{
+  _trace_recorder = trace_recorder;
+  if (_trace_recorder) {
+    _trace_recorder->begin(this);
+    _trace_recorder->record_mode(_collision_mode, _colliding_balls);
+    if (_potential_field) {
+      _trace_recorder->record_field(_force_field->get_width(),
+                                    _force_field->get_height());
+    }
+  }
+}
+
+Trace_recorder *
+Balls::get_trace_recorder() const
+{
+  return _trace_recorder;
+}
+
+/*
+ * Attaches a substep budget that limits the CPU time of update().
+ * The budget is not owned by the balls.  A null budget runs all
+ * substeps of each step.  Since the trace records the substeps
+ * actually run, traces replay deterministically in either case.
+ */
+void
+Balls::set_substep_budget(Substep_budget *substep_budget)
+{
+  _substep_budget = substep_budget;
+}
+
+Substep_budget *
+Balls::get_substep_budget() const
+{
+  return _substep_budget;
+}
+
 /*
  * Local variables:
  *   mode: c++
@@ -27,30 +27,164 @@
 
 #include <vector>
 #include <inttypes.h>
-#include <sensors.hh>
+#include <isensors.hh>
+#include <ipotential-field.hh>
+#include <ball-init-data.hh>
 #include <ball.hh>
-#include <iplaying-field.hh>
+#include <ball-array.hh>
+#include <force-field.hh>
+#include <distance-field.hh>
+#include <ball-collisions.hh>
+#include <iworker-task.hh>
+#include <worker-pool.hh>
+#include <trace-recorder.hh>
+#include <ring-buffer.hh>
+#include <substep-budget.hh>
 
-class Balls
+/*
+ * Balls is the core of the physics engine.  It owns the state of
+ * all balls, the force field with the balls' precomputed velocity
+ * operations, and detects when balls reach the goal.  It does not
+ * depend on Qt, such that physics can run without any event loop,
+ * e.g. for batch validation of levels or for benchmarks.  The Qt
+ * front-end (Simulation, Playing_field) just triggers steps and
+ * renders the resulting ball positions.
+ *
+ * Balls move independently of each other between collisions with
+ * each other.  Hence, each step updates the balls concurrently on a
+ * worker pool, and joins all balls before checking for goals.  If
+ * balls collide with each other, they are also joined after each
+ * substep in oversampling mode, or after each step in swept and
+ * adaptive mode, to resolve collisions between balls (see
+ * collide_balls()).  Since each ball's random numbers are keyed by
+ * seed, ball index and substep (see Counter_rng), results do not
+ * depend on the number of threads.
+ *
+ * After each step, Balls emits events (goal, wall contact, exclusion
+ * zone) into a queue that another thread may poll concurrently to
+ * stepping (see poll_event()).
+ */
+class Balls : private IWorker_task, private ISensors
 {
 public:
+  enum storage_t {
+    STORAGE_OBJECTS,
+    STORAGE_ARRAYS
+  };
+  enum collision_mode_t {
+    COLLISION_OVERSAMPLING,
+    COLLISION_SWEPT,
+    COLLISION_ADAPTIVE
+  };
+  enum event_type_t {
+    EVENT_GOAL,
+    EVENT_WALL_CONTACT,
+    EVENT_EXCLUSION_ZONE
+  };
+  struct event_t {
+    event_type_t type;
+    uint16_t ball_index;
+    uint64_t step;
+    double px;
+    double py;
+    double normal_x;
+    double normal_y;
+    double impulse;
+  };
+  static const uint16_t DEFAULT_CELLS_PER_TILE;
+  static const uint16_t get_grid_width(const uint16_t columns,
+                                       const uint16_t cells_per_tile);
+  static const uint16_t get_grid_height(const uint16_t rows,
+                                        const uint16_t cells_per_tile);
   Balls(const std::vector<const Ball_init_data *> balls_init_data,
         const uint16_t rows,
         const uint16_t columns);
   virtual ~Balls();
-  void set_sensors(Sensors *sensors);
-  void update(IPlaying_field *playing_field);
-  const uint8_t get_count() const;
-  Ball *at(const uint8_t index) const;
+  void restart();
+  void set_sensors(const ISensors *sensors);
+  void load_field(const IPotential_field *potential_field,
+                  const uint16_t width, const uint16_t height);
+  void share_field(const Balls *balls);
+  const Force_field *get_force_field() const;
+  void step(const uint32_t substeps);
+  void update();
+  const uint16_t get_count() const;
+  Ball *at(const uint16_t index) const;
   const bool all_balls_in_goal() const;
+  const uint16_t get_goal_count() const;
+  const bool poll_event(event_t *event);
+  const uint64_t get_dropped_event_count() const;
+  void get_stats(Ball::stats_t *stats) const;
   void set_oversampling(const uint16_t oversampling);
   const uint16_t get_oversampling();
+  void set_worker_pool(Worker_pool *worker_pool);
+  Worker_pool *get_worker_pool() const;
+  void set_storage(const storage_t storage);
+  const storage_t get_storage() const;
+  void set_collision_mode(const collision_mode_t collision_mode);
+  const collision_mode_t get_collision_mode() const;
+  void set_colliding_balls(const bool colliding_balls);
+  const bool get_colliding_balls() const;
+  const uint64_t get_ball_collision_count() const;
+  void set_random_seed(const uint32_t random_seed);
+  void set_trace_recorder(Trace_recorder *trace_recorder);
+  Trace_recorder *get_trace_recorder() const;
+  void set_substep_budget(Substep_budget *substep_budget);
+  Substep_budget *get_substep_budget() const;
 
 private:
+  typedef Ball_array<physics_scalar_t> ball_array_t;
+  struct initial_state_t {
+    double px;
+    double py;
+    double vx;
+    double vy;
+  };
   static const uint16_t DEFAULT_OVERSAMPLING;
-  Sensors *_sensors;
+  static const uint32_t DEFAULT_RANDOM_SEED;
+  static const uint32_t EVENT_QUEUE_CAPACITY;
+  uint16_t _rows;
+  uint16_t _columns;
+  const ISensors *_sensors;
+  const IPotential_field *_potential_field;
+  Force_field *_own_force_field;
+  const Force_field *_force_field;
+  Distance_field *_distance_field;
   std::vector<Ball *> *_balls;
+  std::vector<initial_state_t> _initial_states;
   uint16_t _oversampling;
+  Worker_pool *_worker_pool;
+  uint32_t _substeps;
+  storage_t _storage;
+  collision_mode_t _collision_mode;
+  bool _colliding_balls;
+  Ball_collisions *_ball_collisions;
+  std::vector<double> _collision_px;
+  std::vector<double> _collision_py;
+  std::vector<double> _collision_vx;
+  std::vector<double> _collision_vy;
+  std::vector<double> _collision_mass;
+  std::vector<double> _collision_radius;
+  ball_array_t *_ball_array;
+  bool _is_stepping_array;
+  double _pitch;
+  double _roll;
+  Trace_recorder *_trace_recorder;
+  Substep_budget *_substep_budget;
+  Ring_buffer<event_t> *_events;
+  std::atomic<uint64_t> _dropped_event_count;
+  uint64_t _step_count;
+  uint16_t _goal_count;
+  void attach_field(const uint16_t width, const uint16_t height);
+  void detect_events();
+  void emit_event(const event_type_t type, const uint16_t ball_index,
+                  const double normal_x, const double normal_y,
+                  const double impulse);
+  void run_tasks(const uint32_t task_count);
+  void collide_balls();
+  virtual void run_task(const uint32_t index);
+  virtual const double get_pitch() const;
+  virtual const double get_roll() const;
 };
 
 #endif /* BALLS_HH */
@@ -24,6 +24,7 @@
 
 #include <brush-field.hh>
 #include <cmath>
+#include <op-table-cache.hh>
 #include <log.hh>
 
 Brush_field::Brush_field(const uint16_t columns,
@@ -45,6 +46,10 @@ Brush_field::~Brush_field()
 
 #define EPSILON 0.0001
 
+/*
+ * Sets the geometry of the grid that the potential field is sampled
+ * on, such that the outermost pixels of each tile are recognized.
+ */
 void
 Brush_field::geometry_changed(const uint16_t width, const uint16_t height)
 {
@@ -58,6 +63,15 @@ Brush_field::geometry_changed(const uint16_t width, const uint16_t height)
       ", tile_pixel_height=" << _tile_pixel_height;
     Log::debug(str.str());
   }
+}
+
+/*
+ * Sets the geometry of the display that the brushes are drawn onto.
+ */
+void
+Brush_field::brush_geometry_changed(const uint16_t width,
+                                    const uint16_t height)
+{
   for (Tile *tile : _field) {
     tile->geometry_changed(width, height);
   }
@@ -222,6 +236,25 @@ Brush_field::matches_goal(const double x, const double y) const
   return get_potential(x, y) < 0.0;
 }
 
+/*
+ * Hashes the tiles' potentials and shapes, but not their brushes,
+ * which do not affect the physics.
+ */
+const uint64_t
+Brush_field::get_level_hash() const
+{
+  std::stringstream str;
+  str.precision(17);
+  str << "columns=" << _columns << ", rows=" << _rows;
+  for (const Tile *tile : _field) {
+    str << std::endl << tile->get_foreground_potential() << ", " <<
+      tile->get_background_potential() << ", " <<
+      tile->get_shape()->to_string();
+  }
+  const std::string level = str.str();
+  return Op_table_cache::hash(level.data(), level.size());
+}
+
 const std::vector<const Ball_init_data *>
 Brush_field::get_balls_init_data() const
 {
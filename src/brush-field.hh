@@ -31,10 +31,18 @@
 #include <QtGui/QPixmap>
 #include <QtGui/QBrush>
 #include <ifield-geometry-listener.hh>
+#include <ipotential-field.hh>
 #include <tile.hh>
 #include <ball-init-data.hh>
 
-class Brush_field : public IField_geometry_listener
+/*
+ * The level's tiles, both as potential field for the physics and as
+ * brushes for drawing.  The geometry of the potential field is that
+ * of the grid that the physics loads the field onto, and the geometry
+ * of the brushes is that of the display; both change independently.
+ */
+class Brush_field :
+  public IField_geometry_listener, public IPotential_field
 {
 public:
   Brush_field(const uint16_t columns,
@@ -46,10 +54,12 @@ public:
   const uint16_t get_columns() const;
   const uint16_t get_rows() const;
   const QBrush *get_brush(const double x, const double y) const;
-  const double get_potential(const double x, const double y) const;
-  const double get_avg_tan(const double x, const double y) const;
-  const bool matches_goal(const double x, const double y) const;
+  virtual const double get_potential(const double x, const double y) const;
+  virtual const double get_avg_tan(const double x, const double y) const;
+  virtual const bool matches_goal(const double x, const double y) const;
+  virtual const uint64_t get_level_hash() const;
   virtual void geometry_changed(const uint16_t width, const uint16_t height);
+  void brush_geometry_changed(const uint16_t width, const uint16_t height);
   const std::vector<const Ball_init_data *> get_balls_init_data() const;
 private:
   const uint16_t _columns;
@@ -0,0 +1,81 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef COUNTER_RNG_HH
+#define COUNTER_RNG_HH
+
+#include <inttypes.h>
+
+/*
+ * A stateless, counter-based random number generator: each number is
+ * a hash of a key (seed and ball index) and a counter (the ball's
+ * substep), rather than the next value of a sequential state.  Hence,
+ * the numbers that a ball draws do not depend on the order in which
+ * balls and substeps are computed, neither on threads nor on
+ * vectorization, and a generator needs no state that would have to
+ * be shared or copied.  The hash is built from the SplitMix64
+ * finalizer, which is cheap enough to inline into the innermost
+ * loop.
+ */
+class Counter_rng
+{
+public:
+  static inline const uint64_t get_bits(const uint32_t seed,
+                                        const uint32_t index,
+                                        const uint64_t counter)
+  {
+    const uint64_t key = mix((((uint64_t)seed) << 32) | index);
+    return mix(key + counter * GOLDEN_GAMMA);
+  }
+
+  /*
+   * Returns a uniformly distributed number in [0.0, 1.0).
+   */
+  static inline const double get_uniform(const uint32_t seed,
+                                         const uint32_t index,
+                                         const uint64_t counter)
+  {
+    return (get_bits(seed, index, counter) >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+private:
+  static const uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ull;
+
+  static inline const uint64_t mix(uint64_t z)
+  {
+    z += GOLDEN_GAMMA;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+};
+
+#endif /* COUNTER_RNG_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
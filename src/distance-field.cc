@@ -0,0 +1,225 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <distance-field.hh>
+#include <cmath>
+#include <cstdlib>
+#include <chrono.hh>
+#include <log.hh>
+#include <worker-pool.hh>
+
+const double
+Distance_field::FAR = 1.0e20;
+
+Distance_field::Distance_field(const Force_field *force_field) :
+  _generation(force_field->get_generation())
+{
+  Chrono chrono("distance field");
+  chrono.start();
+
+  _width = force_field->get_width();
+  _height = force_field->get_height();
+  const uint32_t pixels = ((uint32_t)_width) * _height;
+  _distances = (float *)calloc(pixels, sizeof(float));
+  _outside = (float *)calloc(pixels, sizeof(float));
+  _inside = (float *)calloc(pixels, sizeof(float));
+  if (!_distances || !_outside || !_inside) {
+    Log::fatal("Distance_field(): not enough memory");
+  }
+  _force_field = force_field;
+
+  Worker_pool *worker_pool = Worker_pool::get_default();
+  _phase = PHASE_COLUMNS;
+  worker_pool->run(this, _width);
+  _phase = PHASE_ROWS;
+  worker_pool->run(this, _height);
+
+  _force_field = 0;
+  free(_outside);
+  _outside = 0;
+  free(_inside);
+  _inside = 0;
+
+  chrono.stop();
+}
+
+Distance_field::~Distance_field()
+{
+  free(_distances);
+  _distances = 0;
+  _width = 0;
+  _height = 0;
+}
+
+/*
+ * One-dimensional squared distance transform of sampled function f
+ * with n samples, i.e. d(q) = min_p ((q - p)^2 + f(p)), computed as
+ * the lower envelope of parabolas.  v and z provide scratch space
+ * for n and n + 1 elements, respectively.
+ */
+void
+Distance_field::transform(const uint16_t n, const double *f, double *d,
+                          uint16_t *v, double *z)
+{
+  uint16_t k = 0;
+  v[0] = 0;
+  z[0] = -INFINITY;
+  z[1] = +INFINITY;
+  for (uint16_t q = 1; q < n; q++) {
+    double s;
+    while (true) {
+      const uint16_t p = v[k];
+      s = ((f[q] + ((double)q) * q) - (f[p] + ((double)p) * p)) /
+        (2.0 * q - 2.0 * p);
+      // z[0] is -infinity, hence the loop terminates at k = 0
+      if (s > z[k]) {
+        break;
+      }
+      k--;
+    }
+    k++;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = +INFINITY;
+  }
+  k = 0;
+  for (uint16_t q = 0; q < n; q++) {
+    while (z[k + 1] < q) {
+      k++;
+    }
+    const double delta = ((double)q) - v[k];
+    d[q] = delta * delta + f[v[k]];
+  }
+}
+
+void
+Distance_field::run_task(const uint32_t index)
+{
+  switch (_phase) {
+  case PHASE_COLUMNS:
+    transform_column(index);
+    break;
+  case PHASE_ROWS:
+    transform_row(index);
+    break;
+  default:
+    Log::fatal("Distance_field::run_task(): unexpected case fall-through");
+  }
+}
+
+void
+Distance_field::transform_column(const uint16_t x)
+{
+  double *f_outside = (double *)malloc(_height * sizeof(double));
+  double *f_inside = (double *)malloc(_height * sizeof(double));
+  double *d = (double *)malloc(_height * sizeof(double));
+  uint16_t *v = (uint16_t *)malloc(_height * sizeof(uint16_t));
+  double *z = (double *)malloc((_height + 1) * sizeof(double));
+  if (!f_outside || !f_inside || !d || !v || !z) {
+    Log::fatal("Distance_field::transform_column(): not enough memory");
+  }
+  for (uint16_t y = 0; y < _height; y++) {
+    const bool is_exclusion_zone = _force_field->is_exclusion_zone(x, y);
+    f_outside[y] = is_exclusion_zone ? 0.0 : FAR;
+    f_inside[y] = is_exclusion_zone ? FAR : 0.0;
+  }
+  transform(_height, f_outside, d, v, z);
+  for (uint16_t y = 0; y < _height; y++) {
+    _outside[y * _width + x] = d[y];
+  }
+  transform(_height, f_inside, d, v, z);
+  for (uint16_t y = 0; y < _height; y++) {
+    _inside[y * _width + x] = d[y];
+  }
+  free(f_outside);
+  free(f_inside);
+  free(d);
+  free(v);
+  free(z);
+}
+
+void
+Distance_field::transform_row(const uint16_t y)
+{
+  double *f_outside = (double *)malloc(_width * sizeof(double));
+  double *f_inside = (double *)malloc(_width * sizeof(double));
+  double *d_outside = (double *)malloc(_width * sizeof(double));
+  double *d_inside = (double *)malloc(_width * sizeof(double));
+  uint16_t *v = (uint16_t *)malloc(_width * sizeof(uint16_t));
+  double *z = (double *)malloc((_width + 1) * sizeof(double));
+  if (!f_outside || !f_inside || !d_outside || !d_inside || !v || !z) {
+    Log::fatal("Distance_field::transform_row(): not enough memory");
+  }
+  const uint32_t row = y * _width;
+  for (uint16_t x = 0; x < _width; x++) {
+    f_outside[x] = _outside[row + x];
+    f_inside[x] = _inside[row + x];
+  }
+  transform(_width, f_outside, d_outside, v, z);
+  transform(_width, f_inside, d_inside, v, z);
+  for (uint16_t x = 0; x < _width; x++) {
+    // one of both distances is 0
+    _distances[row + x] = sqrt(d_outside[x]) - sqrt(d_inside[x]);
+  }
+  free(f_outside);
+  free(f_inside);
+  free(d_outside);
+  free(d_inside);
+  free(v);
+  free(z);
+}
+
+const uint32_t
+Distance_field::get_generation() const
+{
+  return _generation;
+}
+
+const uint16_t
+Distance_field::get_width() const
+{
+  return _width;
+}
+
+const uint16_t
+Distance_field::get_height() const
+{
+  return _height;
+}
+
+const float
+Distance_field::get_distance(const uint16_t x, const uint16_t y) const
+{
+  if ((x >= _width) || (y >= _height)) {
+    Log::fatal("Distance_field::get_distance(): x or y out of range");
+  }
+  return _distances[y * _width + x];
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,78 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef DISTANCE_FIELD_HH
+#define DISTANCE_FIELD_HH
+
+#include <inttypes.h>
+#include <force-field.hh>
+#include <iworker-task.hh>
+
+/*
+ * Signed Euclidean distance, in pixels, from each pixel of a force
+ * field to the border of the field's exclusion zones: positive in
+ * free space, negative inside exclusion zones.  Computed with the
+ * linear-time distance transform by Felzenszwalb and Huttenlocher,
+ * as one pass over all columns followed by one pass over all rows,
+ * each of which is distributed across the default worker pool.
+ */
+class Distance_field : private IWorker_task
+{
+public:
+  Distance_field(const Force_field *force_field);
+  virtual ~Distance_field();
+  const uint32_t get_generation() const;
+  const uint16_t get_width() const;
+  const uint16_t get_height() const;
+  const float get_distance(const uint16_t x, const uint16_t y) const;
+private:
+  static const double FAR;
+  enum phase_t { PHASE_COLUMNS, PHASE_ROWS };
+  const uint32_t _generation;
+  uint16_t _width;
+  uint16_t _height;
+  float *_distances;
+
+  // squared distances to the nearest pixel outside / inside the
+  // exclusion zones, only used while computing
+  enum phase_t _phase;
+  const Force_field *_force_field;
+  float *_outside;
+  float *_inside;
+
+  static void transform(const uint16_t n, const double *f, double *d,
+                        uint16_t *v, double *z);
+  virtual void run_task(const uint32_t index);
+  void transform_column(const uint16_t x);
+  void transform_row(const uint16_t y);
+};
+
+#endif /* DISTANCE_FIELD_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,82 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef FIXED_POINT_HH
+#define FIXED_POINT_HH
+
+#include <inttypes.h>
+#include <cmath>
+
+/*
+ * A 32 bit fixed-point number for boards without (fast) floating
+ * point unit.  Since a ball moves by only a tiny fraction of the
+ * field per substep, and accelerates by yet smaller amounts, a single
+ * binary point does not fit all quantities.  Instead, the number of
+ * fraction bits depends on what the number represents: positions in
+ * [0, 1) have 31 fraction bits, velocities per substep have 40
+ * fraction bits (i.e. a range of +/-2^-9), and coefficients like
+ * geometry corrections or reflection matrices have 30 fraction bits.
+ * Products are computed with 64 bit intermediates.  Fixed-point
+ * arithmetic is exact integer arithmetic, and thus bit-identical on
+ * all platforms.
+ */
+class Fixed_point
+{
+public:
+  static const uint8_t POSITION_BITS = 31;
+  static const uint8_t VELOCITY_BITS = 40;
+  static const uint8_t COEFFICIENT_BITS = 30;
+
+  int32_t raw;
+
+  static inline const bool is_representable(const double value,
+                                            const uint8_t bits)
+  {
+    const double scaled = ldexp(value, bits);
+    return (scaled > INT32_MIN) && (scaled < INT32_MAX);
+  }
+
+  static inline const Fixed_point from_double(const double value,
+                                              const uint8_t bits)
+  {
+    Fixed_point fixed_point;
+    fixed_point.raw = (int32_t)floor(ldexp(value, bits) + 0.5);
+    return fixed_point;
+  }
+
+  static inline const double to_double(const Fixed_point fixed_point,
+                                       const uint8_t bits)
+  {
+    return ldexp((double)fixed_point.raw, -bits);
+  }
+};
+
+#endif /* FIXED_POINT_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
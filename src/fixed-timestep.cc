@@ -0,0 +1,111 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <fixed-timestep.hh>
+#include <cmath>
+#include <log.hh>
+
+Fixed_timestep::Fixed_timestep(const double step_seconds,
+                               const uint16_t max_steps) :
+  _step_seconds(step_seconds),
+  _max_steps(max_steps)
+{
+  if (!(step_seconds > 0.0)) {
+    Log::fatal("Fixed_timestep(): step_seconds must be positive");
+  }
+  if (!max_steps) {
+    Log::fatal("Fixed_timestep(): max_steps must be positive");
+  }
+  reset();
+}
+
+Fixed_timestep::~Fixed_timestep()
+{
+}
+
+/*
+ * Adds the wall-clock time elapsed since the previous frame, and
+ * returns the number of physics steps to run for this frame.
+ */
+const uint32_t
+Fixed_timestep::advance(const double elapsed_seconds)
+{
+  if (elapsed_seconds > 0.0) {
+    _accumulator += elapsed_seconds;
+  }
+  uint32_t steps = (uint32_t)floor(_accumulator / _step_seconds);
+  if (steps > _max_steps) {
+    const double dropped = (steps - _max_steps) * _step_seconds;
+    _accumulator -= dropped;
+    _dropped_seconds += dropped;
+    steps = _max_steps;
+  }
+  _accumulator -= steps * _step_seconds;
+  _step_count += steps;
+  return steps;
+}
+
+/*
+ * Returns the fraction of a step, in [0, 1), by which rendering is
+ * ahead of the last physics step.
+ */
+const double
+Fixed_timestep::get_alpha() const
+{
+  const double alpha = _accumulator / _step_seconds;
+  return alpha < 0.0 ? 0.0 : (alpha < 1.0 ? alpha : 1.0);
+}
+
+const double
+Fixed_timestep::get_step_seconds() const
+{
+  return _step_seconds;
+}
+
+const uint64_t
+Fixed_timestep::get_step_count() const
+{
+  return _step_count;
+}
+
+const double
+Fixed_timestep::get_dropped_seconds() const
+{
+  return _dropped_seconds;
+}
+
+void
+Fixed_timestep::reset()
+{
+  _accumulator = 0.0;
+  _step_count = 0;
+  _dropped_seconds = 0.0;
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,66 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef FIXED_TIMESTEP_HH
+#define FIXED_TIMESTEP_HH
+
+#include <inttypes.h>
+
+/*
+ * Accumulator that decouples the physics' fixed step from the
+ * variable rate of rendered frames.  Each frame adds the elapsed
+ * wall-clock time, and runs as many physics steps as fit into the
+ * accumulated time.  The remainder, as a fraction of a step, is the
+ * factor for interpolating between the last two physics states.  To
+ * not spiral into ever longer frames when the physics can not keep
+ * up, the number of steps per frame is limited; the excess time is
+ * dropped, i.e. the game slows down only then.
+ */
+class Fixed_timestep
+{
+public:
+  Fixed_timestep(const double step_seconds, const uint16_t max_steps);
+  virtual ~Fixed_timestep();
+  const uint32_t advance(const double elapsed_seconds);
+  const double get_alpha() const;
+  const double get_step_seconds() const;
+  const uint64_t get_step_count() const;
+  const double get_dropped_seconds() const;
+  void reset();
+private:
+  const double _step_seconds;
+  const uint16_t _max_steps;
+  double _accumulator;
+  uint64_t _step_count;
+  double _dropped_seconds;
+};
+
+#endif /* FIXED_TIMESTEP_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
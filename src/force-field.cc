@@ -25,166 +25,274 @@
 #include <cmath>
 #include <chrono.hh>
 #include <force-field.hh>
+#include <op-table-cache.hh>
 #include <log.hh>
 
-#define USE_IMPLICIT_CURVES 1
+Force_field::edge_detection_t
+Force_field::_default_edge_detection = EDGE_DETECTION_IMPLICIT_CURVES;
+
+std::atomic<uint32_t>
+Force_field::_next_generation(1);
+
+void
+Force_field::set_default_edge_detection(const edge_detection_t
+                                        edge_detection)
+{
+  _default_edge_detection = edge_detection;
+}
+
+const Force_field::edge_detection_t
+Force_field::get_default_edge_detection()
+{
+  return _default_edge_detection;
+}
 
 Force_field::Force_field()
 {
+  _generation = 0;
   _width = 0;
   _height = 0;
+  _edge_detection = _default_edge_detection;
+  _level_hash = 0;
+  _ops = 0;
   _op_field = 0;
+  _potential_field = 0;
+  _worker_pool = Worker_pool::get_default();
 }
 
 Force_field::~Force_field()
 {
   _width = 0;
   _height = 0;
-  if (_op_field) {
-    delete _op_field;
-  }
-  _op_field = 0;
+  _level_hash = 0;
+  free_op_field();
+  _worker_pool = 0;
 }
 
-double *
-Force_field::create_potential_field(const Brush_field *brush_field) const
+/*
+ * Sets the pool to load the field on, or loads it on the calling
+ * thread, if null.
+ */
+void
+Force_field::set_worker_pool(Worker_pool *worker_pool)
 {
-  double *potential_field = (double *)calloc(_width * _height, sizeof(double));
-  if (!potential_field) {
-    Log::fatal("Force_field::create_potential_field(): not enough memory");
+  _worker_pool = worker_pool;
+}
+
+void
+Force_field::free_op_field()
+{
+  delete _ops;
+  _ops = 0;
+}
+
+void
+Force_field::load_field_border()
+{
+  const uint16_t op_right = Velocity_op::encode(0.0, true, true);
+  const uint16_t op_down = Velocity_op::encode(0.5 * M_PI, true, true);
+  const uint16_t op_left = Velocity_op::encode(M_PI, true, true);
+  const uint16_t op_up = Velocity_op::encode(-0.5 * M_PI, true, true);
+  for (uint16_t x = 0; x < _width; x++) {
+    _op_field[x] = op_up;
+    _op_field[_height * _width - _width + x] = op_down;
   }
   for (uint16_t y = 0; y < _height; y++) {
-    const double field_y = (y + 0.5) / _height;
-    for (uint16_t x = 0; x < _width; x++) {
-      const double field_x = (x + 0.5) / _width;
-      potential_field[y * _width + x] =
-        brush_field->get_potential(field_x, field_y);
-    }
+    _op_field[y * _width] = op_left;
+    _op_field[y * _width + _width - 1] = op_right;
   }
-  return potential_field;
 }
 
+/*
+ * Samples the potential at the center of each pixel of row y.
+ */
 void
-Force_field::load_field_border()
+Force_field::load_potential_row(const uint16_t y, double *potentials) const
 {
-  const double theta_right = 0.0;
-  const double theta_down = 0.5 * M_PI;
-  const double theta_left = M_PI;
-  const double theta_up = -0.5 * M_PI;
+  const double field_y = (y + 0.5) / _height;
   for (uint16_t x = 0; x < _width; x++) {
-    _op_field[x].theta = theta_up;
-    _op_field[_height * _width - _width + x].theta = theta_down;
-    _op_field[x].is_reflection = true;
-    _op_field[_height * _width - _width + x].is_reflection = true;
-    _op_field[x].is_exclusion_zone = true;
-    _op_field[_height * _width - _width + x].is_exclusion_zone = true;
+    const double field_x = (x + 0.5) / _width;
+    potentials[x] = _potential_field->get_potential(field_x, field_y);
   }
-  for (uint16_t y = 0; y < _height; y++) {
-    _op_field[y * _width].theta = theta_left;
-    _op_field[y * _width + _width - 1].theta = theta_right;
-    _op_field[y * _width].is_reflection = true;
-    _op_field[y * _width + _width - 1].is_reflection = true;
-    _op_field[y * _width].is_exclusion_zone = true;
-    _op_field[y * _width + _width - 1].is_exclusion_zone = true;
+}
+
+/*
+ * Encodes the ops of row y from its gradients, directly as computed
+ * by the Sobel convolution.  The outermost pixels of the field do
+ * not reflect.
+ */
+void
+Force_field::load_sobel_row(const uint16_t y, const double *gx,
+                            const double *gy, const double *potentials)
+{
+  uint16_t *ops = _op_field + y * _width;
+  const bool is_border_row = (y == 0) || (y == _height - 1);
+  for (uint16_t x = 0; x < _width; x++) {
+    double theta = 0.0;
+    bool is_reflection = false;
+    if (!is_border_row && (x > 0) && (x < _width - 1)) {
+      theta = Sobel::get_edge_orientation(gx[x], gy[x], _width, _height);
+      // without orientation, there is no edge to reflect on
+      is_reflection = !std::isnan(theta) && !std::isinf(theta);
+    }
+    ops[x] = Velocity_op::encode(theta, is_reflection, potentials[x] >= 1.0);
   }
 }
 
+/*
+ * Streams the potentials of a band of rows through the Sobel
+ * convolution, holding only a window of five rows of potentials and
+ * a single row of gradients.  Each band samples the rows adjacent
+ * to it on its own, such that bands are independent.
+ */
 void
-Force_field::load_field(const uint16_t x, const uint16_t y,
-                        const Brush_field *brush_field,
-                        const Sobel *sobel)
+Force_field::load_sobel_band(const uint32_t band)
 {
-  struct velocity_op_t velocity_op;
-
-  // consider that result of sobel convolution has 2 pixels less of
-  // field width and height
-  if ((x > 0) && (x < _width - 1) && (y > 0) && (y < _height - 1)) {
-    const double r = sobel->get_edge_magnitude(x, y);
-    if ((r < 0.0) || (r > 1.0)) {
-      std::stringstream msg;
-      msg << "r=" << r << std::endl;
-      Log::info(msg.str());
-      Log::fatal("Force_field::load_field(): edge magnitude out of range");
+  const uint8_t size = Sobel::SIZE;
+  const uint8_t padding_size = (size - 1) / 2;
+  const uint16_t y0 = band * ROWS_PER_BAND;
+  const uint16_t y1 =
+    y0 + ROWS_PER_BAND < _height ? y0 + ROWS_PER_BAND : _height;
+  double *potentials = (double *)calloc(size * _width, sizeof(double));
+  double *gx = (double *)calloc(_width, sizeof(double));
+  double *gy = (double *)calloc(_width, sizeof(double));
+  if (!potentials || !gx || !gy) {
+    Log::fatal("Force_field::load_sobel_band(): not enough memory");
+  }
+  Sobel sobel(_width);
+  uint16_t next_row = y0 > padding_size ? y0 - padding_size : 0;
+  for (uint16_t y = y0; y < y1; y++) {
+    const uint16_t last_row =
+      y + padding_size < _height ? y + padding_size : _height - 1;
+    for (; next_row <= last_row; next_row++) {
+      load_potential_row(next_row,
+                         potentials + (next_row % size) * _width);
     }
-    const double theta = sobel->get_edge_orientation(x, y);
-    if (!std::isnan(theta) && !std::isinf(theta)) {
-      velocity_op.theta = theta;
-      velocity_op.is_reflection = true;
+    if ((y >= padding_size) && (y + padding_size < _height)) {
+      const double *rows[size];
+      for (uint8_t i = 0; i < size; i++) {
+        rows[i] = potentials + ((y - padding_size + i) % size) * _width;
+      }
+      sobel.convolute_row(rows, gx, gy);
     } else {
-      // sobel did not find any orientation to determine
-      // => no reflection
-      velocity_op.is_reflection = false;
+      for (uint16_t x = 0; x < _width; x++) {
+        gx[x] = 0.0;
+        gy[x] = 0.0;
+      }
     }
-  } else {
-    // treat remaining pixels just as non-reflecting pixels
-    velocity_op.is_reflection = false;
+    load_sobel_row(y, gx, gy, potentials + (y % size) * _width);
   }
-  velocity_op.is_exclusion_zone =
-    brush_field->get_potential((x + 0.5) / _width, (y + 0.5) / _height) >= 1.0;
-  _op_field[y * _width + x] = velocity_op;
+  free(potentials);
+  potentials = 0;
+  free(gx);
+  gx = 0;
+  free(gy);
+  gy = 0;
 }
 
 const bool
 Force_field::is_exclusion_zone(const double x, const double y,
-                               const Brush_field *brush_field) const
+                               const IPotential_field *potential_field) const
 {
-  return brush_field->get_potential(x, y) == 1.0;
+  return potential_field->get_potential(x, y) == 1.0;
 }
 
+/*
+ * Samples the exclusion zone at the center of each pixel of row y.
+ */
 void
-Force_field::load_field(const uint16_t x, const uint16_t y,
-                        const Brush_field *brush_field)
+Force_field::load_exclusion_row(const uint16_t y,
+                                const IPotential_field *field,
+                                uint8_t *exclusions) const
 {
-  struct velocity_op_t velocity_op;
   const double i_width = 1.0 / _width;
   const double i_height = 1.0 / _height;
-  velocity_op.is_exclusion_zone =
-    is_exclusion_zone((x + 0.5) * i_width, (y + 0.5) * i_height, brush_field);
-  const bool p0 =
-    is_exclusion_zone((x - 0.5) * i_width, (y - 0.5) * i_height, brush_field);
-  const bool p1 =
-    is_exclusion_zone((x + 0.5) * i_width, (y - 0.5) * i_height, brush_field);
-  const bool p2 =
-    is_exclusion_zone((x + 1.5) * i_width, (y - 0.5) * i_height, brush_field);
-  const bool p3 =
-    is_exclusion_zone((x - 0.5) * i_width, (y + 0.5) * i_height, brush_field);
-  const bool p4 =
-    is_exclusion_zone((x + 1.5) * i_width, (y + 0.5) * i_height, brush_field);
-  const bool p5 =
-    is_exclusion_zone((x - 0.5) * i_width, (y + 1.5) * i_height, brush_field);
-  const bool p6 =
-    is_exclusion_zone((x + 0.5) * i_width, (y + 1.5) * i_height, brush_field);
-  const bool p7 =
-    is_exclusion_zone((x + 1.5) * i_width, (y + 1.5) * i_height, brush_field);
-  const bool have_neighbour_in_exclusion_zone =
-    p0 || p1 || p2 || p3 || p4 || p5 || p6 || p7;
-  const bool have_neighbour_in_inclusion_zone =
-    !(p0 && p1 && p2 && p3 && p4 && p5 && p6 && p7);
-
-  if (velocity_op.is_exclusion_zone) {
-    if (have_neighbour_in_inclusion_zone) {
-      velocity_op.theta = brush_field->get_avg_tan((x + 0.5) * i_width,
-                                                   (y + 0.5) * i_height);
-      velocity_op.is_reflection = true;
-    } else {
-      velocity_op.theta = std::nan("");
-      velocity_op.is_reflection = false;
-    }
-  } else { // (!velocity_op.is_exclusion_zone)
-    if (have_neighbour_in_exclusion_zone) {
-      velocity_op.theta = brush_field->get_avg_tan((x + 0.5) * i_width,
-                                                   (y + 0.5) * i_height);
-      velocity_op.is_reflection = !std::isnan(velocity_op.theta);
+  const double field_y = (y + 0.5) * i_height;
+  for (uint16_t x = 0; x < _width; x++) {
+    exclusions[x] = is_exclusion_zone((x + 0.5) * i_width, field_y, field);
+  }
+}
+
+/*
+ * Computes the ops of the inner pixels of row y from the exclusion
+ * zone samples of rows y - 1, y and y + 1.  Only pixels on the
+ * boundary of the exclusion zone need the field's average tangent.
+ */
+void
+Force_field::load_row(const uint16_t y, const IPotential_field *field,
+                      const uint8_t *above, const uint8_t *row,
+                      const uint8_t *below)
+{
+  const double i_width = 1.0 / _width;
+  const double i_height = 1.0 / _height;
+  uint16_t *ops = _op_field + y * _width;
+  for (uint16_t x = 1; x < _width - 1; x++) {
+    const uint8_t neighbours_in_exclusion_zone =
+      above[x - 1] + above[x] + above[x + 1] +
+      row[x - 1] + row[x + 1] +
+      below[x - 1] + below[x] + below[x + 1];
+    const bool is_exclusion_zone_center = row[x];
+    const bool is_boundary = is_exclusion_zone_center ?
+      neighbours_in_exclusion_zone < 8 : neighbours_in_exclusion_zone > 0;
+    double theta;
+    bool is_reflection;
+    if (is_boundary) {
+      theta = field->get_avg_tan((x + 0.5) * i_width, (y + 0.5) * i_height);
+      is_reflection = is_exclusion_zone_center || !std::isnan(theta);
     } else {
-      velocity_op.theta = std::nan("");
-      velocity_op.is_reflection = false;
+      theta = std::nan("");
+      is_reflection = false;
     }
+    ops[x] =
+      Velocity_op::encode(theta, is_reflection, is_exclusion_zone_center);
+  }
+}
+
+void
+Force_field::run_task(const uint32_t index)
+{
+  if (_edge_detection == EDGE_DETECTION_SOBEL) {
+    load_sobel_band(index);
+  } else if (index) {
+    load_band(index - 1);
+  } else {
+    load_field_border();
   }
-  _op_field[y * _width + x] = velocity_op;
+}
+
+/*
+ * Each pixel depends on the exclusion zone of its 3x3 neighbourhood.
+ * Sampling the potential once per pixel into a window of three rows,
+ * rather than nine times per pixel, leaves the average tangent of
+ * the boundary pixels as main cost.  Each band samples the rows
+ * adjacent to it on its own, such that bands are independent.
+ */
+void
+Force_field::load_band(const uint32_t band)
+{
+  const uint16_t y0 = 1 + band * ROWS_PER_BAND;
+  const uint16_t y1 =
+    y0 + ROWS_PER_BAND < _height - 1 ? y0 + ROWS_PER_BAND : _height - 1;
+  uint8_t *exclusions = (uint8_t *)calloc(3 * _width, sizeof(uint8_t));
+  if (!exclusions) {
+    Log::fatal("Force_field::load_band(): not enough memory");
+  }
+  load_exclusion_row(y0 - 1, _potential_field,
+                     exclusions + ((y0 - 1) % 3) * _width);
+  load_exclusion_row(y0, _potential_field, exclusions + (y0 % 3) * _width);
+  for (uint16_t y = y0; y < y1; y++) {
+    const uint8_t *above = exclusions + ((y - 1) % 3) * _width;
+    const uint8_t *row = exclusions + (y % 3) * _width;
+    uint8_t *below = exclusions + ((y + 1) % 3) * _width;
+    load_exclusion_row(y + 1, _potential_field, below);
+    load_row(y, _potential_field, above, row, below);
+  }
+  free(exclusions);
+  exclusions = 0;
 }
 
 void
-Force_field::load_field(const Brush_field *brush_field,
+Force_field::load_field(const IPotential_field *potential_field,
                         const uint16_t width, const uint16_t height)
 {
   if (width <= 0) {
@@ -195,48 +303,69 @@ Force_field::load_field(const Brush_field *brush_field,
   }
   _width = width;
   _height = height;
+  _edge_detection = _default_edge_detection;
+  _level_hash = potential_field->get_level_hash();
+  if (_level_hash && (_edge_detection != EDGE_DETECTION_IMPLICIT_CURVES)) {
+    // cached ops must not be mistaken for those of another method
+    const uint8_t edge_detection = _edge_detection;
+    _level_hash =
+      Op_table_cache::hash(&edge_detection, sizeof(edge_detection),
+                           _level_hash);
+  }
+  // each (re-)load yields a globally unique generation, such that
+  // caches of derived data can detect stale entries
+  _generation = _next_generation++;
 
   Chrono chrono("field forces");
   chrono.start();
 
-  if (!_op_field) {
-    delete _op_field;
-    _op_field = 0;
+  free_op_field();
+  Op_table_cache *op_table_cache =
+    _level_hash ? Op_table_cache::get_default() : 0;
+  const Op_table_cache::key_t key =
+    Op_table_cache::get_key(_level_hash, _width, _height);
+  if (op_table_cache) {
+    _ops = op_table_cache->load(&key);
+    if (_ops) {
+      chrono.stop();
+      return;
+    }
   }
-  _op_field =
-    (struct velocity_op_t *)calloc(_width * _height,
-                                   sizeof(struct velocity_op_t));
+  _op_field = (uint16_t *)calloc(_width * _height, sizeof(uint16_t));
   if (!_op_field) {
     Log::fatal("Force_field::load_field(): not enough memory");
   }
 
-#if USE_IMPLICIT_CURVES // use implicit curves
-  load_field_border();
-  for (uint16_t x = 1; x < _width - 1; x++) {
-    for (uint16_t y = 1; y < _height - 1; y++) {
-      load_field(x, y, brush_field);
+  _potential_field = potential_field;
+  uint32_t task_count;
+  if (_edge_detection == EDGE_DETECTION_SOBEL) {
+    task_count = (_height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+  } else {
+    // task 0 loads the border, all other tasks a band of inner rows
+    task_count = 1 +
+      (_height > 2 ? (_height - 2 + ROWS_PER_BAND - 1) / ROWS_PER_BAND : 0);
+  }
+  if (_worker_pool) {
+    _worker_pool->run(this, task_count);
+  } else {
+    for (uint32_t index = 0; index < task_count; index++) {
+      run_task(index);
     }
   }
-#else // use sobel
-  Sobel *sobel = new Sobel(width, height);
-  if (!sobel) {
+  _potential_field = 0;
+
+  // walls are thin compared to the field => keep only their
+  // neighbourhood dense
+  _ops = new Narrow_band(_width, _height, _op_field);
+  if (!_ops) {
     Log::fatal("Force_field::load_field(): not enough memory");
   }
-  double *potential_field = create_potential_field(brush_field);
-  sobel->compute_convolution(potential_field);
-  free(potential_field);
-  potential_field = 0;
+  free(_op_field);
+  _op_field = 0;
 
-  for (uint16_t x = 0; x < _width; x++) {
-    for (uint16_t y = 0; y < _height; y++) {
-      load_field(x, y, brush_field, sobel);
-    }
+  if (op_table_cache) {
+    op_table_cache->store(&key, _ops);
   }
-
-  delete sobel;
-  sobel = 0;
-#endif
-
   chrono.stop();
 }
 
@@ -252,13 +381,25 @@ Force_field::get_height() const
   return _height;
 }
 
+const uint32_t
+Force_field::get_generation() const
+{
+  return _generation;
+}
+
+const uint64_t
+Force_field::get_level_hash() const
+{
+  return _level_hash;
+}
+
 const double
 Force_field::get_theta(const uint16_t x, const uint16_t y) const
 {
   if ((x >= _width) || (y >= _height)) {
     Log::fatal("Force_field::get_velocity00(): x or y out of range");
   }
-  return _op_field[y * _width + x].theta;
+  return Velocity_op::get_theta(_ops->get_op(x, y));
 }
 
 const bool
@@ -267,7 +408,7 @@ Force_field::is_reflection(const uint16_t x, const uint16_t y) const
   if ((x >= _width) || (y >= _height)) {
     Log::fatal("Force_field::get_velocity10(): x or y out of range");
   }
-  return _op_field[y * _width + x].is_reflection;
+  return Velocity_op::is_reflection(_ops->get_op(x, y));
 }
 
 const bool
@@ -276,7 +417,22 @@ Force_field::is_exclusion_zone(const uint16_t x, const uint16_t y) const
   if ((x >= _width) || (y >= _height)) {
     Log::fatal("Force_field::get_velocity10(): x or y out of range");
   }
-  return _op_field[y * _width + x].is_exclusion_zone;
+  return Velocity_op::is_exclusion_zone(_ops->get_op(x, y));
+}
+
+const uint16_t
+Force_field::get_op(const uint16_t x, const uint16_t y) const
+{
+  if ((x >= _width) || (y >= _height)) {
+    Log::fatal("Force_field::get_op(): x or y out of range");
+  }
+  return _ops->get_op(x, y);
+}
+
+const Narrow_band *
+Force_field::get_ops() const
+{
+  return _ops;
 }
 
 /*
@@ -26,40 +26,87 @@
 #define FORCE_FIELD_HH
 
 #include <inttypes.h>
+#include <atomic>
 #include <sobel.hh>
 #include <point-3d.hh>
-#include <brush-field.hh>
+#include <ipotential-field.hh>
+#include <velocity-op.hh>
+#include <narrow-band.hh>
+#include <iworker-task.hh>
+#include <worker-pool.hh>
 
-class Force_field
+/*
+ * The velocity operation of each pixel of the playing field,
+ * computed from the level's potential field.  If a default op table
+ * cache is set (see Op_table_cache), the ops are mapped from the
+ * cache, if present, and stored into it otherwise.
+ *
+ * The ops are computed row-major in bands of rows that fit into the
+ * cache, distributed across a worker pool, concurrently to the
+ * field's border.
+ *
+ * The ops are kept in narrow-band form (see Narrow_band), dense only
+ * near walls.
+ *
+ * Walls are detected either from the exclusion zone of each pixel's
+ * neighbourhood and the level's average tangent (implicit curves),
+ * or from the gradient of the potentials (Sobel).
+ */
+class Force_field : private IWorker_task
 {
 public:
+  enum edge_detection_t {
+    EDGE_DETECTION_IMPLICIT_CURVES,
+    EDGE_DETECTION_SOBEL
+  };
+  static void set_default_edge_detection(const edge_detection_t
+                                         edge_detection);
+  static const edge_detection_t get_default_edge_detection();
   Force_field();
   virtual ~Force_field();
-  void load_field(const Brush_field *brush_field,
+  void set_worker_pool(Worker_pool *worker_pool);
+  void load_field(const IPotential_field *potential_field,
                   const uint16_t width, const uint16_t height);
   const double get_theta(const uint16_t x, const uint16_t y) const;
   const bool is_reflection(const uint16_t x, const uint16_t y) const;
   const bool is_exclusion_zone(const uint16_t x, const uint16_t y) const;
+  const uint16_t get_op(const uint16_t x, const uint16_t y) const;
+  const Narrow_band *get_ops() const;
   const uint16_t get_width() const;
   const uint16_t get_height() const;
+  const uint32_t get_generation() const;
+  const uint64_t get_level_hash() const;
 private:
+  static const uint16_t ROWS_PER_BAND = 16;
+  static edge_detection_t _default_edge_detection;
+  static std::atomic<uint32_t> _next_generation;
+  uint32_t _generation;
   uint16_t _width;
   uint16_t _height;
-  struct velocity_op_t {
-    double theta;
-    bool is_reflection;
-    bool is_exclusion_zone;
-  };
-  struct velocity_op_t *_op_field;
-  double *create_potential_field(const Brush_field *brush_field) const;
+  edge_detection_t _edge_detection;
+  uint64_t _level_hash;
+  Narrow_band *_ops;
+  Worker_pool *_worker_pool;
+
+  // only used while loading
+  const IPotential_field *_potential_field;
+  uint16_t *_op_field;
+
+  void free_op_field();
   void load_field_border();
-  void load_field(const uint16_t x, const uint16_t y,
-                  const Brush_field *brush_field,
-                  const Sobel *sobel);
+  void load_potential_row(const uint16_t y, double *potentials) const;
+  void load_sobel_row(const uint16_t y, const double *gx, const double *gy,
+                      const double *potentials);
+  void load_sobel_band(const uint32_t band);
   const bool is_exclusion_zone(const double x, const double y,
-                               const Brush_field *brush_field) const;
-  void load_field(const uint16_t x, const uint16_t y,
-                  const Brush_field *brush_field);
+                               const IPotential_field *potential_field) const;
+  void load_exclusion_row(const uint16_t y, const IPotential_field *field,
+                          uint8_t *exclusions) const;
+  void load_row(const uint16_t y, const IPotential_field *field,
+                const uint8_t *above, const uint8_t *row,
+                const uint8_t *below);
+  void load_band(const uint32_t band);
+  virtual void run_task(const uint32_t index);
 };
 
 #endif /* FORCE_FIELD_HH */
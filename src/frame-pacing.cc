@@ -0,0 +1,119 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <frame-pacing.hh>
+#include <cmath>
+#include <sstream>
+
+Frame_pacing::Frame_pacing(const double target_seconds) :
+  _target_seconds(target_seconds)
+{
+  reset();
+}
+
+Frame_pacing::~Frame_pacing()
+{
+}
+
+void
+Frame_pacing::add_frame(const double interval_seconds, const uint32_t steps)
+{
+  // Welford's online algorithm for mean and variance
+  _frame_count++;
+  const double delta = interval_seconds - _mean;
+  _mean += delta / _frame_count;
+  _squared_deviations += delta * (interval_seconds - _mean);
+  _max = interval_seconds > _max ? interval_seconds : _max;
+  if (interval_seconds > 1.5 * _target_seconds) {
+    _late_frame_count++;
+  }
+  _step_count += steps;
+}
+
+void
+Frame_pacing::reset()
+{
+  _frame_count = 0;
+  _mean = 0.0;
+  _squared_deviations = 0.0;
+  _max = 0.0;
+  _late_frame_count = 0;
+  _step_count = 0;
+}
+
+const uint64_t
+Frame_pacing::get_frame_count() const
+{
+  return _frame_count;
+}
+
+const double
+Frame_pacing::get_mean_interval() const
+{
+  return _mean;
+}
+
+const double
+Frame_pacing::get_jitter() const
+{
+  return _frame_count > 1 ? sqrt(_squared_deviations / _frame_count) : 0.0;
+}
+
+const double
+Frame_pacing::get_max_interval() const
+{
+  return _max;
+}
+
+const uint64_t
+Frame_pacing::get_late_frame_count() const
+{
+  return _late_frame_count;
+}
+
+const double
+Frame_pacing::get_mean_steps() const
+{
+  return _frame_count > 0 ? ((double)_step_count) / _frame_count : 0.0;
+}
+
+const std::string
+Frame_pacing::to_string() const
+{
+  std::stringstream str;
+  str << "frames=" << _frame_count <<
+    ", interval=" << (get_mean_interval() * 1000.0) << "ms" <<
+    " +/- " << (get_jitter() * 1000.0) << "ms" <<
+    ", max=" << (get_max_interval() * 1000.0) << "ms" <<
+    ", late=" << _late_frame_count <<
+    ", steps/frame=" << get_mean_steps();
+  return str.str();
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,68 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef FRAME_PACING_HH
+#define FRAME_PACING_HH
+
+#include <inttypes.h>
+#include <string>
+
+/*
+ * Statistics of the intervals between rendered frames: mean, jitter
+ * (standard deviation), maximum, and frames that came late by more
+ * than half of the target interval, together with the number of
+ * physics steps per frame.
+ */
+class Frame_pacing
+{
+public:
+  Frame_pacing(const double target_seconds);
+  virtual ~Frame_pacing();
+  void add_frame(const double interval_seconds, const uint32_t steps);
+  void reset();
+  const uint64_t get_frame_count() const;
+  const double get_mean_interval() const;
+  const double get_jitter() const;
+  const double get_max_interval() const;
+  const uint64_t get_late_frame_count() const;
+  const double get_mean_steps() const;
+  const std::string to_string() const;
+private:
+  const double _target_seconds;
+  uint64_t _frame_count;
+  double _mean;
+  double _squared_deviations;
+  double _max;
+  uint64_t _late_frame_count;
+  uint64_t _step_count;
+};
+
+#endif /* FRAME_PACING_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,60 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef IPOTENTIAL_FIELD_HH
+#define IPOTENTIAL_FIELD_HH
+
+#include <inttypes.h>
+
+/*
+ * The IPotential_field interface provides the physics with all
+ * information it needs from the level's definition, without
+ * depending on the Qt based brushes of the tiles.  Coordinates are
+ * normalized to the range [0.0, 1.0).
+ */
+class IPotential_field
+{
+public:
+  virtual const double get_potential(const double x, const double y) const = 0;
+  virtual const double get_avg_tan(const double x, const double y) const = 0;
+  virtual const bool matches_goal(const double x, const double y) const = 0;
+
+  /*
+   * Returns a hash of everything that determines the potentials, such
+   * that precomputed forces can be cached across runs, or 0, if the
+   * potentials must not be cached.
+   */
+  virtual const uint64_t get_level_hash() const = 0;
+protected:
+  ~IPotential_field() {};
+};
+
+#endif /* IPOTENTIAL_FIELD_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,49 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef ISENSORS_HH
+#define ISENSORS_HH
+
+/*
+ * The ISensors interface decouples the physics from the Qt based
+ * sampling of the Sense Hat's sensors, such that balls can also be
+ * driven by other (e.g. scripted or recorded) tilt sources.
+ */
+class ISensors
+{
+public:
+  virtual const double get_pitch() const = 0;
+  virtual const double get_roll() const = 0;
+protected:
+  ~ISensors() {};
+};
+
+#endif /* ISENSORS_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -22,34 +22,24 @@
  * Author's web site: www.juergen-reuter.de
  */
 
-#ifndef IPLAYING_FIELD_HH
-#define IPLAYING_FIELD_HH
+#ifndef IWORKER_TASK_HH
+#define IWORKER_TASK_HH
 
 #include <inttypes.h>
-#include <QtGui/QPixmap>
-#include <point-3d.hh>
-#include <ball.hh>
 
 /*
- * The IPlaying_field interface helps avoiding an otherwise cyclic
- * inclusion dependency between balls.hh and playing-field.hh.
+ * A job that is split into independent, indexed tasks, such that a
+ * worker pool may run the tasks concurrently.
  */
-class IPlaying_field
+class IWorker_task
 {
 public:
-  virtual const uint16_t get_width() const = 0;
-  virtual const uint16_t get_height() const = 0;
-  virtual void invalidate_rect(const double px, const double py,
-                               const uint16_t pixmap_width,
-                               const uint16_t pixmap_height,
-                               const uint16_t pixmap_origin_x,
-                               const uint16_t pixmap_origin_y) = 0;
-  virtual const bool matches_goal(const double px, const double py) const = 0;
+  virtual void run_task(const uint32_t index) = 0;
 protected:
-  ~IPlaying_field() {};
+  ~IWorker_task() {};
 };
 
-#endif /* IPLAYING_FIELD_HH */
+#endif /* IWORKER_TASK_HH */
 
 /*
  * Local variables:
@@ -0,0 +1,434 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <level-validator.hh>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <log.hh>
+
+// the Qt front-end's step interval, for conversion into game time
+const double
+Level_validator::STEP_SECONDS = 0.05;
+
+const uint32_t
+Level_validator::STUCK_CHECK_STEPS = 20;
+
+const double
+Level_validator::STUCK_TILES = 0.25;
+
+/*
+ * The potential field must already have been informed about the
+ * given geometry.  The balls' init data must live as long as the
+ * validator.
+ */
+Level_validator::Level_validator(const IPotential_field *potential_field,
+                                 const std::vector<const Ball_init_data *>
+                                 balls_init_data,
+                                 const uint16_t rows, const uint16_t columns,
+                                 const uint16_t width, const uint16_t height) :
+  _potential_field(potential_field),
+  _balls_init_data(balls_init_data),
+  _rows(rows),
+  _columns(columns),
+  _width(width),
+  _height(height)
+{
+  if (!potential_field) {
+    Log::fatal("Level_validator(): potential_field is null");
+  }
+  _tilt_mode = Tilt_script::MODE_RANDOM;
+  _max_tilt = 0.3;
+  _oversampling = 100;
+  _random_seed = 1;
+  _worker_pool = Worker_pool::get_default();
+  _next_game = 0;
+  _game_count = 0;
+  _max_steps = 0;
+  _won_game_count = 0;
+  _step_count = 0;
+  _elapsed_seconds = 0.0;
+  find_goal_tiles();
+}
+
+Level_validator::~Level_validator()
+{
+  // the first slot's balls own the field that all slots share
+  for (std::vector<slot_t>::reverse_iterator it = _slots.rbegin();
+       it != _slots.rend(); it++) {
+    delete it->balls;
+    it->balls = 0;
+  }
+  _potential_field = 0;
+  _worker_pool = 0;
+}
+
+/*
+ * Samples each tile on a grid, since a goal may cover only part of
+ * its tile.
+ */
+void
+Level_validator::find_goal_tiles()
+{
+  const uint16_t samples = 5;
+  _is_goal_tile.assign(_rows * _columns, false);
+  for (uint16_t row = 0; row < _rows; row++) {
+    for (uint16_t column = 0; column < _columns; column++) {
+      bool is_goal_tile = false;
+      for (uint16_t i = 0; i < samples * samples && !is_goal_tile; i++) {
+        const double x = (column + (i % samples + 0.5) / samples) / _columns;
+        const double y = (row + (i / samples + 0.5) / samples) / _rows;
+        is_goal_tile = _potential_field->matches_goal(x, y);
+      }
+      _is_goal_tile[row * _columns + column] = is_goal_tile;
+    }
+  }
+}
+
+void
+Level_validator::set_tilt_mode(const Tilt_script::mode_t tilt_mode)
+{
+  _tilt_mode = tilt_mode;
+}
+
+void
+Level_validator::set_max_tilt(const double max_tilt)
+{
+  _max_tilt = max_tilt;
+}
+
+void
+Level_validator::set_oversampling(const uint16_t oversampling)
+{
+  _oversampling = oversampling;
+}
+
+void
+Level_validator::set_random_seed(const uint32_t random_seed)
+{
+  _random_seed = random_seed;
+}
+
+/*
+ * Sets the pool to play games on, or plays all games on the calling
+ * thread, if null.  Changing the pool takes effect with the next
+ * run only, if the balls have not yet been created.
+ */
+void
+Level_validator::set_worker_pool(Worker_pool *worker_pool)
+{
+  _worker_pool = worker_pool;
+}
+
+const uint32_t
+Level_validator::get_tile(const double px, const double py) const
+{
+  const int32_t column =
+    std::min(std::max((int32_t)floor(px * _columns), 0), _columns - 1);
+  const int32_t row =
+    std::min(std::max((int32_t)floor(py * _rows), 0), _rows - 1);
+  return row * _columns + column;
+}
+
+/*
+ * Plays the given number of games, each of at most the given number
+ * of steps, and replaces the results of any previous run.
+ */
+void
+Level_validator::run(const uint32_t game_count, const uint32_t max_steps)
+{
+  if (_slots.empty()) {
+    const uint16_t slot_count =
+      _worker_pool ? _worker_pool->get_thread_count() : 1;
+    _slots.resize(slot_count);
+    for (slot_t &slot : _slots) {
+      slot.balls = new Balls(_balls_init_data, _rows, _columns);
+      if (!slot.balls) {
+        Log::fatal("Level_validator::run(): not enough memory");
+      }
+      // games rather than balls run in parallel
+      slot.balls->set_worker_pool(0);
+      if (&slot == &_slots[0]) {
+        slot.balls->load_field(_potential_field, _width, _height);
+      } else {
+        slot.balls->share_field(_slots[0].balls);
+      }
+    }
+  }
+  const uint16_t ball_count = _balls_init_data.size();
+  for (slot_t &slot : _slots) {
+    slot.goal_steps.clear();
+    slot.unreached_counts.assign(ball_count, 0);
+    slot.goal_counts.assign(_rows * _columns, 0);
+    slot.stuck_counts.assign(_rows * _columns, 0);
+    slot.won_game_count = 0;
+    slot.step_count = 0;
+  }
+  _game_count = game_count;
+  _max_steps = max_steps;
+  _next_game = 0;
+  const std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  if (_worker_pool) {
+    _worker_pool->run(this, _slots.size());
+  } else {
+    run_task(0);
+  }
+  const std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+  _elapsed_seconds = elapsed.count();
+
+  _goal_steps.clear();
+  _unreached_counts.assign(ball_count, 0);
+  _goal_counts.assign(_rows * _columns, 0);
+  _stuck_counts.assign(_rows * _columns, 0);
+  _won_game_count = 0;
+  _step_count = 0;
+  for (const slot_t &slot : _slots) {
+    _goal_steps.insert(_goal_steps.end(),
+                       slot.goal_steps.begin(), slot.goal_steps.end());
+    for (uint16_t i = 0; i < ball_count; i++) {
+      _unreached_counts[i] += slot.unreached_counts[i];
+    }
+    for (uint32_t tile = 0; tile < _rows * _columns; tile++) {
+      _goal_counts[tile] += slot.goal_counts[tile];
+      _stuck_counts[tile] += slot.stuck_counts[tile];
+    }
+    _won_game_count += slot.won_game_count;
+    _step_count += slot.step_count;
+  }
+  std::sort(_goal_steps.begin(), _goal_steps.end());
+}
+
+void
+Level_validator::run_task(const uint32_t index)
+{
+  slot_t *slot = &_slots[index];
+  uint32_t game;
+  while ((game = _next_game++) < _game_count) {
+    play(slot, game);
+  }
+}
+
+void
+Level_validator::play(slot_t *slot, const uint32_t game)
+{
+  Balls *balls = slot->balls;
+  const uint16_t ball_count = balls->get_count();
+  Tilt_script tilt_script(_tilt_mode, _max_tilt, _random_seed, game);
+  balls->restart();
+  balls->set_random_seed(_random_seed + game);
+  balls->set_sensors(&tilt_script);
+  std::vector<double> check_px(ball_count), check_py(ball_count);
+  for (uint16_t i = 0; i < ball_count; i++) {
+    check_px[i] = balls->at(i)->get_position()->get_x();
+    check_py[i] = balls->at(i)->get_position()->get_y();
+  }
+  uint32_t step = 0;
+  while ((step < _max_steps) && !balls->all_balls_in_goal()) {
+    tilt_script.set_step(step);
+    balls->step(_oversampling);
+    step++;
+    Balls::event_t event;
+    while (balls->poll_event(&event)) {
+      if (event.type == Balls::EVENT_GOAL) {
+        slot->goal_steps.push_back(event.step);
+        slot->goal_counts[get_tile(event.px, event.py)]++;
+      }
+    }
+    if (step % STUCK_CHECK_STEPS == 0) {
+      for (uint16_t i = 0; i < ball_count; i++) {
+        const Ball *ball = balls->at(i);
+        const double px = ball->get_position()->get_x();
+        const double py = ball->get_position()->get_y();
+        const double dx = (px - check_px[i]) * _columns;
+        const double dy = (py - check_py[i]) * _rows;
+        if (!ball->get_is_in_goal() &&
+            (dx * dx + dy * dy < STUCK_TILES * STUCK_TILES)) {
+          slot->stuck_counts[get_tile(px, py)]++;
+        }
+        check_px[i] = px;
+        check_py[i] = py;
+      }
+    }
+  }
+  if (balls->all_balls_in_goal()) {
+    slot->won_game_count++;
+  } else {
+    for (uint16_t i = 0; i < ball_count; i++) {
+      if (!balls->at(i)->get_is_in_goal()) {
+        slot->unreached_counts[i]++;
+      }
+    }
+  }
+  slot->step_count += step;
+  balls->set_sensors(0);
+}
+
+const uint32_t
+Level_validator::get_game_count() const
+{
+  return _game_count;
+}
+
+const uint32_t
+Level_validator::get_won_game_count() const
+{
+  return _won_game_count;
+}
+
+const uint64_t
+Level_validator::get_step_count() const
+{
+  return _step_count;
+}
+
+const double
+Level_validator::get_elapsed_seconds() const
+{
+  return _elapsed_seconds;
+}
+
+/*
+ * Returns the game time that the given quantile (0.0 to 1.0) of all
+ * balls that reached a goal took to reach it, or -1.0, if no ball
+ * ever reached a goal.
+ */
+const double
+Level_validator::get_goal_seconds(const double quantile) const
+{
+  if (_goal_steps.empty()) {
+    return -1.0;
+  }
+  const size_t index = (size_t)(quantile * (_goal_steps.size() - 1) + 0.5);
+  return _goal_steps[index] * STEP_SECONDS;
+}
+
+/*
+ * Returns the number of games, in which the ball with the given
+ * index did not reach any goal.
+ */
+const uint64_t
+Level_validator::get_unreached_count(const uint16_t ball_index) const
+{
+  return _unreached_counts[ball_index];
+}
+
+const uint16_t
+Level_validator::get_goal_tile_count() const
+{
+  return std::count(_is_goal_tile.begin(), _is_goal_tile.end(), true);
+}
+
+/*
+ * Returns the goal tiles that no ball reached in any game.
+ */
+const std::vector<Level_validator::hotspot_t>
+Level_validator::get_unreached_goals() const
+{
+  std::vector<hotspot_t> unreached_goals;
+  for (uint32_t tile = 0; tile < _rows * _columns; tile++) {
+    if (_is_goal_tile[tile] &&
+        (_goal_counts.empty() || !_goal_counts[tile])) {
+      unreached_goals.push_back({(uint16_t)(tile % _columns),
+                                 (uint16_t)(tile / _columns), 0});
+    }
+  }
+  return unreached_goals;
+}
+
+/*
+ * Returns up to the given number of tiles, where balls got stuck
+ * most often, each with the number of seconds that balls were stuck
+ * there in all games, in descending order.
+ */
+const std::vector<Level_validator::hotspot_t>
+Level_validator::get_hotspots(const uint16_t max_count) const
+{
+  std::vector<hotspot_t> hotspots;
+  for (uint32_t tile = 0; tile < _stuck_counts.size(); tile++) {
+    if (_stuck_counts[tile]) {
+      hotspots.push_back({(uint16_t)(tile % _columns),
+                          (uint16_t)(tile / _columns),
+                          _stuck_counts[tile]});
+    }
+  }
+  std::stable_sort(hotspots.begin(), hotspots.end(),
+                   [](const hotspot_t &a, const hotspot_t &b) {
+                     return a.count > b.count;
+                   });
+  if (hotspots.size() > max_count) {
+    hotspots.resize(max_count);
+  }
+  return hotspots;
+}
+
+const std::string
+Level_validator::to_string() const
+{
+  std::stringstream str;
+  const double game_seconds = _step_count * STEP_SECONDS;
+  str << "games: " << _game_count << " (" << _won_game_count <<
+    " won), max steps=" << _max_steps << ", threads=" << _slots.size() <<
+    std::endl;
+  str << "  elapsed:      " << _elapsed_seconds << "s for " <<
+    game_seconds << "s game time (" <<
+    (game_seconds / _elapsed_seconds) << "x real time)" << std::endl;
+  if (_goal_steps.empty()) {
+    str << "  time to goal: no ball ever reached a goal" << std::endl;
+  } else {
+    str << "  time to goal: min=" << get_goal_seconds(0.0) <<
+      "s, p10=" << get_goal_seconds(0.1) <<
+      "s, p50=" << get_goal_seconds(0.5) <<
+      "s, p90=" << get_goal_seconds(0.9) <<
+      "s, max=" << get_goal_seconds(1.0) << "s" << std::endl;
+  }
+  for (uint16_t i = 0; i < _unreached_counts.size(); i++) {
+    if (_unreached_counts[i]) {
+      str << "  ball " << i << " (column " <<
+        _balls_init_data[i]->get_column() << ", row " <<
+        _balls_init_data[i]->get_row() << "): no goal in " <<
+        _unreached_counts[i] << " of " << _game_count << " games" <<
+        std::endl;
+    }
+  }
+  str << "  goal tiles:   " << get_goal_tile_count();
+  for (const hotspot_t &goal : get_unreached_goals()) {
+    str << ", unreached at column " << goal.column << ", row " << goal.row;
+  }
+  str << std::endl;
+  for (const hotspot_t &hotspot : get_hotspots(8)) {
+    str << "  stuck:        column " << hotspot.column << ", row " <<
+      hotspot.row << ": " << hotspot.count << "s" << std::endl;
+  }
+  return str.str();
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,133 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef LEVEL_VALIDATOR_HH
+#define LEVEL_VALIDATOR_HH
+
+#include <inttypes.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <ipotential-field.hh>
+#include <ball-init-data.hh>
+#include <balls.hh>
+#include <iworker-task.hh>
+#include <worker-pool.hh>
+#include <tilt-script.hh>
+
+/*
+ * Plays many headless games of a level in parallel to find out
+ * whether and how fast the level can be solved, without Qt.  Each
+ * game is driven by a random or scripted tilt (see Tilt_script), and
+ * runs until all balls are in the goal or the step limit is reached.
+ * The validator collects the time each ball took to reach a goal,
+ * balls that never reached any goal, goal tiles that no ball ever
+ * reached, and tiles where balls got stuck, i.e. hardly moved for a
+ * second.
+ *
+ * Each worker thread plays its games on its own set of balls, but
+ * the force field and the balls' forces are loaded only once and
+ * shared by all threads (see Balls::share_field()).  The tilt of a
+ * game depends only on the seed and the game's index, hence results
+ * do not depend on the number of threads.
+ */
+class Level_validator : private IWorker_task
+{
+public:
+  struct hotspot_t {
+    uint16_t column;
+    uint16_t row;
+    uint64_t count;
+  };
+  Level_validator(const IPotential_field *potential_field,
+                  const std::vector<const Ball_init_data *> balls_init_data,
+                  const uint16_t rows, const uint16_t columns,
+                  const uint16_t width, const uint16_t height);
+  virtual ~Level_validator();
+  void set_tilt_mode(const Tilt_script::mode_t tilt_mode);
+  void set_max_tilt(const double max_tilt);
+  void set_oversampling(const uint16_t oversampling);
+  void set_random_seed(const uint32_t random_seed);
+  void set_worker_pool(Worker_pool *worker_pool);
+  void run(const uint32_t game_count, const uint32_t max_steps);
+  const uint32_t get_game_count() const;
+  const uint32_t get_won_game_count() const;
+  const uint64_t get_step_count() const;
+  const double get_elapsed_seconds() const;
+  const double get_goal_seconds(const double quantile) const;
+  const uint64_t get_unreached_count(const uint16_t ball_index) const;
+  const uint16_t get_goal_tile_count() const;
+  const std::vector<hotspot_t> get_unreached_goals() const;
+  const std::vector<hotspot_t> get_hotspots(const uint16_t max_count) const;
+  const std::string to_string() const;
+private:
+  static const double STEP_SECONDS;
+  static const uint32_t STUCK_CHECK_STEPS;
+  static const double STUCK_TILES;
+  struct slot_t {
+    Balls *balls;
+    std::vector<uint64_t> goal_steps;
+    std::vector<uint64_t> unreached_counts;
+    std::vector<uint64_t> goal_counts;
+    std::vector<uint64_t> stuck_counts;
+    uint32_t won_game_count;
+    uint64_t step_count;
+  };
+  const IPotential_field *_potential_field;
+  const std::vector<const Ball_init_data *> _balls_init_data;
+  const uint16_t _rows;
+  const uint16_t _columns;
+  const uint16_t _width;
+  const uint16_t _height;
+  Tilt_script::mode_t _tilt_mode;
+  double _max_tilt;
+  uint16_t _oversampling;
+  uint32_t _random_seed;
+  Worker_pool *_worker_pool;
+  std::vector<slot_t> _slots;
+  std::vector<bool> _is_goal_tile;
+  std::atomic<uint32_t> _next_game;
+  uint32_t _game_count;
+  uint32_t _max_steps;
+  uint32_t _won_game_count;
+  uint64_t _step_count;
+  double _elapsed_seconds;
+  std::vector<uint64_t> _goal_steps;
+  std::vector<uint64_t> _unreached_counts;
+  std::vector<uint64_t> _goal_counts;
+  std::vector<uint64_t> _stuck_counts;
+  void find_goal_tiles();
+  void play(slot_t *slot, const uint32_t game);
+  const uint32_t get_tile(const double px, const double py) const;
+  virtual void run_task(const uint32_t index);
+};
+
+#endif /* LEVEL_VALIDATOR_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,93 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <mapped-file.hh>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <log.hh>
+
+/*
+ * Maps the file with the given path, or returns null, if the file
+ * does not exist, is empty or can not be mapped.
+ */
+Mapped_file *
+Mapped_file::open(const char *path)
+{
+  const int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    return 0;
+  }
+  struct stat file_stat;
+  if ((fstat(fd, &file_stat) < 0) || (file_stat.st_size <= 0)) {
+    close(fd);
+    return 0;
+  }
+  const size_t size = file_stat.st_size;
+  void *data =
+    mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  // the mapping keeps the file referenced
+  close(fd);
+  if (data == MAP_FAILED) {
+    return 0;
+  }
+  Mapped_file *mapped_file = new Mapped_file((uint8_t *)data, size);
+  if (!mapped_file) {
+    Log::fatal("Mapped_file::open(): not enough memory");
+  }
+  return mapped_file;
+}
+
+Mapped_file::Mapped_file(uint8_t *data, const size_t size) :
+  _data(data),
+  _size(size)
+{
+}
+
+Mapped_file::~Mapped_file()
+{
+  munmap(_data, _size);
+  _data = 0;
+  _size = 0;
+}
+
+uint8_t *
+Mapped_file::get_data() const
+{
+  return _data;
+}
+
+const size_t
+Mapped_file::get_size() const
+{
+  return _size;
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
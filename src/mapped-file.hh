@@ -0,0 +1,56 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef MAPPED_FILE_HH
+#define MAPPED_FILE_HH
+
+#include <inttypes.h>
+#include <cstddef>
+
+/*
+ * A file mapped into memory as a private copy-on-write mapping, such
+ * that its pages are loaded on demand and shared with the page cache,
+ * while writes to the data never reach the file.
+ */
+class Mapped_file
+{
+public:
+  static Mapped_file *open(const char *path);
+  virtual ~Mapped_file();
+  uint8_t *get_data() const;
+  const size_t get_size() const;
+private:
+  uint8_t *_data;
+  size_t _size;
+  Mapped_file(uint8_t *data, const size_t size);
+};
+
+#endif /* MAPPED_FILE_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
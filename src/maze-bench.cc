@@ -0,0 +1,1732 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <ifield-geometry-listener.hh>
+#include <ipotential-field.hh>
+#include <isensors.hh>
+#include <bivariate-quadratic-function.hh>
+#include <ball-init-data.hh>
+#include <balls.hh>
+#include <ball-array.hh>
+#include <ball-footprint.hh>
+#include <ball-forces.hh>
+#include <fixed-timestep.hh>
+#include <force-field.hh>
+#include <frame-pacing.hh>
+#include <level-validator.hh>
+#include <op-table-cache.hh>
+#include <physics-thread.hh>
+#include <distance-field.hh>
+#include <spatial-hash.hh>
+#include <substep-budget.hh>
+#include <tilt-script.hh>
+#include <trace-player.hh>
+#include <trace-recorder.hh>
+#include <velocity-op.hh>
+#include <worker-pool.hh>
+#include <log.hh>
+
+/*
+ * Headless benchmark of the physics engine.  To neither depend on Qt
+ * nor on the XML parser, the benchmark runs on a synthetic level that
+ * resembles the field of the default config.xml.
+ */
+
+#define EPSILON 0.0001
+
+// tick rate and oversampling of the Qt front-end, for comparison of
+// benchmark results with real time
+#define TICKS_PER_SECOND 20
+#define DEFAULT_OVERSAMPLING 100
+
+class Bench_field : public IPotential_field, public IField_geometry_listener
+{
+public:
+  Bench_field();
+  virtual ~Bench_field();
+  const uint16_t get_columns() const;
+  const uint16_t get_rows() const;
+  virtual const double get_potential(const double x, const double y) const;
+  virtual const double get_avg_tan(const double x, const double y) const;
+  virtual const bool matches_goal(const double x, const double y) const;
+  virtual const uint64_t get_level_hash() const;
+  virtual void geometry_changed(const uint16_t width, const uint16_t height);
+private:
+  static const uint16_t COLUMNS;
+  static const uint16_t ROWS;
+  static const char *LAYOUT[];
+  static const char *SHAPE_TILES;
+  double _tile_pixel_width, _tile_pixel_height;
+  std::vector<const Bivariate_quadratic_function *> _shapes;
+  const Bivariate_quadratic_function *get_shape(const double x,
+                                                const double y,
+                                                double *tile_offset_x,
+                                                double *tile_offset_y,
+                                                bool *is_border,
+                                                char *tile) const;
+};
+
+const uint16_t
+Bench_field::COLUMNS = 32;
+
+const uint16_t
+Bench_field::ROWS = 16;
+
+// '#': solid wall, '.': corridor, 'o': pillar, '0': hole (goal),
+// 'a'..'d': rounded wall corners
+const char *
+Bench_field::LAYOUT[] = {
+  "################################",
+  "###########d....c###############",
+  "##............................##",
+  "##............................##",
+  "###########b....a##b.....0....##",
+  "##..##....##....######b.......##",
+  "##..##..a###....################",
+  "##..cd..c##d....c###############",
+  "##............................##",
+  "##...o........................##",
+  "##......a##############b..ab..##",
+  "##......c##############d..cd..##",
+  "##..........####..............##",
+  "##..........####..............##",
+  "###########################b..##",
+  "################################",
+};
+
+const char *
+Bench_field::SHAPE_TILES = "#.o0abcd";
+
+Bench_field::Bench_field() :
+  _tile_pixel_width(0.0),
+  _tile_pixel_height(0.0)
+{
+  // indexed like SHAPE_TILES
+  const double weights[][6] = {
+    {0.0, 0.0, 0.0, 0.0, 0.0, -1.0},
+    {0.0, 0.0, 0.0, 0.0, 0.0, +1.0},
+    {+1.0, 0.0, +1.0, -1.0, -1.0, +0.25},
+    {-1.0, 0.0, -1.0, +1.0, +1.0, -0.25},
+    {+1.0, 0.0, +1.0, -2.0, -2.0, +1.0},
+    {+1.0, 0.0, +1.0, -2.0, 0.0, 0.0},
+    {+1.0, 0.0, +1.0, 0.0, -2.0, 0.0},
+    {+1.0, 0.0, +1.0, 0.0, 0.0, -1.0}
+  };
+  for (const double *w : weights) {
+    const Bivariate_quadratic_function *shape =
+      new Bivariate_quadratic_function(w[0], w[1], w[2], w[3], w[4], w[5]);
+    if (!shape) {
+      Log::fatal("Bench_field(): not enough memory");
+    }
+    _shapes.push_back(shape);
+  }
+}
+
+Bench_field::~Bench_field()
+{
+  for (const Bivariate_quadratic_function *shape : _shapes) {
+    delete shape;
+  }
+  _shapes.clear();
+}
+
+const uint16_t
+Bench_field::get_columns() const
+{
+  return COLUMNS;
+}
+
+const uint16_t
+Bench_field::get_rows() const
+{
+  return ROWS;
+}
+
+void
+Bench_field::geometry_changed(const uint16_t width, const uint16_t height)
+{
+  _tile_pixel_width = width ? (1.0 + EPSILON) * COLUMNS / width : 0.0;
+  _tile_pixel_height = height ? (1.0 + EPSILON) * ROWS / height : 0.0;
+}
+
+const Bivariate_quadratic_function *
+Bench_field::get_shape(const double x, const double y,
+                       double *tile_offset_x, double *tile_offset_y,
+                       bool *is_border, char *tile) const
+{
+  if ((x < 0.0) || (x >= 1.0) || (y < 0.0) || (y >= 1.0)) {
+    Log::fatal("Bench_field::get_shape(): x or y out of range");
+  }
+  const double pos_x = x * COLUMNS;
+  const double pos_y = y * ROWS;
+  const uint16_t column = (uint16_t)pos_x;
+  const uint16_t row = (uint16_t)pos_y;
+  *tile_offset_x = pos_x - column;
+  *tile_offset_y = pos_y - row;
+  *is_border =
+    (*tile_offset_x < _tile_pixel_width) ||
+    (*tile_offset_y < _tile_pixel_height) ||
+    (*tile_offset_x > 1.0 - _tile_pixel_width) ||
+    (*tile_offset_y > 1.0 - _tile_pixel_height);
+  *tile = LAYOUT[row][column];
+  const char *shape_tile = strchr(SHAPE_TILES, *tile);
+  if (!shape_tile) {
+    Log::fatal("Bench_field::get_shape(): unknown tile");
+  }
+  return _shapes[shape_tile - SHAPE_TILES];
+}
+
+const double
+Bench_field::get_potential(const double x, const double y) const
+{
+  double tile_offset_x, tile_offset_y;
+  bool is_border;
+  char tile;
+  const Bivariate_quadratic_function *shape =
+    get_shape(x, y, &tile_offset_x, &tile_offset_y, &is_border, &tile);
+  if (shape->is_inside(tile_offset_x, tile_offset_y)) {
+    // corner case: assume border of tiles is straight line of
+    // reflection, just like Brush_field does
+    return is_border ? 0.0 : 1.0;
+  }
+  return tile == '0' ? -1.0 : 0.0;
+}
+
+const double
+Bench_field::get_avg_tan(const double x, const double y) const
+{
+  double tile_offset_x, tile_offset_y;
+  bool is_border;
+  char tile;
+  const Bivariate_quadratic_function *shape =
+    get_shape(x, y, &tile_offset_x, &tile_offset_y, &is_border, &tile);
+  if (shape->is_inside(tile_offset_x, tile_offset_y) && is_border) {
+    if (tile_offset_x < _tile_pixel_width) {
+      return 0.0;
+    } else if (tile_offset_y > 1.0 - _tile_pixel_height) {
+      return 0.5 * M_PI;
+    } else if (tile_offset_x > 1.0 - _tile_pixel_width) {
+      return M_PI;
+    } else {
+      return -0.5 * M_PI;
+    }
+  }
+  return shape->get_avg_tan(tile_offset_x, tile_offset_y);
+}
+
+const bool
+Bench_field::matches_goal(const double x, const double y) const
+{
+  return get_potential(x, y) < 0.0;
+}
+
+/*
+ * The shapes are fixed, hence the layout determines the potentials.
+ */
+const uint64_t
+Bench_field::get_level_hash() const
+{
+  uint64_t hash = Op_table_cache::hash(SHAPE_TILES, strlen(SHAPE_TILES));
+  for (uint16_t row = 0; row < ROWS; row++) {
+    hash = Op_table_cache::hash(LAYOUT[row], COLUMNS, hash);
+  }
+  return hash;
+}
+
+class Bench_sensors : public ISensors
+{
+public:
+  Bench_sensors(const double pitch, const double roll);
+  virtual const double get_pitch() const;
+  virtual const double get_roll() const;
+  void set_tilt(const double pitch, const double roll);
+private:
+  double _pitch;
+  double _roll;
+};
+
+Bench_sensors::Bench_sensors(const double pitch, const double roll) :
+  _pitch(pitch),
+  _roll(roll)
+{
+}
+
+const double
+Bench_sensors::get_pitch() const
+{
+  return _pitch;
+}
+
+const double
+Bench_sensors::get_roll() const
+{
+  return _roll;
+}
+
+void
+Bench_sensors::set_tilt(const double pitch, const double roll)
+{
+  _pitch = pitch;
+  _roll = roll;
+}
+
+static const double
+elapsed_seconds(const std::chrono::steady_clock::time_point start)
+{
+  const std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+static const std::vector<const Ball_init_data *>
+create_balls_init_data(const uint16_t count)
+{
+  std::vector<const Ball_init_data *> balls_init_data;
+  for (uint16_t i = 0; i < count; i++) {
+    // spread balls along the long corridors in rows 2, 3, 8 and 9
+    const uint16_t row = ((i & 0x1) ? 8 : 2) + ((i >> 1) & 0x1);
+    const uint16_t column = 2 + (i >> 2) % 28;
+    const double align_x = 0.5;
+    const double align_y = 0.5;
+    const double vx = 0.000020 * cos(0.7 * i);
+    const double vy = 0.000011 * sin(0.7 * i + 1.0);
+    const Ball_init_data *ball_init_data =
+      new Ball_init_data(column, row, align_x, align_y, vx, vy);
+    if (!ball_init_data) {
+      Log::fatal("create_balls_init_data(): not enough memory");
+    }
+    balls_init_data.push_back(ball_init_data);
+  }
+  return balls_init_data;
+}
+
+static Balls *
+create_balls(const Bench_field *field, const uint16_t count)
+{
+  const std::vector<const Ball_init_data *> balls_init_data =
+    create_balls_init_data(count);
+  Balls *balls = new Balls(balls_init_data,
+                           field->get_rows(), field->get_columns());
+  if (!balls) {
+    Log::fatal("create_balls(): not enough memory");
+  }
+  for (const Ball_init_data *ball_init_data : balls_init_data) {
+    delete ball_init_data;
+  }
+  return balls;
+}
+
+/*
+ * Runs the physics as fast as possible for the given number of ticks
+ * and reports the speedup relative to the Qt front-end's real time.
+ */
+static void
+bench_step(const uint16_t width, const uint16_t height,
+           const uint16_t ball_count, const uint32_t ticks,
+           const uint16_t thread_count)
+{
+  Bench_field field;
+  Bench_sensors sensors(0.0, 0.0);
+  Worker_pool worker_pool(thread_count);
+  Balls *balls = create_balls(&field, ball_count);
+  balls->set_sensors(&sensors);
+  balls->set_worker_pool(&worker_pool);
+
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  field.geometry_changed(width, height);
+  balls->load_field(&field, width, height);
+  const double load_seconds = elapsed_seconds(start);
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t tick = 0; tick < ticks; tick++) {
+    balls->step(DEFAULT_OVERSAMPLING);
+  }
+  const double step_seconds = elapsed_seconds(start);
+  const double simulated_seconds = ((double)ticks) / TICKS_PER_SECOND;
+  const double substeps = ((double)ticks) * DEFAULT_OVERSAMPLING * ball_count;
+
+  std::cout << "step: " << width << "x" << height <<
+    ", balls=" << ball_count << ", ticks=" << ticks <<
+    ", threads=" << thread_count << std::endl;
+  std::cout << "  load field:   " << load_seconds << "s" << std::endl;
+  std::cout << "  step:         " << step_seconds << "s (" <<
+    (substeps / step_seconds) << " ball substeps/s)" << std::endl;
+  std::cout << "  vs real time: " <<
+    (simulated_seconds / step_seconds) << "x" << std::endl;
+#if PHYSICS_DIAGNOSTICS
+  Ball::stats_t stats;
+  balls->get_stats(&stats);
+  std::cout << "  stats:        max |vx|=" << stats.max_vx <<
+    ", max |vy|=" << stats.max_vy << ", boundary hits=" <<
+    stats.boundary_hit_count << ", clamps=" << stats.clamp_count <<
+    std::endl;
+#else
+  std::cout << "  stats:        compiled out" << std::endl;
+#endif
+  for (uint8_t i = 0; i < balls->get_count() && i < 4; i++) {
+    const Ball *ball = balls->at(i);
+    std::cout << "  ball " << (int)i << ": px=" <<
+      ball->get_position()->get_x() << ", py=" <<
+      ball->get_position()->get_y() << std::endl;
+  }
+  delete balls;
+}
+
+/*
+ * Loads the field onto physics grids of several resolutions per
+ * tile, as the Qt front-end does independent of its window size, and
+ * reports the cost of loading and stepping each.
+ */
+static void
+bench_grid(const uint16_t ball_count, const uint32_t ticks)
+{
+  const uint16_t cells_per_tile[] = {15, Balls::DEFAULT_CELLS_PER_TILE, 40};
+  Bench_field field;
+  Bench_sensors sensors(0.1, 0.05);
+  std::cout << "grid: balls=" << ball_count << ", ticks=" << ticks <<
+    std::endl;
+  std::cout << "  cells/tile  grid  load[ms]  step[ms]  ball 0" << std::endl;
+  for (const uint16_t cells : cells_per_tile) {
+    Balls *balls = create_balls(&field, ball_count);
+    balls->set_sensors(&sensors);
+    const uint16_t width = Balls::get_grid_width(field.get_columns(), cells);
+    const uint16_t height = Balls::get_grid_height(field.get_rows(), cells);
+    std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    field.geometry_changed(width, height);
+    balls->load_field(&field, width, height);
+    const double load_seconds = elapsed_seconds(start);
+    start = std::chrono::steady_clock::now();
+    for (uint32_t tick = 0; tick < ticks; tick++) {
+      balls->step(DEFAULT_OVERSAMPLING);
+    }
+    const double step_seconds = elapsed_seconds(start) / ticks;
+    const Ball *ball = balls->at(0);
+    std::cout << "  " << cells << "  " << width << "x" << height << "  " <<
+      (load_seconds * 1000.0) << "  " << (step_seconds * 1000.0) <<
+      "  px=" << ball->get_position()->get_x() << ", py=" <<
+      ball->get_position()->get_y() << std::endl;
+    delete balls;
+  }
+}
+
+/*
+ * Compares the packed velocity operations against the unquantized
+ * double precision operations that they replace: memory footprint
+ * per pixel, and deviation of reflected velocities for a sweep of
+ * wall angles and incoming directions.
+ */
+static void
+bench_ops(const uint16_t width, const uint16_t height)
+{
+  // former unpacked per-pixel layouts, for comparison only
+  struct double_field_op_t {
+    double theta;
+    bool is_reflection;
+    bool is_exclusion_zone;
+  };
+  struct double_ball_op_t {
+    double m00, m10, m01, m11, theta;
+    bool is_reflection;
+    bool is_exclusion_zone;
+  };
+  const uint32_t pixels = ((uint32_t)width) * height;
+  const size_t double_bytes =
+    sizeof(struct double_field_op_t) + sizeof(struct double_ball_op_t);
+  const size_t packed_bytes = 2 * sizeof(uint16_t);
+
+  Bench_field field;
+  Balls *balls = create_balls(&field, 1);
+  field.geometry_changed(width, height);
+  balls->load_field(&field, width, height);
+  const Ball *ball = balls->at(0);
+  uint32_t reflections = 0;
+  for (uint16_t y = 0; y < height; y++) {
+    for (uint16_t x = 0; x < width; x++) {
+      if (ball->is_reflection(x, y)) {
+        reflections++;
+      }
+    }
+  }
+  delete balls;
+
+  const uint32_t angle_count = 100000;
+  const uint32_t direction_count = 16;
+  double max_angle_error = 0.0;
+  double sum_angle_error2 = 0.0;
+  double max_magnitude_error = 0.0;
+  for (uint32_t i = 0; i < angle_count; i++) {
+    const double theta = -M_PI + (2.0 * M_PI * i) / angle_count;
+    const uint16_t op = Velocity_op::encode(theta, true, false);
+    const struct Velocity_op::reflection_t *reflection =
+      Velocity_op::get_reflection(op);
+    for (uint32_t j = 0; j < direction_count; j++) {
+      const double phi = (2.0 * M_PI * j) / direction_count + 0.1;
+      const double vx = cos(phi);
+      const double vy = sin(phi);
+      const double exact_vx = -cos(2.0 * theta) * vx + sin(2.0 * theta) * vy;
+      const double exact_vy = sin(2.0 * theta) * vx + cos(2.0 * theta) * vy;
+      const double packed_vx =
+        -reflection->cos_2theta * vx + reflection->sin_2theta * vy;
+      const double packed_vy =
+        reflection->sin_2theta * vx + reflection->cos_2theta * vy;
+      double angle_error =
+        fabs(atan2(packed_vy, packed_vx) - atan2(exact_vy, exact_vx));
+      if (angle_error > M_PI) {
+        angle_error = 2.0 * M_PI - angle_error;
+      }
+      const double magnitude_error =
+        fabs(sqrt(packed_vx * packed_vx + packed_vy * packed_vy) - 1.0);
+      if (angle_error > max_angle_error) {
+        max_angle_error = angle_error;
+      }
+      if (magnitude_error > max_magnitude_error) {
+        max_magnitude_error = magnitude_error;
+      }
+      sum_angle_error2 += angle_error * angle_error;
+    }
+  }
+  const double rms_angle_error =
+    sqrt(sum_angle_error2 / (((double)angle_count) * direction_count));
+
+  std::cout << "ops: " << width << "x" << height <<
+    ", reflecting pixels=" << reflections << std::endl;
+  std::cout << "  bytes per pixel: " << packed_bytes << " packed vs. " <<
+    double_bytes << " double" << std::endl;
+  std::cout << "  bytes per field: " << (pixels * packed_bytes) <<
+    " packed vs. " << (pixels * double_bytes) << " double" << std::endl;
+  std::cout << "  reflection table: " <<
+    (sizeof(struct Velocity_op::reflection_t) *
+     (Velocity_op::THETA_STEPS >> 1)) << " bytes" << std::endl;
+  std::cout << "  reflected direction error: max=" <<
+    (max_angle_error / M_PI * 180.0) << "deg, rms=" <<
+    (rms_angle_error / M_PI * 180.0) << "deg" << std::endl;
+  std::cout << "  reflected magnitude error: max=" <<
+    max_magnitude_error << std::endl;
+}
+
+/*
+ * Precomputes the ball forces for a footprint of the given radius
+ * with both aggregation methods, and compares time and results.
+ */
+static void
+bench_forces(const uint16_t width, const uint16_t height,
+             const uint16_t radius)
+{
+  Bench_field field;
+  field.geometry_changed(width, height);
+  Force_field force_field;
+  force_field.load_field(&field, width, height);
+  const Ball_footprint footprint(2 * radius + 2, 2 * radius + 2,
+                                 radius, radius, radius);
+
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  const Ball_forces brute_force(&force_field, &footprint,
+                                Ball_forces::AGGREGATION_BRUTE_FORCE);
+  const double brute_force_seconds = elapsed_seconds(start);
+
+  start = std::chrono::steady_clock::now();
+  const Ball_forces summed_area(&force_field, &footprint,
+                                Ball_forces::AGGREGATION_SUMMED_AREA);
+  const double summed_area_seconds = elapsed_seconds(start);
+
+  uint32_t flag_mismatches = 0;
+  uint32_t theta_mismatches = 0;
+  uint16_t max_theta_delta = 0;
+  for (uint16_t y = 0; y < height; y++) {
+    for (uint16_t x = 0; x < width; x++) {
+      const uint16_t op1 = brute_force.get_op(x, y);
+      const uint16_t op2 = summed_area.get_op(x, y);
+      const uint16_t flags = ~Velocity_op::THETA_MASK;
+      if ((op1 & flags) != (op2 & flags)) {
+        flag_mismatches++;
+      } else if (Velocity_op::is_reflection(op1) && (op1 != op2)) {
+        theta_mismatches++;
+        uint16_t delta = (op1 - op2) & Velocity_op::THETA_MASK;
+        if (delta > (Velocity_op::THETA_STEPS >> 1)) {
+          delta = Velocity_op::THETA_STEPS - delta;
+        }
+        if (delta > max_theta_delta) {
+          max_theta_delta = delta;
+        }
+      }
+    }
+  }
+
+  std::cout << "forces: " << width << "x" << height <<
+    ", radius=" << radius << ", footprint runs=" <<
+    footprint.get_runs()->size() << ", threads=" <<
+    Worker_pool::get_default()->get_thread_count() << std::endl;
+  std::cout << "  brute force:  " << brute_force_seconds << "s" << std::endl;
+  std::cout << "  summed area:  " << summed_area_seconds << "s (" <<
+    (brute_force_seconds / summed_area_seconds) << "x)" << std::endl;
+  std::cout << "  mismatches:   flags=" << flag_mismatches <<
+    ", theta=" << theta_mismatches << " (max " << max_theta_delta <<
+    " steps)" << std::endl;
+}
+
+/*
+ * Precomputes the ball forces for fields narrower than the
+ * footprint's reach, where the footprint sticks out of the field on
+ * both sides, and compares both aggregation methods.
+ */
+static void
+bench_narrow(const uint16_t height, const uint16_t radius)
+{
+  for (uint16_t width = 1; width <= radius + 1; width++) {
+    bench_forces(width, height, radius);
+  }
+}
+
+/*
+ * Loads the field onto the balls, and steps them for the given
+ * number of ticks with the field tilted back and forth by up to
+ * max_tilt.  Calls on_tick after each tick.  Returns the time per
+ * tick, not counting on_tick.
+ */
+template<class F>
+static const double
+run_balls(Balls *balls, const Bench_field *field, const uint16_t width,
+          const uint16_t height, const uint32_t ticks,
+          const double max_tilt, F on_tick)
+{
+  Bench_sensors sensors(0.0, 0.0);
+  balls->set_sensors(&sensors);
+  balls->load_field(field, width, height);
+  // let a lazily built distance field not count as tick time
+  balls->step(0);
+  double seconds = 0.0;
+  for (uint32_t tick = 0; tick < ticks; tick++) {
+    const uint32_t sample = tick / 4;
+    sensors.set_tilt(max_tilt * sin(0.05 * sample),
+                     max_tilt * cos(0.03 * sample));
+    const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    balls->step(DEFAULT_OVERSAMPLING);
+    seconds += elapsed_seconds(start);
+    on_tick();
+  }
+  balls->set_sensors(0);
+  return seconds / ticks;
+}
+
+/*
+ * Stores the positions of all balls into positions.
+ */
+static void
+get_positions(const Balls *balls, std::vector<double> *positions)
+{
+  positions->clear();
+  for (uint16_t i = 0; i < balls->get_count(); i++) {
+    positions->push_back(balls->at(i)->get_position()->get_x());
+    positions->push_back(balls->at(i)->get_position()->get_y());
+  }
+}
+
+/*
+ * Steps the balls with the given storage on a game with the field
+ * tilted back and forth, and returns the time needed per tick.
+ * Stores the final positions into positions.
+ */
+static const double
+run_scale(const Bench_field *field, const uint16_t width,
+          const uint16_t height, const uint16_t ball_count,
+          const uint32_t ticks, Worker_pool *worker_pool,
+          const Balls::storage_t storage, std::vector<double> *positions)
+{
+  Balls *balls = create_balls(field, ball_count);
+  balls->set_worker_pool(worker_pool);
+  balls->set_storage(storage);
+  const double seconds =
+    run_balls(balls, field, width, height, ticks, 0.2, [](){});
+  get_positions(balls, positions);
+  delete balls;
+  return seconds;
+}
+
+/*
+ * Compares object and array storage of balls for 1 to 10,000 balls.
+ */
+static void
+bench_scale(const uint16_t width, const uint16_t height,
+            const uint32_t ticks, const uint16_t thread_count)
+{
+  Bench_field field;
+  field.geometry_changed(width, height);
+  Worker_pool worker_pool(thread_count);
+  std::cout << "scale: " << width << "x" << height << ", ticks=" <<
+    ticks << ", substeps=" << DEFAULT_OVERSAMPLING << ", threads=" <<
+    thread_count << std::endl;
+  std::cout << "  balls  objects[ms/tick]  arrays[ms/tick]  speedup" <<
+    "  identical" << std::endl;
+  const uint16_t ball_counts[] = { 1, 10, 100, 1000, 10000 };
+  for (const uint16_t ball_count : ball_counts) {
+    std::vector<double> object_positions, array_positions;
+    const double object_seconds =
+      run_scale(&field, width, height, ball_count, ticks, &worker_pool,
+                Balls::STORAGE_OBJECTS, &object_positions);
+    const double array_seconds =
+      run_scale(&field, width, height, ball_count, ticks, &worker_pool,
+                Balls::STORAGE_ARRAYS, &array_positions);
+    std::cout << "  " << ball_count << "  " << (object_seconds * 1000.0) <<
+      "  " << (array_seconds * 1000.0) << "  " <<
+      (object_seconds / array_seconds) << "x  " <<
+      (object_positions == array_positions ? "yes" : "no") << std::endl;
+  }
+}
+
+/*
+ * Runs balls in the given collision mode and reports time and
+ * position updates per tick, and how often ball centers ended up
+ * inside walls.
+ */
+static void
+run_collision_mode(const Bench_field *field, const uint16_t width,
+                   const uint16_t height, const uint16_t ball_count,
+                   const uint32_t ticks, const Balls::collision_mode_t mode,
+                   const char *label)
+{
+  Balls *balls = create_balls(field, ball_count);
+  balls->set_collision_mode(mode);
+  uint32_t penetrations = 0;
+  const double seconds_per_tick =
+    run_balls(balls, field, width, height, ticks, 0.0, [&]() {
+        const Force_field *force_field = balls->get_force_field();
+        for (uint16_t i = 0; i < balls->get_count(); i++) {
+          const Point_3D *position = balls->at(i)->get_position();
+          const uint16_t x = (uint16_t)(position->get_x() * width);
+          const uint16_t y = (uint16_t)(position->get_y() * height);
+          if (force_field->is_exclusion_zone(x, y)) {
+            penetrations++;
+          }
+        }
+      });
+  uint64_t iterations = 0;
+  for (uint16_t i = 0; i < balls->get_count(); i++) {
+    iterations += balls->at(i)->get_iteration_count();
+  }
+  std::cout << "  " << label << ": " << (seconds_per_tick * 1000.0) <<
+    "ms/tick, " << (((double)iterations) / ticks) <<
+    " position updates/tick" << std::endl;
+  std::cout << "    ball centers inside walls: " << penetrations << " of " <<
+    (((uint64_t)ticks) * ball_count) << std::endl;
+  for (uint8_t i = 0; i < balls->get_count() && i < 4; i++) {
+    const Ball *ball = balls->at(i);
+    std::cout << "    ball " << (int)i << ": px=" <<
+      ball->get_position()->get_x() << ", py=" <<
+      ball->get_position()->get_y() << std::endl;
+  }
+  delete balls;
+}
+
+/*
+ * Compares oversampled and swept collision detection.
+ */
+static void
+bench_sweep(const uint16_t width, const uint16_t height,
+            const uint16_t ball_count, const uint32_t ticks)
+{
+  Bench_field field;
+  field.geometry_changed(width, height);
+  std::cout << "sweep: " << width << "x" << height << ", balls=" <<
+    ball_count << ", ticks=" << ticks << ", substeps=" <<
+    DEFAULT_OVERSAMPLING << std::endl;
+  run_collision_mode(&field, width, height, ball_count, ticks,
+                     Balls::COLLISION_OVERSAMPLING, "oversampling");
+  run_collision_mode(&field, width, height, ball_count, ticks,
+                     Balls::COLLISION_SWEPT, "swept");
+}
+
+/*
+ * Compares fixed and distance field driven adaptive substeps.
+ */
+static void
+bench_adaptive(const uint16_t width, const uint16_t height,
+               const uint16_t ball_count, const uint32_t ticks)
+{
+  Bench_field field;
+  field.geometry_changed(width, height);
+  Force_field force_field;
+  force_field.load_field(&field, width, height);
+  const std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  const Distance_field distance_field(&force_field);
+  const double distance_field_seconds = elapsed_seconds(start);
+  std::cout << "adaptive: " << width << "x" << height << ", balls=" <<
+    ball_count << ", ticks=" << ticks << ", substeps=" <<
+    DEFAULT_OVERSAMPLING << std::endl;
+  std::cout << "  distance field: " << distance_field_seconds << "s" <<
+    std::endl;
+  run_collision_mode(&field, width, height, ball_count, ticks,
+                     Balls::COLLISION_OVERSAMPLING, "oversampling");
+  run_collision_mode(&field, width, height, ball_count, ticks,
+                     Balls::COLLISION_ADAPTIVE, "adaptive");
+}
+
+/*
+ * Micro-benchmark of the spatial hash broad phase against checking
+ * all pairs, for random points with ball radius on the given field.
+ */
+static void
+bench_broad_phase(const uint16_t width, const uint16_t height,
+                  const uint32_t count)
+{
+  const double radius = Ball_footprint::DEFAULT.get_radius();
+  std::vector<double> x(count), y(count);
+  unsigned int random_state = 1;
+  for (uint32_t i = 0; i < count; i++) {
+    x[i] = width * ((double)rand_r(&random_state) / RAND_MAX);
+    y[i] = height * ((double)rand_r(&random_state) / RAND_MAX);
+  }
+  const uint32_t rounds = count < 1000 ? 1000 : (count < 10000 ? 100 : 10);
+
+  std::vector<struct Spatial_hash::pair_t> pairs;
+  Spatial_hash spatial_hash;
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  for (uint32_t round = 0; round < rounds; round++) {
+    pairs.clear();
+    spatial_hash.build(x.data(), y.data(), count, 2.0 * radius);
+    spatial_hash.find_pairs(2.0 * radius, &pairs);
+  }
+  const double hash_seconds = elapsed_seconds(start) / rounds;
+
+  uint32_t brute_force_pairs = 0;
+  const uint32_t brute_force_rounds = count < 10000 ? rounds : 1;
+  start = std::chrono::steady_clock::now();
+  for (uint32_t round = 0; round < brute_force_rounds; round++) {
+    brute_force_pairs = 0;
+    for (uint32_t i = 0; i < count; i++) {
+      for (uint32_t j = i + 1; j < count; j++) {
+        const double delta_x = x[j] - x[i];
+        const double delta_y = y[j] - y[i];
+        if (delta_x * delta_x + delta_y * delta_y <
+            4.0 * radius * radius) {
+          brute_force_pairs++;
+        }
+      }
+    }
+  }
+  const double brute_force_seconds =
+    elapsed_seconds(start) / brute_force_rounds;
+  std::cout << "  " << count << " points: hash " <<
+    (hash_seconds * 1000000.0) << "us (" << pairs.size() <<
+    " pairs), all pairs " << (brute_force_seconds * 1000000.0) << "us (" <<
+    brute_force_pairs << " pairs)" << std::endl;
+}
+
+/*
+ * Steps colliding balls and returns the time per tick.  Stores the
+ * final positions into positions.
+ */
+static const double
+run_collide(const Bench_field *field, const uint16_t width,
+            const uint16_t height, const uint16_t ball_count,
+            const uint32_t ticks, Worker_pool *worker_pool,
+            const Balls::storage_t storage, std::vector<double> *positions,
+            uint64_t *collisions)
+{
+  Balls *balls = create_balls(field, ball_count);
+  balls->set_worker_pool(worker_pool);
+  balls->set_storage(storage);
+  balls->set_colliding_balls(true);
+  const double seconds =
+    run_balls(balls, field, width, height, ticks, 0.0, [](){});
+  get_positions(balls, positions);
+  *collisions = balls->get_ball_collision_count();
+  delete balls;
+  return seconds;
+}
+
+/*
+ * Benchmarks collisions between balls: the broad phase alone, and
+ * complete steps with object and array storage.
+ */
+static void
+bench_collide(const uint16_t width, const uint16_t height,
+              const uint16_t ball_count, const uint32_t ticks,
+              const uint16_t thread_count)
+{
+  Bench_field field;
+  field.geometry_changed(width, height);
+  std::cout << "collide: " << width << "x" << height << ", balls=" <<
+    ball_count << ", ticks=" << ticks << ", threads=" << thread_count <<
+    std::endl;
+  std::cout << "  broad phase:" << std::endl;
+  const uint32_t counts[] = { 100, 1000, 10000 };
+  for (const uint32_t count : counts) {
+    bench_broad_phase(width, height, count);
+  }
+  Worker_pool worker_pool(thread_count);
+  std::vector<double> object_positions, array_positions;
+  uint64_t object_collisions, array_collisions;
+  const double object_seconds =
+    run_collide(&field, width, height, ball_count, ticks, &worker_pool,
+                Balls::STORAGE_OBJECTS, &object_positions,
+                &object_collisions);
+  const double array_seconds =
+    run_collide(&field, width, height, ball_count, ticks, &worker_pool,
+                Balls::STORAGE_ARRAYS, &array_positions, &array_collisions);
+  std::cout << "  objects: " << (object_seconds * 1000.0) << "ms/tick, " <<
+    object_collisions << " collisions" << std::endl;
+  std::cout << "  arrays:  " << (array_seconds * 1000.0) << "ms/tick, " <<
+    array_collisions << " collisions" << std::endl;
+  std::cout << "  identical: " <<
+    (object_positions == array_positions ? "yes" : "no") << std::endl;
+}
+
+/*
+ * Runs the array kernel with scalar type T on a game with the field
+ * tilted back and forth, and returns the seconds per tick.  The
+ * balls' pixel positions at each checkpoint tick are appended to
+ * positions.
+ */
+template<class T>
+static const double
+run_scalar(const Bench_field *field, const uint16_t width,
+           const uint16_t height, const uint16_t ball_count,
+           const uint32_t ticks, const std::vector<uint32_t> &checkpoints,
+           std::vector<double> *positions)
+{
+  Balls *balls = create_balls(field, ball_count);
+  balls->load_field(field, width, height);
+  std::vector<Ball *> ball_objects;
+  for (uint16_t i = 0; i < balls->get_count(); i++) {
+    ball_objects.push_back(balls->at(i));
+  }
+  Ball_array<T> ball_array(ball_count);
+  if (!ball_array.load(&ball_objects)) {
+    Log::fatal("run_scalar(): failed loading balls");
+  }
+  double seconds = 0.0;
+  uint32_t checkpoint = 0;
+  for (uint32_t tick = 0; tick < ticks; tick++) {
+    const uint32_t sample = tick / 4;
+    const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    ball_array.step(0, ball_count, DEFAULT_OVERSAMPLING,
+                    0.2 * sin(0.05 * sample), 0.2 * cos(0.03 * sample));
+    seconds += elapsed_seconds(start);
+    if ((checkpoint < checkpoints.size()) &&
+        (tick + 1 == checkpoints[checkpoint])) {
+      ball_array.store(&ball_objects);
+      for (const Ball *ball : ball_objects) {
+        positions->push_back(ball->get_position()->get_x() * width);
+        positions->push_back(ball->get_position()->get_y() * height);
+      }
+      checkpoint++;
+    }
+  }
+  delete balls;
+  return seconds / ticks;
+}
+
+/*
+ * Compares throughput of the array kernel with double, float and
+ * fixed-point scalars, and the drift of float and fixed-point
+ * trajectories from the double ones.  Since collisions with walls
+ * amplify small deviations, drift is reported at increasing ticks.
+ */
+static void
+bench_scalar(const uint16_t width, const uint16_t height,
+             const uint16_t ball_count, const uint32_t ticks)
+{
+  Bench_field field;
+  field.geometry_changed(width, height);
+  std::vector<uint32_t> checkpoints;
+  for (uint32_t checkpoint = 1; checkpoint < ticks; checkpoint *= 10) {
+    checkpoints.push_back(checkpoint);
+  }
+  checkpoints.push_back(ticks);
+  std::vector<double> double_positions;
+  std::vector<double> float_positions;
+  std::vector<double> fixed_positions;
+  const double double_seconds =
+    run_scalar<double>(&field, width, height, ball_count, ticks,
+                       checkpoints, &double_positions);
+  const double float_seconds =
+    run_scalar<float>(&field, width, height, ball_count, ticks,
+                      checkpoints, &float_positions);
+  const double fixed_seconds =
+    run_scalar<Fixed_point>(&field, width, height, ball_count, ticks,
+                            checkpoints, &fixed_positions);
+  const double substeps = ((double)ball_count) * DEFAULT_OVERSAMPLING;
+  std::cout << "scalar: " << width << "x" << height << ", balls=" <<
+    ball_count << ", ticks=" << ticks << ", substeps=" <<
+    DEFAULT_OVERSAMPLING << std::endl;
+  std::cout << "  double: " << (double_seconds * 1000.0) << "ms/tick (" <<
+    (substeps / double_seconds) << " ball substeps/s)" << std::endl;
+  std::cout << "  float:  " << (float_seconds * 1000.0) << "ms/tick (" <<
+    (substeps / float_seconds) << " ball substeps/s)" << std::endl;
+  std::cout << "  fixed:  " << (fixed_seconds * 1000.0) << "ms/tick (" <<
+    (substeps / fixed_seconds) << " ball substeps/s)" << std::endl;
+  std::cout << "  drift from double in pixels (mean / max):" << std::endl;
+  for (uint32_t checkpoint = 0; checkpoint < checkpoints.size();
+       checkpoint++) {
+    double float_sum = 0.0, float_max = 0.0;
+    double fixed_sum = 0.0, fixed_max = 0.0;
+    for (uint16_t i = 0; i < ball_count; i++) {
+      const uint32_t offset = 2 * (checkpoint * ball_count + i);
+      const double x = double_positions[offset];
+      const double y = double_positions[offset + 1];
+      const double float_drift =
+        hypot(float_positions[offset] - x, float_positions[offset + 1] - y);
+      const double fixed_drift =
+        hypot(fixed_positions[offset] - x, fixed_positions[offset + 1] - y);
+      float_sum += float_drift;
+      float_max = float_drift > float_max ? float_drift : float_max;
+      fixed_sum += fixed_drift;
+      fixed_max = fixed_drift > fixed_max ? fixed_drift : fixed_max;
+    }
+    std::cout << "    tick " << checkpoints[checkpoint] << ": float " <<
+      (float_sum / ball_count) << " / " << float_max << ", fixed " <<
+      (fixed_sum / ball_count) << " / " << fixed_max << std::endl;
+  }
+}
+
+/*
+ * Feeds frames with jittered intervals and a long stall every 100
+ * frames into the fixed-timestep accumulator of the Qt front-end, and
+ * compares how far physics time lags behind wall-clock time with
+ * that of one physics step per frame.  Needs no field; only the
+ * pacing is simulated.
+ */
+static void
+bench_pacing(const double frame_ms, const double jitter_ms,
+             const uint32_t frames)
+{
+  const double step_seconds = 1.0 / TICKS_PER_SECOND;
+  Fixed_timestep fixed_timestep(step_seconds, 5);
+  Frame_pacing frame_pacing(0.001 * frame_ms);
+  unsigned int random_state = 1;
+  double wall_seconds = 0.0;
+  for (uint32_t frame = 0; frame < frames; frame++) {
+    double interval_ms =
+      frame_ms + jitter_ms * ((double)rand_r(&random_state) / RAND_MAX);
+    if (frame % 100 == 99) {
+      interval_ms += 200.0;
+    }
+    const double interval = 0.001 * interval_ms;
+    wall_seconds += interval;
+    frame_pacing.add_frame(interval, fixed_timestep.advance(interval));
+  }
+  const double physics_seconds =
+    (fixed_timestep.get_step_count() + fixed_timestep.get_alpha()) *
+    step_seconds;
+  // formerly, each tick of a timer with the step's interval ran one
+  // step, regardless of its lateness; assume that timer's ticks are
+  // late in the same proportion as the frames
+  const double tick_seconds = frames * step_seconds;
+  const double tick_wall_seconds =
+    wall_seconds * step_seconds / (0.001 * frame_ms);
+  std::cout << "pacing: frame=" << frame_ms << "ms, jitter=" << jitter_ms <<
+    "ms, frames=" << frames << std::endl;
+  std::cout << "  " << frame_pacing.to_string() << std::endl;
+  std::cout << "  fixed timestep: " << physics_seconds << "s physics in " <<
+    wall_seconds << "s wall-clock time, dropped " <<
+    fixed_timestep.get_dropped_seconds() << "s" << std::endl;
+  std::cout << "  step per tick:  " << tick_seconds << "s physics in " <<
+    tick_wall_seconds << "s wall-clock time" << std::endl;
+}
+
+/*
+ * Runs the physics thread for the given wall-clock time, while the
+ * main thread plays the GUI: it reads a snapshot once per frame,
+ * stalls for 200ms every 100 frames, and pauses the physics for the
+ * middle tenth of the run.  Reports how far physics time lags behind
+ * wall-clock time, and how long reading a snapshot takes.
+ */
+static void
+bench_thread(const uint16_t width, const uint16_t height,
+             const uint16_t ball_count, const double seconds,
+             const double frame_ms)
+{
+  Bench_field field;
+  Bench_sensors sensors(0.1, 0.1);
+  Balls *balls = create_balls(&field, ball_count);
+  balls->set_sensors(&sensors);
+  const double step_seconds = 1.0 / TICKS_PER_SECOND;
+  Physics_thread *physics_thread =
+    new Physics_thread(balls, &field, &field, step_seconds, 5,
+                       0.5 * step_seconds);
+  if (!physics_thread) {
+    Log::fatal("bench_thread(): not enough memory");
+  }
+  const std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  physics_thread->geometry_changed(width, height);
+  const Physics_thread::snapshot_t *snapshot = physics_thread->get_snapshot();
+  while (!physics_thread->is_field_current(snapshot)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    snapshot = physics_thread->get_snapshot();
+  }
+  const double load_seconds = elapsed_seconds(start);
+  const std::chrono::steady_clock::time_point run_start =
+    std::chrono::steady_clock::now();
+  const uint64_t first_step_count = snapshot->step_count;
+  uint32_t frames = 0;
+  double read_max = 0.0;
+  double read_sum = 0.0;
+  bool is_paused = false;
+  double paused_seconds = 0.0;
+  std::chrono::steady_clock::time_point pause_start;
+  double now_seconds;
+  while ((now_seconds = elapsed_seconds(run_start)) < seconds) {
+    const bool should_pause =
+      (now_seconds >= 0.45 * seconds) && (now_seconds < 0.55 * seconds);
+    if (should_pause && !is_paused) {
+      physics_thread->pause();
+      pause_start = std::chrono::steady_clock::now();
+      is_paused = true;
+    } else if (!should_pause && is_paused) {
+      physics_thread->resume();
+      paused_seconds += elapsed_seconds(pause_start);
+      is_paused = false;
+    }
+    const std::chrono::steady_clock::time_point read_start =
+      std::chrono::steady_clock::now();
+    snapshot = physics_thread->get_snapshot();
+    const double read_seconds = elapsed_seconds(read_start);
+    read_sum += read_seconds;
+    read_max = read_seconds > read_max ? read_seconds : read_max;
+    frames++;
+    const double stall_ms = (frames % 100 == 0) ? 200.0 : 0.0;
+    std::this_thread::sleep_for
+      (std::chrono::duration<double, std::milli>(frame_ms + stall_ms));
+  }
+  const double wall_seconds = elapsed_seconds(run_start) - paused_seconds;
+  snapshot = physics_thread->get_snapshot();
+  const double physics_seconds =
+    (snapshot->step_count - first_step_count) * step_seconds;
+  physics_thread->stop();
+  std::cout << "thread: " << width << "x" << height << ", balls=" <<
+    ball_count << ", frame=" << frame_ms << "ms" << std::endl;
+  std::cout << "  field load:    " << load_seconds << "s" << std::endl;
+  std::cout << "  physics:       " << physics_seconds << "s in " <<
+    wall_seconds << "s unpaused wall-clock time" << std::endl;
+  std::cout << "  snapshot read: mean " <<
+    (1.0e6 * read_sum / frames) << "us, max " << (1.0e6 * read_max) <<
+    "us over " << frames << " frames" << std::endl;
+  delete physics_thread;
+  delete balls;
+}
+
+/*
+ * Runs steps at the given speed, first without and then with a
+ * substep budget, and compares the wall-clock time per step, and
+ * how much game time the budget drops.
+ */
+static void
+bench_budget(const uint16_t width, const uint16_t height,
+             const uint16_t ball_count, const uint32_t ticks,
+             const uint16_t oversampling, const double budget_ms)
+{
+  Bench_field field;
+  Bench_sensors sensors(0.1, 0.1);
+  const double step_seconds = 1.0 / TICKS_PER_SECOND;
+  std::cout << "budget: " << width << "x" << height << ", balls=" <<
+    ball_count << ", ticks=" << ticks << ", substeps=" << oversampling <<
+    ", budget=" << budget_ms << "ms" << std::endl;
+  for (uint8_t budgeted = 0; budgeted < 2; budgeted++) {
+    Balls *balls = create_balls(&field, ball_count);
+    balls->set_sensors(&sensors);
+    balls->set_oversampling(oversampling);
+    field.geometry_changed(width, height);
+    balls->load_field(&field, width, height);
+    Substep_budget substep_budget(step_seconds, 0.001 * budget_ms, 4);
+    if (budgeted) {
+      balls->set_substep_budget(&substep_budget);
+    }
+    double max_seconds = 0.0;
+    const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    for (uint32_t tick = 0; tick < ticks; tick++) {
+      const std::chrono::steady_clock::time_point tick_start =
+        std::chrono::steady_clock::now();
+      balls->update();
+      const double tick_seconds = elapsed_seconds(tick_start);
+      max_seconds = tick_seconds > max_seconds ? tick_seconds : max_seconds;
+    }
+    const double seconds = elapsed_seconds(start);
+    std::cout << (budgeted ? "  budgeted:   " : "  unbudgeted: ") <<
+      (1000.0 * seconds / ticks) << "ms/step mean, " <<
+      (1000.0 * max_seconds) << "ms max, " <<
+      (seconds / (ticks * step_seconds)) << "x real time" << std::endl;
+    if (budgeted) {
+      std::cout << "    substep cost " <<
+        (1.0e6 * substep_budget.get_substep_seconds()) << "us, overruns " <<
+        substep_budget.get_overrun_count() << ", backlog " <<
+        substep_budget.get_backlog() << ", dropped " <<
+        substep_budget.get_dropped_substeps() << " substeps (" <<
+        substep_budget.get_dropped_seconds() << "s of " <<
+        (ticks * step_seconds) << "s)" << std::endl;
+    }
+    delete balls;
+  }
+}
+
+/*
+ * Steps the balls with either storage, and drains the events after
+ * each step, as the Qt front-end does once per frame.  Reports the
+ * number of events per type, which must not depend on the storage.
+ */
+static void
+bench_events(const uint16_t width, const uint16_t height,
+             const uint16_t ball_count, const uint32_t ticks)
+{
+  Bench_field field;
+  Bench_sensors sensors(0.1, 0.1);
+  std::cout << "events: " << width << "x" << height << ", balls=" <<
+    ball_count << ", ticks=" << ticks << std::endl;
+  for (uint8_t storage = 0; storage < 2; storage++) {
+    Balls *balls = create_balls(&field, ball_count);
+    balls->set_sensors(&sensors);
+    balls->set_storage(storage ? Balls::STORAGE_ARRAYS : Balls::STORAGE_OBJECTS);
+    field.geometry_changed(width, height);
+    balls->load_field(&field, width, height);
+    uint64_t counts[3] = {0, 0, 0};
+    double max_impulse = 0.0;
+    const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    for (uint32_t tick = 0; tick < ticks; tick++) {
+      // tilt towards the four corners in turn
+      const double phase = 0.01 * tick;
+      sensors.set_tilt(0.3 * sin(phase), 0.3 * cos(phase));
+      balls->step(DEFAULT_OVERSAMPLING);
+      Balls::event_t event;
+      while (balls->poll_event(&event)) {
+        counts[event.type]++;
+        if ((event.type == Balls::EVENT_WALL_CONTACT) &&
+            (event.impulse > max_impulse)) {
+          max_impulse = event.impulse;
+        }
+      }
+    }
+    const double seconds = elapsed_seconds(start);
+    std::cout << (storage ? "  arrays:  " : "  objects: ") <<
+      (1000.0 * seconds / ticks) << "ms/tick, goal " <<
+      counts[Balls::EVENT_GOAL] << " (" << balls->get_goal_count() <<
+      " in goal), wall " << counts[Balls::EVENT_WALL_CONTACT] <<
+      " (max impulse " << max_impulse << "), exclusion zone " <<
+      counts[Balls::EVENT_EXCLUSION_ZONE] << ", dropped " <<
+      balls->get_dropped_event_count() << std::endl;
+    delete balls;
+  }
+}
+
+/*
+ * Plays many headless games of the synthetic level on the given
+ * number of threads, as the maze-validate tool does for a level of a
+ * config file, and reports the validation, the time for loading the
+ * field and the speedup relative to real time.
+ */
+static void
+bench_validate(const uint16_t width, const uint16_t height,
+               const uint16_t ball_count, const uint32_t game_count,
+               const uint32_t max_steps, const uint16_t thread_count)
+{
+  Bench_field field;
+  const std::vector<const Ball_init_data *> balls_init_data =
+    create_balls_init_data(ball_count);
+  field.geometry_changed(width, height);
+  Worker_pool worker_pool(thread_count);
+  std::cout << "validate: " << width << "x" << height << ", balls=" <<
+    ball_count << std::endl;
+  for (uint8_t mode = 0; mode < 2; mode++) {
+    Level_validator validator(&field, balls_init_data,
+                              field.get_rows(), field.get_columns(),
+                              width, height);
+    validator.set_worker_pool(&worker_pool);
+    validator.set_tilt_mode(mode ?
+                            Tilt_script::MODE_SWEEP :
+                            Tilt_script::MODE_RANDOM);
+    const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    validator.run(game_count, max_steps);
+    const double load_seconds =
+      elapsed_seconds(start) - validator.get_elapsed_seconds();
+    std::cout << (mode ? "sweep " : "random ") << validator.to_string();
+    std::cout << "  load:         " << load_seconds << "s" << std::endl;
+  }
+  for (const Ball_init_data *ball_init_data : balls_init_data) {
+    delete ball_init_data;
+  }
+}
+
+/*
+ * Loads the field and the balls' forces without op table cache,
+ * then twice with the cache in the given directory: if the
+ * directory holds no tables yet, the first load computes and stores
+ * them, and the second one maps them.  All loads must yield the same
+ * ops.
+ */
+static void
+bench_cache(const char *directory,
+            const uint16_t width, const uint16_t height)
+{
+  Bench_field field;
+  field.geometry_changed(width, height);
+  Op_table_cache op_table_cache(directory);
+  std::cout << "cache: " << directory << ", " << width << "x" << height <<
+    std::endl;
+  std::vector<uint16_t> expected_ops;
+  for (uint8_t pass = 0; pass < 3; pass++) {
+    Op_table_cache::set_default(pass ? &op_table_cache : 0);
+    Balls *balls = create_balls(&field, 1);
+    const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    balls->load_field(&field, width, height);
+    const double seconds = elapsed_seconds(start);
+    const uint32_t pixels = ((uint32_t)width) * height;
+    const Narrow_band *field_ops = balls->get_force_field()->get_ops();
+    const Narrow_band *ball_ops = balls->at(0)->get_forces()->get_ops();
+    if (!pass) {
+      expected_ops.resize(2 * pixels);
+      for (uint16_t y = 0; y < height; y++) {
+        field_ops->get_row(y, &expected_ops[y * width]);
+        ball_ops->get_row(y, &expected_ops[pixels + y * width]);
+      }
+    }
+    uint32_t mismatches = 0;
+    for (uint16_t y = 0; y < height; y++) {
+      for (uint16_t x = 0; x < width; x++) {
+        const uint32_t i = y * width + x;
+        mismatches += field_ops->get_op(x, y) != expected_ops[i];
+        mismatches += ball_ops->get_op(x, y) != expected_ops[pixels + i];
+      }
+    }
+    const char *labels[] = {"  uncached: ", "  first:    ", "  second:   "};
+    std::cout << labels[pass] << (seconds * 1000.0) << "ms, mismatches: " <<
+      mismatches << std::endl;
+    delete balls;
+  }
+  Op_table_cache::set_default(0);
+}
+
+/*
+ * Loads the force field at common display resolutions, once on the
+ * calling thread and once on a worker pool, and reports the speedup.
+ * Both loads must yield the same ops.
+ */
+static void
+bench_field(const uint32_t loads, const uint16_t thread_count)
+{
+  const uint16_t resolutions[][2] = {{800, 640}, {1920, 1080}, {3840, 2160}};
+  Bench_field field;
+  Worker_pool worker_pool(thread_count);
+  std::cout << "field: loads=" << loads << ", threads=" << thread_count <<
+    std::endl;
+  std::cout << "  resolution  serial[ms]  parallel[ms]  speedup  mismatches" <<
+    std::endl;
+  for (const uint16_t *resolution : resolutions) {
+    const uint16_t width = resolution[0];
+    const uint16_t height = resolution[1];
+    field.geometry_changed(width, height);
+    Force_field serial_force_field;
+    serial_force_field.set_worker_pool(0);
+    Force_field parallel_force_field;
+    parallel_force_field.set_worker_pool(&worker_pool);
+    std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    for (uint32_t load = 0; load < loads; load++) {
+      serial_force_field.load_field(&field, width, height);
+    }
+    const double serial_seconds = elapsed_seconds(start) / loads;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t load = 0; load < loads; load++) {
+      parallel_force_field.load_field(&field, width, height);
+    }
+    const double parallel_seconds = elapsed_seconds(start) / loads;
+    uint32_t mismatches = 0;
+    for (uint16_t y = 0; y < height; y++) {
+      for (uint16_t x = 0; x < width; x++) {
+        mismatches +=
+          serial_force_field.get_op(x, y) != parallel_force_field.get_op(x, y);
+      }
+    }
+    std::cout << "  " << width << "x" << height << "  " <<
+      (serial_seconds * 1000.0) << "  " << (parallel_seconds * 1000.0) <<
+      "  " << (serial_seconds / parallel_seconds) << "x  " << mismatches <<
+      std::endl;
+  }
+}
+
+/*
+ * Compares the edge detection methods of the force field: the
+ * implicit curves of the exclusion zones, and the streamed Sobel
+ * convolution of the potentials, serially and in parallel.  Both
+ * Sobel loads must yield the same ops.
+ */
+static void
+bench_sobel(const uint16_t width, const uint16_t height,
+            const uint32_t loads)
+{
+  const Force_field::edge_detection_t default_edge_detection =
+    Force_field::get_default_edge_detection();
+  Bench_field field;
+  field.geometry_changed(width, height);
+  std::cout << "sobel: " << width << "x" << height << ", loads=" << loads <<
+    std::endl;
+  std::cout << "  method           load[ms]  reflecting  mismatches" <<
+    std::endl;
+  const Force_field::edge_detection_t edge_detections[] = {
+    Force_field::EDGE_DETECTION_IMPLICIT_CURVES,
+    Force_field::EDGE_DETECTION_SOBEL
+  };
+  for (const Force_field::edge_detection_t edge_detection : edge_detections) {
+    Force_field::set_default_edge_detection(edge_detection);
+    Force_field force_field;
+    const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    for (uint32_t load = 0; load < loads; load++) {
+      force_field.load_field(&field, width, height);
+    }
+    const double seconds = elapsed_seconds(start) / loads;
+    Force_field serial_force_field;
+    serial_force_field.set_worker_pool(0);
+    serial_force_field.load_field(&field, width, height);
+    uint32_t reflecting = 0;
+    uint32_t mismatches = 0;
+    for (uint16_t y = 0; y < height; y++) {
+      for (uint16_t x = 0; x < width; x++) {
+        reflecting += force_field.is_reflection(x, y);
+        mismatches +=
+          serial_force_field.get_op(x, y) != force_field.get_op(x, y);
+      }
+    }
+    std::cout << "  " <<
+      (edge_detection == Force_field::EDGE_DETECTION_SOBEL ?
+       "sobel          " : "implicit curves") << "  " <<
+      (seconds * 1000.0) << "  " << reflecting << "  " << mismatches <<
+      std::endl;
+  }
+  Force_field::set_default_edge_detection(default_edge_detection);
+}
+
+/*
+ * Reports the size of the narrow-band op tables of the force field
+ * and of a ball's forces, relative to dense tables, and the time to
+ * compute them, at common display resolutions.  The ball's radius
+ * scales with the resolution.
+ */
+static void
+bench_band(const uint32_t loads)
+{
+  const uint16_t resolutions[][2] = {{800, 640}, {1920, 1080}, {3840, 2160}};
+  Bench_field field;
+  std::cout << "band: loads=" << loads << ", block=" <<
+    Narrow_band::BLOCK_SIZE << "x" << Narrow_band::BLOCK_SIZE << std::endl;
+  std::cout << "  resolution  radius  table  load[ms]  dense blocks  "
+    "size[KiB]  vs dense" << std::endl;
+  for (const uint16_t *resolution : resolutions) {
+    const uint16_t width = resolution[0];
+    const uint16_t height = resolution[1];
+    const uint16_t radius = height * 7 / 640;
+    field.geometry_changed(width, height);
+    Force_field force_field;
+    std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    for (uint32_t load = 0; load < loads; load++) {
+      force_field.load_field(&field, width, height);
+    }
+    const double field_seconds = elapsed_seconds(start) / loads;
+    const Ball_footprint footprint(2 * radius + 2, 2 * radius + 2,
+                                   radius, radius, radius);
+    const Ball_forces *forces = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t load = 0; load < loads; load++) {
+      delete forces;
+      forces = new Ball_forces(&force_field, &footprint);
+    }
+    const double forces_seconds = elapsed_seconds(start) / loads;
+    const char *labels[] = {"field ", "forces"};
+    const Narrow_band *tables[] = {force_field.get_ops(), forces->get_ops()};
+    const double seconds[] = {field_seconds, forces_seconds};
+    const double dense_size = ((double)width) * height * sizeof(uint16_t);
+    for (uint8_t i = 0; i < 2; i++) {
+      const Narrow_band *table = tables[i];
+      const uint32_t blocks =
+        ((uint32_t)table->get_block_columns()) * table->get_block_rows();
+      std::cout << "  " << width << "x" << height << "  " << radius <<
+        "  " << labels[i] << "  " << (seconds[i] * 1000.0) << "  " <<
+        table->get_dense_block_count() << "/" << blocks << "  " <<
+        (table->get_data_size() / 1024.0) << "  " <<
+        (table->get_data_size() / dense_size) << "x" << std::endl;
+    }
+    delete forces;
+  }
+}
+
+static void
+print_positions(const Balls *balls)
+{
+  for (uint8_t i = 0; i < balls->get_count() && i < 4; i++) {
+    const Ball *ball = balls->at(i);
+    std::cout << "  ball " << (int)i << ": px=" <<
+      ball->get_position()->get_x() << ", py=" <<
+      ball->get_position()->get_y() << std::endl;
+  }
+}
+
+/*
+ * Records a trace of a scripted game on the synthetic level: the
+ * field is tilted back and forth, and the speed is halved after half
+ * of the ticks.
+ */
+static void
+bench_record(const char *path, const uint16_t width, const uint16_t height,
+             const uint16_t ball_count, const uint32_t ticks)
+{
+  Bench_field field;
+  Bench_sensors sensors(0.0, 0.0);
+  Balls *balls = create_balls(&field, ball_count);
+  balls->set_sensors(&sensors);
+  Trace_recorder trace_recorder(path);
+  balls->set_trace_recorder(&trace_recorder);
+  balls->set_random_seed(42);
+  field.geometry_changed(width, height);
+  balls->load_field(&field, width, height);
+  for (uint32_t tick = 0; tick < ticks; tick++) {
+    // the Qt front-end samples the sensors once per 4 ticks
+    const uint32_t sample = tick / 4;
+    sensors.set_tilt(0.2 * sin(0.05 * sample), 0.2 * cos(0.03 * sample));
+    balls->step(tick < ticks / 2 ?
+                DEFAULT_OVERSAMPLING : DEFAULT_OVERSAMPLING / 2);
+  }
+  balls->set_trace_recorder(0);
+  trace_recorder.end();
+  std::cout << "record: " << path << ", " << width << "x" << height <<
+    ", balls=" << ball_count << ", steps=" <<
+    trace_recorder.get_step_count() << std::endl;
+  print_positions(balls);
+  delete balls;
+}
+
+/*
+ * Replays a trace recorded on the synthetic level as fast as
+ * possible and reports the speedup relative to real time.
+ */
+static void
+bench_replay(const char *path)
+{
+  Bench_field field;
+  Trace_player trace_player(path);
+  Balls *balls = create_balls(&field, trace_player.get_ball_count());
+  const std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  trace_player.replay(balls, &field, &field);
+  const double seconds = elapsed_seconds(start);
+  const double simulated_seconds =
+    ((double)trace_player.get_step_count()) / TICKS_PER_SECOND;
+  std::cout << "replay: " << path << ", balls=" <<
+    trace_player.get_ball_count() << ", steps=" <<
+    trace_player.get_step_count() << std::endl;
+  std::cout << "  replay:       " << seconds << "s (" <<
+    (trace_player.get_substep_count() / seconds) << " substeps/s)" <<
+    std::endl;
+  std::cout << "  vs real time: " << (simulated_seconds / seconds) << "x" <<
+    std::endl;
+  print_positions(balls);
+  delete balls;
+}
+
+static void
+usage(const char *program)
+{
+  std::cerr << "usage: " << program << " BENCHMARK [ARGS]" << std::endl;
+  std::cerr << "benchmarks:" << std::endl;
+  std::cerr << "  step [WIDTH HEIGHT [BALLS [TICKS [THREADS]]]]" <<
+    std::endl;
+  std::cerr << "  ops [WIDTH HEIGHT]" << std::endl;
+  std::cerr << "  forces [WIDTH HEIGHT [RADIUS]]" << std::endl;
+  std::cerr << "  narrow [HEIGHT [RADIUS]]" << std::endl;
+  std::cerr << "  scale [WIDTH HEIGHT [TICKS [THREADS]]]" << std::endl;
+  std::cerr << "  sweep [WIDTH HEIGHT [BALLS [TICKS]]]" << std::endl;
+  std::cerr << "  adaptive [WIDTH HEIGHT [BALLS [TICKS]]]" << std::endl;
+  std::cerr << "  collide [WIDTH HEIGHT [BALLS [TICKS [THREADS]]]]" <<
+    std::endl;
+  std::cerr << "  scalar [WIDTH HEIGHT [BALLS [TICKS]]]" << std::endl;
+  std::cerr << "  pacing [FRAME_MS [JITTER_MS [FRAMES]]]" << std::endl;
+  std::cerr << "  budget [WIDTH HEIGHT [BALLS [TICKS [SUBSTEPS [BUDGET_MS]]]]]" <<
+    std::endl;
+  std::cerr << "  events [WIDTH HEIGHT [BALLS [TICKS]]]" << std::endl;
+  std::cerr << "  validate [WIDTH HEIGHT [BALLS [GAMES [STEPS [THREADS]]]]]" <<
+    std::endl;
+  std::cerr << "  cache DIRECTORY [WIDTH HEIGHT]" << std::endl;
+  std::cerr << "  field [LOADS [THREADS]]" << std::endl;
+  std::cerr << "  sobel [WIDTH HEIGHT [LOADS]]" << std::endl;
+  std::cerr << "  band [LOADS]" << std::endl;
+  std::cerr << "  grid [BALLS [TICKS]]" << std::endl;
+  std::cerr << "  thread [WIDTH HEIGHT [BALLS [SECONDS [FRAME_MS]]]]" <<
+    std::endl;
+  std::cerr << "  record TRACE [WIDTH HEIGHT [BALLS [TICKS]]]" << std::endl;
+  std::cerr << "  replay TRACE" << std::endl;
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    usage(argv[0]);
+  }
+  const char *benchmark = argv[1];
+  if (!strcmp(benchmark, "step")) {
+    const uint16_t width = argc > 3 ? atoi(argv[2]) : 800;
+    const uint16_t height = argc > 3 ? atoi(argv[3]) : 640;
+    const uint16_t ball_count = argc > 4 ? atoi(argv[4]) : 1;
+    const uint32_t ticks = argc > 5 ? atoi(argv[5]) : 2000;
+    const uint16_t thread_count =
+      argc > 6 ? atoi(argv[6]) : Worker_pool::get_default()->get_thread_count();
+    bench_step(width, height, ball_count, ticks, thread_count);
+  } else if (!strcmp(benchmark, "ops")) {
+    const uint16_t width = argc > 3 ? atoi(argv[2]) : 800;
+    const uint16_t height = argc > 3 ? atoi(argv[3]) : 640;
+    bench_ops(width, height);
+  } else if (!strcmp(benchmark, "forces")) {
+    const uint16_t width = argc > 3 ? atoi(argv[2]) : 800;
+    const uint16_t height = argc > 3 ? atoi(argv[3]) : 640;
+    const uint16_t radius = argc > 4 ? atoi(argv[4]) : 7;
+    bench_forces(width, height, radius);
+  } else if (!strcmp(benchmark, "narrow")) {
+    const uint16_t height = argc > 2 ? atoi(argv[2]) : 64;
+    const uint16_t radius = argc > 3 ? atoi(argv[3]) : 7;
+    bench_narrow(height, radius);
+  } else if (!strcmp(benchmark, "scale")) {
+    const uint16_t width = argc > 3 ? atoi(argv[2]) : 800;
+    const uint16_t height = argc > 3 ? atoi(argv[3]) : 640;
+    const uint32_t ticks = argc > 4 ? atoi(argv[4]) : 20;
+    const uint16_t thread_count =
+      argc > 5 ? atoi(argv[5]) : Worker_pool::get_default()->get_thread_count();
+    bench_scale(width, height, ticks, thread_count);
+  } else if (!strcmp(benchmark, "sweep")) {
+    const uint16_t width = argc > 3 ? atoi(argv[2]) : 800;
+    const uint16_t height = argc > 3 ? atoi(argv[3]) : 640;
+    const uint16_t ball_count = argc > 4 ? atoi(argv[4]) : 16;
+    const uint32_t ticks = argc > 5 ? atoi(argv[5]) : 2000;
+    bench_sweep(width, height, ball_count, ticks);
+  } else if (!strcmp(benchmark, "adaptive")) {
+    const uint16_t width = argc > 3 ? atoi(argv[2]) : 800;
+    const uint16_t height = argc > 3 ? atoi(argv[3]) : 640;
+    const uint16_t ball_count = argc > 4 ? atoi(argv[4]) : 16;
+    const uint32_t ticks = argc > 5 ? atoi(argv[5]) : 2000;
+    bench_adaptive(width, height, ball_count, ticks);
+  } else if (!strcmp(benchmark, "collide")) {
+    const uint16_t width = argc > 3 ? atoi(argv[2]) : 800;
+    const uint16_t height = argc > 3 ? atoi(argv[3]) : 640;
+    const uint16_t ball_count = argc > 4 ? atoi(argv[4]) : 256;
+    const uint32_t ticks = argc > 5 ? atoi(argv[5]) : 200;
+    const uint16_t thread_count =
+      argc > 6 ? atoi(argv[6]) : Worker_pool::get_default()->get_thread_count();
+    bench_collide(width, height, ball_count, ticks, thread_count);
+  } else if (!strcmp(benchmark, "scalar")) {
+    const uint16_t width = argc > 3 ? atoi(argv[2]) : 800;
+    const uint16_t height = argc > 3 ? atoi(argv[3]) : 640;
+    const uint16_t ball_count = argc > 4 ? atoi(argv[4]) : 256;
+    const uint32_t ticks = argc > 5 ? atoi(argv[5]) : 1000;
+    bench_scalar(width, height, ball_count, ticks);
+  } else if (!strcmp(benchmark, "pacing")) {
+    const double frame_ms = argc > 2 ? atof(argv[2]) : 16.0;
+    const double jitter_ms = argc > 3 ? atof(argv[3]) : 4.0;
+    const uint32_t frames = argc > 4 ? atoi(argv[4]) : 3600;
+    bench_pacing(frame_ms, jitter_ms, frames);
+  } else if (!strcmp(benchmark, "budget")) {
+    const uint16_t width = argc > 3 ? atoi(argv[2]) : 800;
+    const uint16_t height = argc > 3 ? atoi(argv[3]) : 640;
+    const uint16_t ball_count = argc > 4 ? atoi(argv[4]) : 16;
+    const uint32_t ticks = argc > 5 ? atoi(argv[5]) : 40;
+    const uint16_t oversampling = argc > 6 ? atoi(argv[6]) : UINT16_MAX;
+    const double budget_ms = argc > 7 ? atof(argv[7]) : 25.0;
+    bench_budget(width, height, ball_count, ticks, oversampling, budget_ms);
+  } else if (!strcmp(benchmark, "events")) {
+    const uint16_t width = argc > 3 ? atoi(argv[2]) : 800;
+    const uint16_t height = argc > 3 ? atoi(argv[3]) : 640;
+    const uint16_t ball_count = argc > 4 ? atoi(argv[4]) : 64;
+    const uint32_t ticks = argc > 5 ? atoi(argv[5]) : 2000;
+    bench_events(width, height, ball_count, ticks);
+  } else if (!strcmp(benchmark, "validate")) {
+    const uint16_t width = argc > 3 ? atoi(argv[2]) : 800;
+    const uint16_t height = argc > 3 ? atoi(argv[3]) : 640;
+    const uint16_t ball_count = argc > 4 ? atoi(argv[4]) : 4;
+    const uint32_t game_count = argc > 5 ? atoi(argv[5]) : 1000;
+    const uint32_t max_steps = argc > 6 ? atoi(argv[6]) : 2400;
+    const uint16_t thread_count =
+      argc > 7 ? atoi(argv[7]) : Worker_pool::get_default()->get_thread_count();
+    bench_validate(width, height, ball_count, game_count, max_steps,
+                   thread_count);
+  } else if (!strcmp(benchmark, "cache") && (argc > 2)) {
+    const uint16_t width = argc > 4 ? atoi(argv[3]) : 800;
+    const uint16_t height = argc > 4 ? atoi(argv[4]) : 640;
+    bench_cache(argv[2], width, height);
+  } else if (!strcmp(benchmark, "field")) {
+    const uint32_t loads = argc > 2 ? atoi(argv[2]) : 3;
+    const uint16_t thread_count =
+      argc > 3 ? atoi(argv[3]) : Worker_pool::get_default()->get_thread_count();
+    bench_field(loads, thread_count);
+  } else if (!strcmp(benchmark, "sobel")) {
+    const uint16_t width = argc > 3 ? atoi(argv[2]) : 800;
+    const uint16_t height = argc > 3 ? atoi(argv[3]) : 640;
+    const uint32_t loads = argc > 4 ? atoi(argv[4]) : 10;
+    bench_sobel(width, height, loads);
+  } else if (!strcmp(benchmark, "band")) {
+    const uint32_t loads = argc > 2 ? atoi(argv[2]) : 3;
+    bench_band(loads);
+  } else if (!strcmp(benchmark, "grid")) {
+    const uint16_t ball_count = argc > 2 ? atoi(argv[2]) : 16;
+    const uint32_t ticks = argc > 3 ? atoi(argv[3]) : 400;
+    bench_grid(ball_count, ticks);
+  } else if (!strcmp(benchmark, "thread")) {
+    const uint16_t width = argc > 3 ? atoi(argv[2]) : 800;
+    const uint16_t height = argc > 3 ? atoi(argv[3]) : 640;
+    const uint16_t ball_count = argc > 4 ? atoi(argv[4]) : 16;
+    const double seconds = argc > 5 ? atof(argv[5]) : 10.0;
+    const double frame_ms = argc > 6 ? atof(argv[6]) : 16.0;
+    bench_thread(width, height, ball_count, seconds, frame_ms);
+  } else if (!strcmp(benchmark, "record") && (argc > 2)) {
+    const uint16_t width = argc > 4 ? atoi(argv[3]) : 800;
+    const uint16_t height = argc > 4 ? atoi(argv[4]) : 640;
+    const uint16_t ball_count = argc > 5 ? atoi(argv[5]) : 16;
+    const uint32_t ticks = argc > 6 ? atoi(argv[6]) : 2000;
+    bench_record(argv[2], width, height, ball_count, ticks);
+  } else if (!strcmp(benchmark, "replay") && (argc > 2)) {
+    bench_replay(argv[2]);
+  } else {
+    usage(argv[0]);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
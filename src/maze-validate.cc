@@ -0,0 +1,193 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <QtCore/QByteArray>
+#include <QtGui/QGuiApplication>
+#include <maze-config.hh>
+#include <balls.hh>
+#include <level-validator.hh>
+#include <op-table-cache.hh>
+#include <tilt-script.hh>
+#include <worker-pool.hh>
+#include <log.hh>
+
+/*
+ * Validates a level by playing thousands of headless games on all
+ * cores, see Level_validator.  Since the level's brushes are pixmaps,
+ * a Qt GUI application is still needed, but it runs on the offscreen
+ * platform, i.e. without any display.
+ */
+
+static void
+usage(const char *program)
+{
+  std::cerr << "usage: " << program << " [OPTIONS] [CONFIG]" << std::endl;
+  std::cerr << "options:" << std::endl;
+  std::cerr << "  --games N        number of games (default: 1000)" <<
+    std::endl;
+  std::cerr << "  --steps N        max steps per game (default: 6000)" <<
+    std::endl;
+  std::cerr << "  --tilt random|sweep  tilt script (default: random)" <<
+    std::endl;
+  std::cerr << "  --max-tilt T     max pitch and roll (default: 0.3)" <<
+    std::endl;
+  std::cerr << "  --oversampling N substeps per step (default: 100)" <<
+    std::endl;
+  std::cerr << "  --seed N         random seed (default: 1)" << std::endl;
+  std::cerr << "  --threads N      number of threads (default: all cores)" <<
+    std::endl;
+  std::cerr << "  --cells-per-tile N  physics grid resolution (default: " <<
+    Balls::DEFAULT_CELLS_PER_TILE << ")" << std::endl;
+  std::cerr << "  --size W H       physics grid size in cells, instead of "
+    "cells per tile" << std::endl;
+  std::cerr << "  --no-cache       do not cache precomputed forces" << std::endl;
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+  qputenv("QT_QPA_PLATFORM", QByteArray("offscreen"));
+  QGuiApplication application(argc, argv);
+  const char *path = "config.xml";
+  uint32_t game_count = 1000;
+  uint32_t max_steps = 6000;
+  Tilt_script::mode_t tilt_mode = Tilt_script::MODE_RANDOM;
+  double max_tilt = 0.3;
+  uint16_t oversampling = 100;
+  uint32_t random_seed = 1;
+  uint16_t thread_count = 0;
+  uint16_t cells_per_tile = Balls::DEFAULT_CELLS_PER_TILE;
+  uint16_t width = 0;
+  uint16_t height = 0;
+  bool is_caching_op_tables = true;
+  for (int i = 1; i < argc; i++) {
+    const bool has_arg = i + 1 < argc;
+    if (!strcmp(argv[i], "--games") && has_arg) {
+      game_count = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--steps") && has_arg) {
+      max_steps = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--tilt") && has_arg) {
+      i++;
+      if (!strcmp(argv[i], "random")) {
+        tilt_mode = Tilt_script::MODE_RANDOM;
+      } else if (!strcmp(argv[i], "sweep")) {
+        tilt_mode = Tilt_script::MODE_SWEEP;
+      } else {
+        usage(argv[0]);
+      }
+    } else if (!strcmp(argv[i], "--max-tilt") && has_arg) {
+      max_tilt = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--oversampling") && has_arg) {
+      oversampling = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--seed") && has_arg) {
+      random_seed = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--threads") && has_arg) {
+      thread_count = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--cells-per-tile") && has_arg) {
+      cells_per_tile = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--size") && (i + 2 < argc)) {
+      width = atoi(argv[++i]);
+      height = atoi(argv[++i]);
+      if (!width || !height) {
+        usage(argv[0]);
+      }
+    } else if (!strcmp(argv[i], "--no-cache")) {
+      is_caching_op_tables = false;
+    } else if ((argv[i][0] != '-') && (i + 1 == argc)) {
+      path = argv[i];
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (!game_count || !max_steps || !oversampling || !cells_per_tile) {
+    usage(argv[0]);
+  }
+
+  Op_table_cache *op_table_cache = 0;
+  const std::string cache_directory = Op_table_cache::get_default_directory();
+  if (is_caching_op_tables && !cache_directory.empty()) {
+    op_table_cache = new Op_table_cache(cache_directory);
+    if (!op_table_cache) {
+      Log::fatal("main(): not enough memory");
+    }
+    Op_table_cache::set_default(op_table_cache);
+  }
+  Maze_config *config = new Maze_config(path);
+  if (!config) {
+    Log::fatal("main(): not enough memory");
+  }
+  Brush_field *brush_field = config->get_brush_field();
+  if (!width) {
+    // the same grid as in the game, independent of any display
+    width = Balls::get_grid_width(brush_field->get_columns(), cells_per_tile);
+    height = Balls::get_grid_height(brush_field->get_rows(), cells_per_tile);
+  }
+  brush_field->geometry_changed(width, height);
+  Worker_pool *worker_pool =
+    thread_count ? new Worker_pool(thread_count) : Worker_pool::get_default();
+  if (!worker_pool) {
+    Log::fatal("main(): not enough memory");
+  }
+  Level_validator *validator =
+    new Level_validator(brush_field, brush_field->get_balls_init_data(),
+                        brush_field->get_rows(), brush_field->get_columns(),
+                        width, height);
+  if (!validator) {
+    Log::fatal("main(): not enough memory");
+  }
+  validator->set_tilt_mode(tilt_mode);
+  validator->set_max_tilt(max_tilt);
+  validator->set_oversampling(oversampling);
+  validator->set_random_seed(random_seed);
+  validator->set_worker_pool(worker_pool);
+  validator->run(game_count, max_steps);
+  std::cout << path << ": " << width << "x" << height << ", balls=" <<
+    brush_field->get_balls_init_data().size() << std::endl;
+  std::cout << validator->to_string();
+  const bool is_solvable = validator->get_won_game_count() > 0;
+
+  delete validator;
+  validator = 0;
+  if (thread_count) {
+    delete worker_pool;
+  }
+  worker_pool = 0;
+  delete config;
+  config = 0;
+  Op_table_cache::set_default(0);
+  delete op_table_cache;
+  op_table_cache = 0;
+
+  exit(is_solvable ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -25,6 +25,8 @@
 #include <maze.hh>
 #include <QtWidgets/QSplashScreen>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <unistd.h>
 #include <log.hh>
 #include <playing-field.hh>
@@ -52,6 +54,27 @@ Maze::STYLE_SHEET =
 Maze::Maze(int &argc, char **argv)
   : QApplication(argc, argv, 0)
 {
+  // QApplication has already removed all Qt specific options
+  _trace_path = 0;
+  _is_caching_op_tables = true;
+  _cells_per_tile = Balls::DEFAULT_CELLS_PER_TILE;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--record") && (i + 1 < argc)) {
+      _trace_path = argv[++i];
+    } else if (!strcmp(argv[i], "--no-cache")) {
+      _is_caching_op_tables = false;
+    } else if (!strcmp(argv[i], "--cells-per-tile") && (i + 1 < argc)) {
+      _cells_per_tile = atoi(argv[++i]);
+      if (!_cells_per_tile) {
+        Log::warn("Maze(): invalid cells per tile, using default");
+        _cells_per_tile = Balls::DEFAULT_CELLS_PER_TILE;
+      }
+    } else {
+      Log::warn(std::string("Maze(): ignoring unknown argument ") + argv[i]);
+    }
+  }
+  _trace_recorder = 0;
+  _op_table_cache = 0;
 }
 
 void
@@ -60,6 +83,17 @@ Maze::init(IProgress_info *progress_info)
   srand(1);
   _main_window = 0;
 
+  // a warm start on the same level and display skips precomputing
+  // the forces
+  const std::string cache_directory = Op_table_cache::get_default_directory();
+  if (_is_caching_op_tables && !cache_directory.empty()) {
+    _op_table_cache = new Op_table_cache(cache_directory);
+    if (!_op_table_cache) {
+      Log::fatal("Maze(): not enough memory");
+    }
+    Op_table_cache::set_default(_op_table_cache);
+  }
+
   _config = new Maze_config("config.xml");
   if (!_config) {
     Log::fatal("Maze(): not enough memory");
@@ -78,6 +112,14 @@ Maze::init(IProgress_info *progress_info)
   if (!_balls) {
     Log::fatal("Maze(): not enough memory");
   }
+  if (_trace_path) {
+    progress_info->show_message("init trace recorder...");
+    _trace_recorder = new Trace_recorder(_trace_path);
+    if (!_trace_recorder) {
+      Log::fatal("Maze(): not enough memory");
+    }
+    _balls->set_trace_recorder(_trace_recorder);
+  }
 
   progress_info->show_message("creating main window...");
   setStyleSheet(STYLE_SHEET);
@@ -96,11 +138,10 @@ Maze::init(IProgress_info *progress_info)
   _main_window->get_playing_field()->add_field_geometry_listener(_sensors);
 
   progress_info->show_message("init simulation...");
-  _simulation = new Simulation(_balls, _main_window);
+  _simulation = new Simulation(_balls, _main_window, _cells_per_tile);
   if (!_simulation) {
     Log::fatal("Maze(): not enough memory");
   }
-  _simulation->start(50);
   _main_window->get_status_line()->set_simulation(_simulation);
 
   progress_info->show_message("starting game...");
@@ -113,7 +154,7 @@ Maze::init(IProgress_info *progress_info)
   _main_window->show();
 #endif
 
-  _simulation->start();
+  _simulation->start(Simulation::FRAME_INTERVAL);
 }
 
 Main_window *
@@ -131,6 +172,13 @@ Maze::~Maze()
   delete _sensors;
   _sensors = 0;
 
+  delete _trace_recorder;
+  _trace_recorder = 0;
+
+  Op_table_cache::set_default(0);
+  delete _op_table_cache;
+  _op_table_cache = 0;
+
   delete _config;
   _config = 0;
 }
@@ -31,6 +31,8 @@
 #include <maze-config.hh>
 #include <sensors.hh>
 #include <balls.hh>
+#include <trace-recorder.hh>
+#include <op-table-cache.hh>
 #include <main-window.hh>
 #include <simulation.hh>
 
@@ -50,6 +52,11 @@ private:
   Maze_config *_config;
   Sensors *_sensors;
   Balls *_balls;
+  const char *_trace_path;
+  Trace_recorder *_trace_recorder;
+  bool _is_caching_op_tables;
+  uint16_t _cells_per_tile;
+  Op_table_cache *_op_table_cache;
   Main_window *_main_window;
 };
 
@@ -0,0 +1,308 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <narrow-band.hh>
+#include <cstdlib>
+#include <cstring>
+#include <log.hh>
+
+/*
+ * Creates a table with all blocks uniform and zero, to be
+ * classified, allocated and filled in.
+ */
+Narrow_band::Narrow_band(const uint16_t width, const uint16_t height) :
+  _width(width),
+  _height(height),
+  _block_columns((width + BLOCK_SIZE - 1) >> BLOCK_BITS),
+  _block_rows((height + BLOCK_SIZE - 1) >> BLOCK_BITS)
+{
+  _mapped_file = 0;
+  alloc_blocks();
+}
+
+/*
+ * Creates a table from the dense ops of all pixels, row by row.
+ */
+Narrow_band::Narrow_band(const uint16_t width, const uint16_t height,
+                         const uint16_t *ops) :
+  _width(width),
+  _height(height),
+  _block_columns((width + BLOCK_SIZE - 1) >> BLOCK_BITS),
+  _block_rows((height + BLOCK_SIZE - 1) >> BLOCK_BITS)
+{
+  _mapped_file = 0;
+  alloc_blocks();
+  for (uint16_t block_y = 0; block_y < _block_rows; block_y++) {
+    const uint16_t y0 = block_y << BLOCK_BITS;
+    const uint16_t y1 = y0 + BLOCK_SIZE < _height ? y0 + BLOCK_SIZE : _height;
+    for (uint16_t block_x = 0; block_x < _block_columns; block_x++) {
+      const uint16_t x0 = block_x << BLOCK_BITS;
+      const uint16_t x1 = x0 + BLOCK_SIZE < _width ? x0 + BLOCK_SIZE : _width;
+      const uint16_t op = ops[y0 * _width + x0];
+      bool is_uniform = true;
+      for (uint16_t y = y0; (y < y1) && is_uniform; y++) {
+        for (uint16_t x = x0; x < x1; x++) {
+          if (ops[y * _width + x] != op) {
+            is_uniform = false;
+            break;
+          }
+        }
+      }
+      if (is_uniform) {
+        set_uniform(block_x, block_y, op);
+      } else {
+        set_dense(block_x, block_y);
+      }
+    }
+  }
+  allocate();
+  for (uint16_t block_y = 0; block_y < _block_rows; block_y++) {
+    const uint16_t y0 = block_y << BLOCK_BITS;
+    const uint16_t y1 = y0 + BLOCK_SIZE < _height ? y0 + BLOCK_SIZE : _height;
+    for (uint16_t block_x = 0; block_x < _block_columns; block_x++) {
+      if (is_uniform(block_x, block_y)) {
+        continue;
+      }
+      const uint16_t x0 = block_x << BLOCK_BITS;
+      const uint16_t x1 = x0 + BLOCK_SIZE < _width ? x0 + BLOCK_SIZE : _width;
+      uint16_t *block = get_block(block_x, block_y);
+      for (uint16_t y = y0; y < y1; y++) {
+        memcpy(block + get_block_offset(x0, y), ops + y * _width + x0,
+               (x1 - x0) * sizeof(uint16_t));
+      }
+    }
+  }
+}
+
+/*
+ * Creates a table from the data of a mapped file, starting at the
+ * given offset, as previously returned by get_data().  Takes
+ * ownership of the mapping.  The data must be checked with
+ * is_valid() before accessing any ops.
+ */
+Narrow_band::Narrow_band(const uint16_t width, const uint16_t height,
+                         Mapped_file *mapped_file, const size_t offset) :
+  _width(width),
+  _height(height),
+  _block_columns((width + BLOCK_SIZE - 1) >> BLOCK_BITS),
+  _block_rows((height + BLOCK_SIZE - 1) >> BLOCK_BITS)
+{
+  _mapped_file = mapped_file;
+  _data = mapped_file->get_data() + offset;
+  _data_size =
+    mapped_file->get_size() > offset ? mapped_file->get_size() - offset : 0;
+  _blocks = (uint32_t *)_data;
+  _dense = (uint16_t *)(_data + get_blocks_size());
+}
+
+Narrow_band::~Narrow_band()
+{
+  if (_mapped_file) {
+    delete _mapped_file;
+    _mapped_file = 0;
+  } else {
+    free(_data);
+  }
+  _data = 0;
+  _data_size = 0;
+  _blocks = 0;
+  _dense = 0;
+}
+
+const size_t
+Narrow_band::get_blocks_size() const
+{
+  return ((size_t)_block_columns) * _block_rows * sizeof(uint32_t);
+}
+
+void
+Narrow_band::alloc_blocks()
+{
+  _data_size = get_blocks_size();
+  _data = (uint8_t *)malloc(_data_size);
+  if (!_data) {
+    Log::fatal("Narrow_band(): not enough memory");
+  }
+  _blocks = (uint32_t *)_data;
+  _dense = 0;
+  for (uint32_t i = 0; i < ((uint32_t)_block_columns) * _block_rows; i++) {
+    _blocks[i] = UNIFORM;
+  }
+}
+
+const uint16_t
+Narrow_band::get_width() const
+{
+  return _width;
+}
+
+const uint16_t
+Narrow_band::get_height() const
+{
+  return _height;
+}
+
+const uint16_t
+Narrow_band::get_block_columns() const
+{
+  return _block_columns;
+}
+
+const uint16_t
+Narrow_band::get_block_rows() const
+{
+  return _block_rows;
+}
+
+void
+Narrow_band::set_uniform(const uint16_t block_x, const uint16_t block_y,
+                         const uint16_t op)
+{
+  _blocks[block_y * _block_columns + block_x] = UNIFORM | op;
+}
+
+void
+Narrow_band::set_dense(const uint16_t block_x, const uint16_t block_y)
+{
+  _blocks[block_y * _block_columns + block_x] = 0;
+}
+
+/*
+ * Assigns zeroed storage to all blocks classified as dense, in
+ * row-major order of the blocks.  Must be called once, after
+ * classifying and before filling in the blocks.
+ */
+void
+Narrow_band::allocate()
+{
+  const uint32_t block_count = ((uint32_t)_block_columns) * _block_rows;
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < block_count; i++) {
+    if (!(_blocks[i] & UNIFORM)) {
+      _blocks[i] = offset;
+      offset += BLOCK_AREA;
+    }
+  }
+  _data_size = get_blocks_size() + offset * sizeof(uint16_t);
+  uint8_t *data = (uint8_t *)realloc(_data, _data_size);
+  if (!data) {
+    Log::fatal("Narrow_band::allocate(): not enough memory");
+  }
+  _data = data;
+  _blocks = (uint32_t *)_data;
+  _dense = (uint16_t *)(_data + get_blocks_size());
+  memset(_dense, 0, offset * sizeof(uint16_t));
+}
+
+const bool
+Narrow_band::is_uniform(const uint16_t block_x, const uint16_t block_y) const
+{
+  return _blocks[block_y * _block_columns + block_x] & UNIFORM;
+}
+
+const uint16_t
+Narrow_band::get_uniform_op(const uint16_t block_x,
+                            const uint16_t block_y) const
+{
+  return (uint16_t)_blocks[block_y * _block_columns + block_x];
+}
+
+/*
+ * Returns the ops of a dense block, row by row with a stride of
+ * BLOCK_SIZE, also for blocks that stick out of the field.
+ */
+uint16_t *
+Narrow_band::get_block(const uint16_t block_x, const uint16_t block_y)
+{
+  return _dense + _blocks[block_y * _block_columns + block_x];
+}
+
+/*
+ * Expands the ops of row y into the given dense row of the field's
+ * width.
+ */
+void
+Narrow_band::get_row(const uint16_t y, uint16_t *ops) const
+{
+  const uint16_t block_y = y >> BLOCK_BITS;
+  for (uint16_t block_x = 0; block_x < _block_columns; block_x++) {
+    const uint16_t x0 = block_x << BLOCK_BITS;
+    const uint16_t x1 = x0 + BLOCK_SIZE < _width ? x0 + BLOCK_SIZE : _width;
+    const uint32_t block = _blocks[block_y * _block_columns + block_x];
+    if (block & UNIFORM) {
+      for (uint16_t x = x0; x < x1; x++) {
+        ops[x] = (uint16_t)block;
+      }
+    } else {
+      memcpy(ops + x0, _dense + block + get_block_offset(x0, y),
+             (x1 - x0) * sizeof(uint16_t));
+    }
+  }
+}
+
+const uint32_t
+Narrow_band::get_dense_block_count() const
+{
+  return (_data_size - get_blocks_size()) / (BLOCK_AREA * sizeof(uint16_t));
+}
+
+const uint8_t *
+Narrow_band::get_data() const
+{
+  return _data;
+}
+
+const size_t
+Narrow_band::get_data_size() const
+{
+  return _data_size;
+}
+
+/*
+ * Returns true, if the data holds all block entries, and all dense
+ * blocks lie within the data.
+ */
+const bool
+Narrow_band::is_valid() const
+{
+  const size_t blocks_size = get_blocks_size();
+  if ((_data_size < blocks_size) ||
+      ((_data_size - blocks_size) % (BLOCK_AREA * sizeof(uint16_t)))) {
+    return false;
+  }
+  const size_t dense_size = (_data_size - blocks_size) / sizeof(uint16_t);
+  for (uint32_t i = 0; i < ((uint32_t)_block_columns) * _block_rows; i++) {
+    if (!(_blocks[i] & UNIFORM) && (_blocks[i] + BLOCK_AREA > dense_size)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
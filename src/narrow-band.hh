@@ -0,0 +1,118 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef NARROW_BAND_HH
+#define NARROW_BAND_HH
+
+#include <inttypes.h>
+#include <cstddef>
+#include <mapped-file.hh>
+
+/*
+ * A table of velocity ops (see Velocity_op) in narrow-band form: The
+ * field is tiled into square blocks.  A block far off any wall holds
+ * the same op in all of its pixels (open corridor or solid wall), and
+ * is stored as that single op.  Only blocks near walls hold an op per
+ * pixel.  Hence, memory scales with the walls' perimeter rather than
+ * with the field's area.
+ *
+ * A table is built by first classifying each block as uniform or
+ * dense, then allocating storage for the dense blocks, and finally
+ * filling in the dense blocks.  Classifying and filling different
+ * blocks may run concurrently.
+ *
+ * The table's data is a single contiguous array of the block entries
+ * followed by the dense blocks, such that it can be stored into and
+ * mapped from a file as is (see Op_table_cache).
+ */
+class Narrow_band
+{
+public:
+  static const uint8_t BLOCK_BITS = 4;
+  static const uint16_t BLOCK_SIZE = 1 << BLOCK_BITS;
+  static const uint16_t BLOCK_AREA = BLOCK_SIZE * BLOCK_SIZE;
+  Narrow_band(const uint16_t width, const uint16_t height);
+  Narrow_band(const uint16_t width, const uint16_t height,
+              const uint16_t *ops);
+  Narrow_band(const uint16_t width, const uint16_t height,
+              Mapped_file *mapped_file, const size_t offset);
+  virtual ~Narrow_band();
+  const uint16_t get_width() const;
+  const uint16_t get_height() const;
+  const uint16_t get_block_columns() const;
+  const uint16_t get_block_rows() const;
+  void set_uniform(const uint16_t block_x, const uint16_t block_y,
+                   const uint16_t op);
+  void set_dense(const uint16_t block_x, const uint16_t block_y);
+  void allocate();
+  const bool is_uniform(const uint16_t block_x, const uint16_t block_y) const;
+  const uint16_t get_uniform_op(const uint16_t block_x,
+                                const uint16_t block_y) const;
+  uint16_t *get_block(const uint16_t block_x, const uint16_t block_y);
+  void get_row(const uint16_t y, uint16_t *ops) const;
+  const uint32_t get_dense_block_count() const;
+  const uint8_t *get_data() const;
+  const size_t get_data_size() const;
+  const bool is_valid() const;
+
+  static inline const uint32_t get_block_offset(const uint16_t x,
+                                                const uint16_t y)
+  {
+    return
+      ((y & (BLOCK_SIZE - 1)) << BLOCK_BITS) + (x & (BLOCK_SIZE - 1));
+  }
+
+  inline const uint16_t get_op(const uint16_t x, const uint16_t y) const
+  {
+    const uint32_t block =
+      _blocks[(y >> BLOCK_BITS) * _block_columns + (x >> BLOCK_BITS)];
+    return
+      block & UNIFORM ?
+      (uint16_t)block : _dense[block + get_block_offset(x, y)];
+  }
+private:
+  // flags a block entry as the block's op rather than the offset of
+  // its dense ops
+  static const uint32_t UNIFORM = 0x80000000;
+  const uint16_t _width;
+  const uint16_t _height;
+  const uint16_t _block_columns;
+  const uint16_t _block_rows;
+  uint8_t *_data;
+  size_t _data_size;
+  Mapped_file *_mapped_file;
+  uint32_t *_blocks;
+  uint16_t *_dense;
+  const size_t get_blocks_size() const;
+  void alloc_blocks();
+};
+
+#endif /* NARROW_BAND_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,280 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <op-table-cache.hh>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <log.hh>
+
+const char
+Op_table_cache::MAGIC[8] = {'M', 'A', 'Z', 'E', 'O', 'P', 'S', '\0'};
+
+// Increment whenever the computation or the encoding of the ops
+// changes, such that tables of previous versions are recomputed.
+const uint32_t
+Op_table_cache::FORMAT_VERSION = 2;
+
+const uint32_t
+Op_table_cache::BYTE_ORDER_MARK = 0x01020304;
+
+std::atomic<Op_table_cache *>
+Op_table_cache::_default(0);
+
+/*
+ * FNV-1a hash of the given data, optionally continuing the hash of
+ * previous data.
+ */
+const uint64_t
+Op_table_cache::hash(const void *data, const size_t size,
+                     const uint64_t hash)
+{
+  const uint8_t *bytes = (const uint8_t *)data;
+  uint64_t result = hash;
+  for (size_t i = 0; i < size; i++) {
+    result = (result ^ bytes[i]) * FNV_PRIME;
+  }
+  return result;
+}
+
+const Op_table_cache::key_t
+Op_table_cache::get_key(const uint64_t level_hash,
+                        const uint16_t width, const uint16_t height,
+                        const Ball_footprint *footprint)
+{
+  key_t key;
+  memset(&key, 0, sizeof(key));
+  key.level_hash = level_hash;
+  key.width = width;
+  key.height = height;
+  if (footprint) {
+    key.footprint_width = footprint->get_width();
+    key.footprint_height = footprint->get_height();
+    key.footprint_origin_x = footprint->get_origin_x();
+    key.footprint_origin_y = footprint->get_origin_y();
+    key.footprint_radius = footprint->get_radius();
+  }
+  return key;
+}
+
+/*
+ * Returns $XDG_CACHE_HOME/maze, or else $HOME/.cache/maze, or else
+ * an empty string.
+ */
+const std::string
+Op_table_cache::get_default_directory()
+{
+  const char *cache_home = getenv("XDG_CACHE_HOME");
+  if (cache_home && *cache_home) {
+    return std::string(cache_home) + "/maze";
+  }
+  const char *home = getenv("HOME");
+  if (home && *home) {
+    return std::string(home) + "/.cache/maze";
+  }
+  return std::string();
+}
+
+/*
+ * Sets the cache that force fields and balls' forces use, or
+ * disables caching, if null.  The caller keeps ownership.
+ */
+void
+Op_table_cache::set_default(Op_table_cache *op_table_cache)
+{
+  _default = op_table_cache;
+}
+
+Op_table_cache *
+Op_table_cache::get_default()
+{
+  return _default;
+}
+
+Op_table_cache::Op_table_cache(const std::string directory) :
+  _directory(directory)
+{
+  static_assert(sizeof(header_t) <= OPS_OFFSET,
+                "header of op tables does not fit");
+  if (mkdir(_directory.c_str(), 0755) && (errno != EEXIST)) {
+    Log::warn("Op_table_cache(): can not create directory " + _directory +
+              ": " + strerror(errno));
+  }
+}
+
+Op_table_cache::~Op_table_cache()
+{
+}
+
+const std::string
+Op_table_cache::get_directory() const
+{
+  return _directory;
+}
+
+const bool
+Op_table_cache::equals(const key_t *key, const key_t *other)
+{
+  return
+    (key->level_hash == other->level_hash) &&
+    (key->width == other->width) &&
+    (key->height == other->height) &&
+    (key->footprint_width == other->footprint_width) &&
+    (key->footprint_height == other->footprint_height) &&
+    (key->footprint_origin_x == other->footprint_origin_x) &&
+    (key->footprint_origin_y == other->footprint_origin_y) &&
+    (key->footprint_radius == other->footprint_radius);
+}
+
+const std::string
+Op_table_cache::get_path(const key_t *key) const
+{
+  std::stringstream path;
+  path << _directory << "/" <<
+    (key->footprint_width ? "forces-" : "field-") <<
+    std::hex << key->level_hash << std::dec <<
+    "-" << key->width << "x" << key->height;
+  if (key->footprint_width) {
+    path << "-" << key->footprint_width << "x" << key->footprint_height <<
+      "+" << key->footprint_origin_x << "+" << key->footprint_origin_y <<
+      "r" << key->footprint_radius;
+  }
+  path << ".ops";
+  return path.str();
+}
+
+const bool
+Op_table_cache::is_valid(const Mapped_file *mapped_file,
+                         const key_t *key) const
+{
+  if (mapped_file->get_size() < OPS_OFFSET) {
+    return false;
+  }
+  const header_t *header = (const header_t *)mapped_file->get_data();
+  const uint64_t ops_size = mapped_file->get_size() - OPS_OFFSET;
+  return
+    !memcmp(header->magic, MAGIC, sizeof(MAGIC)) &&
+    (header->format_version == FORMAT_VERSION) &&
+    (header->byte_order_mark == BYTE_ORDER_MARK) &&
+    equals(&header->key, key) &&
+    (header->ops_size == ops_size) &&
+    (header->checksum ==
+     hash(mapped_file->get_data() + OPS_OFFSET, ops_size));
+}
+
+/*
+ * Maps the table with the given key, or returns null, if there is
+ * none.  A table that does not match, e.g. from a previous format
+ * version or corrupted, is removed.  The caller takes ownership of
+ * the table, which holds the mapping.
+ */
+Narrow_band *
+Op_table_cache::load(const key_t *key) const
+{
+  const std::string path = get_path(key);
+  Mapped_file *mapped_file = Mapped_file::open(path.c_str());
+  if (!mapped_file) {
+    return 0;
+  }
+  Narrow_band *ops = 0;
+  if (is_valid(mapped_file, key)) {
+    ops = new Narrow_band(key->width, key->height, mapped_file, OPS_OFFSET);
+    if (!ops) {
+      Log::fatal("Op_table_cache::load(): not enough memory");
+    }
+    mapped_file = 0;
+  }
+  if (!ops || !ops->is_valid()) {
+    Log::warn("Op_table_cache::load(): discarding " + path);
+    delete ops;
+    delete mapped_file;
+    unlink(path.c_str());
+    return 0;
+  }
+  Log::debug("loaded op table " + path);
+  return ops;
+}
+
+void
+Op_table_cache::store(const key_t *key, const Narrow_band *ops) const
+{
+  const std::string path = get_path(key);
+  const uint64_t ops_size = ops->get_data_size();
+  uint8_t header_data[OPS_OFFSET];
+  memset(header_data, 0, sizeof(header_data));
+  header_t *header = (header_t *)header_data;
+  memcpy(header->magic, MAGIC, sizeof(MAGIC));
+  header->format_version = FORMAT_VERSION;
+  header->byte_order_mark = BYTE_ORDER_MARK;
+  header->key = *key;
+  header->ops_size = ops_size;
+  header->checksum = hash(ops->get_data(), ops_size);
+
+  std::string temp_path = path + ".XXXXXX";
+  const int fd = mkstemp(&temp_path[0]);
+  if (fd < 0) {
+    Log::warn("Op_table_cache::store(): can not create " + temp_path +
+              ": " + strerror(errno));
+    return;
+  }
+  const uint8_t *chunks[] = {header_data, ops->get_data()};
+  const uint64_t chunk_sizes[] = {sizeof(header_data), ops_size};
+  bool is_written = true;
+  for (uint8_t chunk = 0; chunk < 2 && is_written; chunk++) {
+    uint64_t offset = 0;
+    while (offset < chunk_sizes[chunk]) {
+      const ssize_t count = write(fd, chunks[chunk] + offset,
+                                  chunk_sizes[chunk] - offset);
+      if (count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        is_written = false;
+        break;
+      }
+      offset += count;
+    }
+  }
+  // the data must be on disk before the rename makes it visible
+  is_written = is_written && !fsync(fd);
+  is_written = !close(fd) && is_written;
+  if (!is_written || rename(temp_path.c_str(), path.c_str())) {
+    Log::warn("Op_table_cache::store(): can not write " + path + ": " +
+              strerror(errno));
+    unlink(temp_path.c_str());
+    return;
+  }
+  Log::debug("stored op table " + path);
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
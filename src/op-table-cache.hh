@@ -0,0 +1,108 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef OP_TABLE_CACHE_HH
+#define OP_TABLE_CACHE_HH
+
+#include <inttypes.h>
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <ball-footprint.hh>
+#include <narrow-band.hh>
+
+/*
+ * A directory of precomputed velocity op tables (see Velocity_op),
+ * such that a warm start on the same level and display skips
+ * computing the force field and the balls' forces.  Each table is
+ * a binary file keyed by a hash of the level (see IPotential_field),
+ * the field's width and height, and, for a ball's forces, the ball's
+ * footprint.  Tables are stored in narrow-band form (see
+ * Narrow_band) and loaded by mapping the file into memory.
+ *
+ * Each file starts with a header that holds the format version, the
+ * key and a checksum of the ops.  Files that do not match are
+ * discarded and recomputed.  Files are written under a temporary
+ * name, synced and then renamed, such that a crash never leaves a
+ * partially written table.  Caching is best effort: if the directory
+ * is not writable, tables are just not stored.
+ */
+class Op_table_cache
+{
+public:
+  struct key_t {
+    uint64_t level_hash;
+    uint16_t width;
+    uint16_t height;
+    // all zero for the force field's own ops
+    uint16_t footprint_width;
+    uint16_t footprint_height;
+    uint16_t footprint_origin_x;
+    uint16_t footprint_origin_y;
+    uint16_t footprint_radius;
+  };
+  static const uint64_t hash(const void *data, const size_t size,
+                             const uint64_t hash = FNV_OFFSET_BASIS);
+  static const key_t get_key(const uint64_t level_hash,
+                             const uint16_t width, const uint16_t height,
+                             const Ball_footprint *footprint = 0);
+  static const std::string get_default_directory();
+  static void set_default(Op_table_cache *op_table_cache);
+  static Op_table_cache *get_default();
+  Op_table_cache(const std::string directory);
+  virtual ~Op_table_cache();
+  const std::string get_directory() const;
+  Narrow_band *load(const key_t *key) const;
+  void store(const key_t *key, const Narrow_band *ops) const;
+private:
+  static const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+  static const uint64_t FNV_PRIME = 0x100000001b3ull;
+  static const char MAGIC[8];
+  static const uint32_t FORMAT_VERSION;
+  static const uint32_t BYTE_ORDER_MARK;
+  static const size_t OPS_OFFSET = 64;
+  static std::atomic<Op_table_cache *> _default;
+  struct header_t {
+    char magic[8];
+    uint32_t format_version;
+    uint32_t byte_order_mark;
+    key_t key;
+    uint64_t ops_size;
+    uint64_t checksum;
+  };
+  const std::string _directory;
+  static const bool equals(const key_t *key, const key_t *other);
+  const std::string get_path(const key_t *key) const;
+  const bool is_valid(const Mapped_file *mapped_file,
+                      const key_t *key) const;
+};
+
+#endif /* OP_TABLE_CACHE_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
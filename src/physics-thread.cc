@@ -0,0 +1,329 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <physics-thread.hh>
+#include <ring-buffer.tcc>
+#include <triple-buffer.tcc>
+#include <log.hh>
+
+const uint32_t
+Physics_thread::COMMAND_QUEUE_CAPACITY = 64;
+
+// maximum delay of a command while the physics thread sleeps
+const double
+Physics_thread::COMMAND_LATENCY = 0.005;
+
+// steps' worth of substeps that may be carried over before dropping
+const uint16_t
+Physics_thread::MAX_BACKLOG_STEPS = 4;
+
+Physics_thread::Physics_thread(Balls *balls,
+                               const IPotential_field *potential_field,
+                               IField_geometry_listener *field_geometry_listener,
+                               const double step_seconds,
+                               const uint16_t max_steps_per_frame,
+                               const double step_budget_seconds)
+{
+  if (!balls) {
+    Log::fatal("Physics_thread(): balls is null");
+  }
+  _balls = balls;
+  if (!potential_field) {
+    Log::fatal("Physics_thread(): potential_field is null");
+  }
+  _potential_field = potential_field;
+  _field_geometry_listener = field_geometry_listener;
+  _fixed_timestep = new Fixed_timestep(step_seconds, max_steps_per_frame);
+  if (!_fixed_timestep) {
+    Log::fatal("Physics_thread(): not enough memory");
+  }
+  if (step_budget_seconds > 0.0) {
+    _substep_budget = new Substep_budget(step_seconds, step_budget_seconds,
+                                         MAX_BACKLOG_STEPS);
+    if (!_substep_budget) {
+      Log::fatal("Physics_thread(): not enough memory");
+    }
+  } else {
+    _substep_budget = 0;
+  }
+  _balls->set_substep_budget(_substep_budget);
+  _commands = new Ring_buffer<command_t>(COMMAND_QUEUE_CAPACITY);
+  if (!_commands) {
+    Log::fatal("Physics_thread(): not enough memory");
+  }
+  _snapshots = new Triple_buffer<snapshot_t>();
+  if (!_snapshots) {
+    Log::fatal("Physics_thread(): not enough memory");
+  }
+  _field_request_count = 0;
+  _is_running = true;
+  _field_generation = 0;
+  _is_quitting = false;
+  publish_empty();
+  _thread = std::thread(&Physics_thread::run, this);
+}
+
+Physics_thread::~Physics_thread()
+{
+  stop();
+  delete _snapshots;
+  _snapshots = 0;
+  delete _commands;
+  _commands = 0;
+  delete _substep_budget;
+  _substep_budget = 0;
+  delete _fixed_timestep;
+  _fixed_timestep = 0;
+  _field_geometry_listener = 0;
+  _potential_field = 0;
+  _balls = 0;
+}
+
+/*
+ * Terminates the physics thread and detaches the substep budget
+ * from the balls.  Afterwards, the balls may again be accessed by
+ * other threads.  Subsequent calls have no effect.
+ */
+void
+Physics_thread::stop()
+{
+  _is_quitting = true;
+  if (_thread.joinable()) {
+    _thread.join();
+    _balls->set_substep_budget(0);
+  }
+}
+
+void
+Physics_thread::push(const command_t &command)
+{
+  // the physics thread drains the queue at least every few
+  // milliseconds, hence a full queue is only a short hiccup
+  while (!_commands->push(command)) {
+    std::this_thread::yield();
+  }
+}
+
+void
+Physics_thread::pause()
+{
+  command_t command = { COMMAND_PAUSE, 0, 0, 0, 0 };
+  push(command);
+}
+
+void
+Physics_thread::resume()
+{
+  command_t command = { COMMAND_RESUME, 0, 0, 0, 0 };
+  push(command);
+}
+
+void
+Physics_thread::set_oversampling(const uint16_t oversampling)
+{
+  command_t command = { COMMAND_SET_OVERSAMPLING, oversampling, 0, 0, 0 };
+  push(command);
+}
+
+/*
+ * Requests loading the field for the new geometry.  Returns
+ * immediately; the field is loaded on the physics thread.
+ */
+void
+Physics_thread::geometry_changed(const uint16_t width, const uint16_t height)
+{
+  _field_request_count++;
+  command_t command =
+    { COMMAND_LOAD_FIELD, 0, width, height, _field_request_count };
+  push(command);
+}
+
+/*
+ * Returns the latest snapshot without blocking.  The snapshot remains
+ * valid until the next call of this method.  Until the first field
+ * has been loaded, the snapshot has no balls.
+ */
+const Physics_thread::snapshot_t *
+Physics_thread::get_snapshot()
+{
+  return _snapshots->get_front();
+}
+
+/*
+ * Returns true, if the snapshot has been taken after the field of
+ * the latest requested geometry has been loaded.
+ */
+const bool
+Physics_thread::is_field_current(const snapshot_t *snapshot) const
+{
+  return snapshot->field_generation == _field_request_count;
+}
+
+/*
+ * Returns the factor for drawing the balls between their previous
+ * (0.0) and current (1.0) positions of the snapshot, such that
+ * drawing lags behind physics by one step.
+ */
+const double
+Physics_thread::get_interpolation(const snapshot_t *snapshot) const
+{
+  const std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - snapshot->state_time;
+  const double interpolation =
+    elapsed.count() / _fixed_timestep->get_step_seconds();
+  return
+    interpolation < 0.0 ? 0.0 : (interpolation < 1.0 ? interpolation : 1.0);
+}
+
+void
+Physics_thread::run()
+{
+  _last_time = std::chrono::steady_clock::now();
+  while (!_is_quitting) {
+    process_commands();
+    const std::chrono::steady_clock::time_point now =
+      std::chrono::steady_clock::now();
+    const std::chrono::duration<double> elapsed = now - _last_time;
+    _last_time = now;
+    double sleep_seconds = COMMAND_LATENCY;
+    if (_is_running && _field_generation) {
+      const uint32_t steps = _fixed_timestep->advance(elapsed.count());
+      for (uint32_t i = 0; i < steps; i++) {
+        _balls->update();
+      }
+      if (steps) {
+        publish();
+      }
+      const double due_seconds =
+        (1.0 - _fixed_timestep->get_alpha()) *
+        _fixed_timestep->get_step_seconds();
+      sleep_seconds = due_seconds < sleep_seconds ? due_seconds : sleep_seconds;
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(sleep_seconds));
+  }
+}
+
+void
+Physics_thread::process_commands()
+{
+  command_t command;
+  while (_commands->pop(&command)) {
+    switch (command.type) {
+    case COMMAND_PAUSE:
+      _is_running = false;
+      break;
+    case COMMAND_RESUME:
+      _is_running = true;
+      break;
+    case COMMAND_SET_OVERSAMPLING:
+      _balls->set_oversampling(command.oversampling);
+      break;
+    case COMMAND_LOAD_FIELD:
+      if (_field_geometry_listener) {
+        _field_geometry_listener->geometry_changed(command.width,
+                                                   command.height);
+      }
+      _balls->load_field(_potential_field, command.width, command.height);
+      _field_generation = command.field_generation;
+      // the time spent loading is not game time
+      _last_time = std::chrono::steady_clock::now();
+      publish();
+      break;
+    default:
+      Log::fatal("Physics_thread::process_commands(): "
+                 "unexpected case fall-through");
+    }
+  }
+}
+
+/*
+ * Publishes a snapshot without balls, such that the controlling
+ * thread never reads an uninitialized snapshot.  Called before the
+ * physics thread starts.
+ */
+void
+Physics_thread::publish_empty()
+{
+  snapshot_t *snapshot = _snapshots->get_back();
+  snapshot->balls.clear();
+  snapshot->state_time = std::chrono::steady_clock::now();
+  snapshot->field_generation = 0;
+  snapshot->step_count = 0;
+  snapshot->dropped_step_seconds = 0.0;
+  snapshot->overrun_count = 0;
+  snapshot->dropped_substep_seconds = 0.0;
+  _balls->get_stats(&snapshot->stats);
+  snapshot->all_balls_in_goal = false;
+  _snapshots->publish();
+}
+
+/*
+ * Publishes the current state of all balls.
+ */
+void
+Physics_thread::publish()
+{
+  snapshot_t *snapshot = _snapshots->get_back();
+  const uint16_t count = _balls->get_count();
+  snapshot->balls.resize(count);
+  for (uint16_t i = 0; i < count; i++) {
+    const Ball *ball = _balls->at(i);
+    ball_state_t *state = &snapshot->balls[i];
+    state->px = ball->get_position()->get_x();
+    state->py = ball->get_position()->get_y();
+    state->previous_px = ball->get_previous_position()->get_x();
+    state->previous_py = ball->get_previous_position()->get_y();
+    state->vx = ball->get_velocity()->get_x();
+    state->vy = ball->get_velocity()->get_y();
+    state->is_in_goal = ball->get_is_in_goal();
+  }
+  // the current state belongs to the wall-clock time that is the
+  // accumulator's remainder ago
+  snapshot->state_time =
+    std::chrono::steady_clock::now() -
+    std::chrono::duration_cast<std::chrono::steady_clock::duration>
+    (std::chrono::duration<double>(_fixed_timestep->get_alpha() *
+                                   _fixed_timestep->get_step_seconds()));
+  snapshot->field_generation = _field_generation;
+  snapshot->step_count = _fixed_timestep->get_step_count();
+  snapshot->dropped_step_seconds = _fixed_timestep->get_dropped_seconds();
+  if (_substep_budget) {
+    snapshot->overrun_count = _substep_budget->get_overrun_count();
+    snapshot->dropped_substep_seconds =
+      _substep_budget->get_dropped_seconds();
+  } else {
+    snapshot->overrun_count = 0;
+    snapshot->dropped_substep_seconds = 0.0;
+  }
+  _balls->get_stats(&snapshot->stats);
+  snapshot->all_balls_in_goal = _balls->all_balls_in_goal();
+  _snapshots->publish();
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,148 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef PHYSICS_THREAD_HH
+#define PHYSICS_THREAD_HH
+
+#include <inttypes.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <ifield-geometry-listener.hh>
+#include <ipotential-field.hh>
+#include <balls.hh>
+#include <fixed-timestep.hh>
+#include <substep-budget.hh>
+#include <ring-buffer.hh>
+#include <triple-buffer.hh>
+
+/*
+ * Steps the balls on a dedicated thread in fixed steps of wall-clock
+ * time, such that neither stalls of the GUI thread (e.g. while
+ * resizing the window) stall the physics, nor heavy physics steps
+ * stall the GUI.  The thread is the only one to access the balls
+ * after start.  The GUI thread controls it by commands through a
+ * lock-free queue, and reads snapshots of the balls' state that the
+ * physics thread publishes through a lock-free triple buffer.
+ *
+ * Loading the field upon a change of the field's geometry, i.e. of
+ * the grid that the physics runs on, is also done on the physics
+ * thread, including notifying the potential field of the new
+ * geometry.  Hence, the GUI thread must not access the potential
+ * field while a load is pending, i.e. until is_field_current()
+ * returns true for the latest snapshot.
+ *
+ * With a positive step budget, each step spends at most about that
+ * much CPU time on substeps (see Substep_budget), such that the
+ * highest speeds slow down the game rather than making the physics
+ * fall ever further behind.
+ */
+class Physics_thread : public IField_geometry_listener
+{
+public:
+  struct ball_state_t {
+    double px;
+    double py;
+    double previous_px;
+    double previous_py;
+    double vx;
+    double vy;
+    bool is_in_goal;
+  };
+  struct snapshot_t {
+    std::vector<ball_state_t> balls;
+    std::chrono::steady_clock::time_point state_time;
+    uint32_t field_generation;
+    uint64_t step_count;
+    double dropped_step_seconds;
+    uint64_t overrun_count;
+    double dropped_substep_seconds;
+    Ball::stats_t stats;
+    bool all_balls_in_goal;
+  };
+  Physics_thread(Balls *balls, const IPotential_field *potential_field,
+                 IField_geometry_listener *field_geometry_listener,
+                 const double step_seconds,
+                 const uint16_t max_steps_per_frame,
+                 const double step_budget_seconds);
+  virtual ~Physics_thread();
+  void stop();
+  void pause();
+  void resume();
+  void set_oversampling(const uint16_t oversampling);
+  virtual void geometry_changed(const uint16_t width, const uint16_t height);
+  const snapshot_t *get_snapshot();
+  const bool is_field_current(const snapshot_t *snapshot) const;
+  const double get_interpolation(const snapshot_t *snapshot) const;
+private:
+  enum command_type_t {
+    COMMAND_PAUSE,
+    COMMAND_RESUME,
+    COMMAND_SET_OVERSAMPLING,
+    COMMAND_LOAD_FIELD
+  };
+  struct command_t {
+    command_type_t type;
+    uint16_t oversampling;
+    uint16_t width;
+    uint16_t height;
+    uint32_t field_generation;
+  };
+  static const uint32_t COMMAND_QUEUE_CAPACITY;
+  static const double COMMAND_LATENCY;
+  static const uint16_t MAX_BACKLOG_STEPS;
+  Balls *_balls;
+  const IPotential_field *_potential_field;
+  IField_geometry_listener *_field_geometry_listener;
+  Fixed_timestep *_fixed_timestep;
+  Substep_budget *_substep_budget;
+  Ring_buffer<command_t> *_commands;
+  Triple_buffer<snapshot_t> *_snapshots;
+
+  // accessed by the controlling thread only
+  uint32_t _field_request_count;
+
+  // accessed by the physics thread only
+  bool _is_running;
+  uint32_t _field_generation;
+  std::chrono::steady_clock::time_point _last_time;
+
+  std::atomic<bool> _is_quitting;
+  std::thread _thread;
+  void push(const command_t &command);
+  void run();
+  void process_commands();
+  void publish_empty();
+  void publish();
+};
+
+#endif /* PHYSICS_THREAD_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
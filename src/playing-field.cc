@@ -35,6 +35,9 @@
 
 #define BACKGROUND_MODE BACKGROUND_MODE_NORMAL
 
+/*const*/ QPixmap *
+Playing_field::BALL_PIXMAP = 0;
+
 Playing_field::Playing_field(Brush_field *brush_field,
                              Balls *balls,
                              QWidget *parent) :
@@ -45,6 +48,10 @@ Playing_field::Playing_field(Brush_field *brush_field,
   _velocity_visible = false;
   _force_field_visible = false;
   _ball_visible = true;
+  _snapshot = 0;
+  _interpolation = 1.0;
+  _field_width = 0;
+  _field_height = 0;
 
   if (!balls) {
     Log::fatal("Playing_field::Playing_field(): balls is null");
@@ -58,15 +65,12 @@ Playing_field::Playing_field(Brush_field *brush_field,
   if (!_field_geometry_listeners) {
     Log::fatal("not enough memory");
   }
-  for (uint8_t i = 0; i < balls->get_count(); i++) {
-    add_field_geometry_listener(balls->at(i));
-  }
-  add_field_geometry_listener(brush_field);
   add_field_geometry_listener(this);
 
-  _force_field = new Force_field();
-  if (!_force_field) {
-    Log::fatal("Playing_field::Playing_field(): not enough memory");
+  // Qt: Must construct a QGuiApplication before a QPixmap
+  // => need lazy initialization of BALL_PIXMAP.
+  if (!BALL_PIXMAP) {
+    BALL_PIXMAP = create_ball_pixmap();
   }
 
   setBackgroundRole(QPalette::Base);
@@ -84,15 +88,14 @@ Playing_field::~Playing_field()
   delete _field_geometry_listeners;
   _field_geometry_listeners = 0;
 
+  _snapshot = 0;
+
   delete _balls;
   _balls = 0;
 
   delete _brush_field;
   _brush_field = 0;
 
-  delete _force_field;
-  _force_field = 0;
-
   // Q objects will be deleted by Qt, just set them to 0
   _background = 0;
 }
@@ -109,6 +112,22 @@ Playing_field::get_height() const
   return height();
 }
 
+Brush_field *
+Playing_field::get_brush_field() const
+{
+  return _brush_field;
+}
+
+/*const*/ QPixmap *
+Playing_field::create_ball_pixmap()
+{
+  /*const*/ QPixmap *pixmap = new QPixmap("ball.png");
+  if (!pixmap) {
+    Log::fatal("Playing_field::create_ball_pixmap(): not enough memory");
+  }
+  return pixmap;
+}
+
 void
 Playing_field::add_field_geometry_listener(IField_geometry_listener *listener)
 {
@@ -135,18 +154,24 @@ Playing_field::create_background_forces(const uint16_t width,
                                         const uint16_t height,
                                         QPainter *painter)
 {
+  // ops are on the physics grid rather than on the display
+  const uint16_t grid_width = _balls->get_force_field()->get_width();
+  const uint16_t grid_height = _balls->get_force_field()->get_height();
   for (uint16_t x = 0; x < width; x++) {
     const double field_x = ((double)x) / width;
+    const uint16_t cell_x = (uint16_t)(field_x * grid_width);
     for (uint16_t y = 0; y < height; y++) {
       const double field_y = ((double)y) / height;
+      const uint16_t cell_y = (uint16_t)(field_y * grid_height);
       QColor color;
       const Ball *ball = _balls->at(0);
-      if (!ball->is_reflection(x, y)) {
+      if (!ball->is_reflection(cell_x, cell_y)) {
         color = QColor(0, 0, 0);
       } else if (_brush_field->get_potential(field_x, field_y) > 0.5) {
         color = QColor(255, 255, 255);
       } else {
-        int16_t theta = (int16_t)(ball->get_theta(x, y) / M_PI * 180.0);
+        int16_t theta =
+          (int16_t)(ball->get_theta(cell_x, cell_y) / M_PI * 180.0);
         while (theta < 0) {
           theta += 360;
         }
@@ -166,20 +191,23 @@ Playing_field::create_background_reflections(const uint16_t width,
                                              const uint16_t height,
                                              QPainter *painter)
 {
+  // ops are on the physics grid rather than on the display
+  const uint16_t grid_width = _balls->get_force_field()->get_width();
+  const uint16_t grid_height = _balls->get_force_field()->get_height();
   for (uint16_t x = 0; x < width; x++) {
-    //const double field_x = ((double)x) / width;
+    const uint16_t cell_x = (uint16_t)(((double)x) / width * grid_width);
     for (uint16_t y = 0; y < height; y++) {
-      //const double field_y = ((double)y) / height;
+      const uint16_t cell_y = (uint16_t)(((double)y) / height * grid_height);
       QColor color;
       const Ball *ball = _balls->at(0);
-      if (!ball->is_reflection(x, y)) {
-        if (!ball->is_exclusion_zone(x, y)) {
+      if (!ball->is_reflection(cell_x, cell_y)) {
+        if (!ball->is_exclusion_zone(cell_x, cell_y)) {
           color = QColor(0, 0, 0);
         } else {
           color = QColor(255, 0, 0);
         }
       } else {
-        if (!ball->is_exclusion_zone(x, y)) {
+        if (!ball->is_exclusion_zone(cell_x, cell_y)) {
           color = QColor(0, 255, 0);
         } else {
           color = QColor(255, 255, 255);
@@ -231,14 +259,8 @@ Playing_field::check_update_geometry()
 {
   const uint16_t current_width = width();
   const uint16_t current_height = height();
-  bool need_update = false;
-  if (!_background) {
-    need_update = true;
-  } else {
-    need_update =
-      (current_width != _background->width()) ||
-      (current_height != _background->height());
-  }
+  const bool need_update =
+    (current_width != _field_width) || (current_height != _field_height);
   if (need_update) {
     for (IField_geometry_listener *listener : *_field_geometry_listeners) {
       listener->geometry_changed(current_width, current_height);
@@ -246,6 +268,12 @@ Playing_field::check_update_geometry()
   }
 }
 
+/*
+ * Records the new geometry, re-creates the brushes and drops the
+ * background, which is re-created with the next snapshot (see
+ * set_snapshot()).  Physics runs on a grid of its own (see
+ * Simulation), hence a new geometry never reloads the field.
+ */
 void
 Playing_field::geometry_changed(const uint16_t width, const uint16_t height)
 {
@@ -255,22 +283,54 @@ Playing_field::geometry_changed(const uint16_t width, const uint16_t height)
       "width=" << width << ", height=" << height;
     Log::debug(msg.str());
   }
-  Log::debug("loading force field");
-  _force_field->load_field(_brush_field, width, height);
-  Log::debug("compute forces field onto ball");
-  for (uint8_t i = 0; i < _balls->get_count(); i++) {
-    Ball *ball = _balls->at(i);
-    ball->precompute_forces(_force_field);
-  }
-  Log::debug("(re-)create background");
+  _field_width = width;
+  _field_height = height;
+  _brush_field->brush_geometry_changed(width, height);
   if (_background) {
     delete _background;
     _background = 0;
   }
-  _background = create_background(width, height);
-  if (!_background) {
-    Log::fatal("Playing_field::paintEvent(): not enough memory");
+}
+
+/*
+ * Sets the latest snapshot of the balls to draw, and the factor for
+ * interpolating drawn balls between their previous (0.0) and current
+ * (1.0) physics state, such that balls move smoothly even if frames
+ * are rendered at a higher rate than physics steps.  The snapshot
+ * must remain valid until the next call of this method.
+ */
+void
+Playing_field::set_snapshot(const Physics_thread::snapshot_t *snapshot,
+                            const double interpolation,
+                            const bool is_field_current)
+{
+  // schedule undrawing balls at old positions
+  invalidate_balls();
+  _snapshot = snapshot;
+  _interpolation = interpolation;
+  if (is_field_current && !_background && _field_width && _field_height) {
+    // no field load is pending, hence the brush field is not
+    // accessed by the physics thread
+    Log::debug("(re-)create background");
+    _background = create_background(_field_width, _field_height);
+    if (!_background) {
+      Log::fatal("Playing_field::set_snapshot(): not enough memory");
+    }
+    update();
   }
+  // schedule drawing balls at new positions
+  invalidate_balls();
+}
+
+void
+Playing_field::get_drawn_position(const Physics_thread::ball_state_t *
+                                  ball_state,
+                                  double *px, double *py) const
+{
+  *px = ball_state->previous_px +
+    _interpolation * (ball_state->px - ball_state->previous_px);
+  *py = ball_state->previous_py +
+    _interpolation * (ball_state->py - ball_state->previous_py);
 }
 
 void
@@ -278,17 +338,16 @@ Playing_field::draw_balls(QPainter *painter, const QRect rect)
 {
   const uint16_t current_width = width();
   const uint16_t current_height = height();
-  for (uint8_t i = 0; i < _balls->get_count(); i++) {
+  for (uint16_t i = 0; i < _snapshot->balls.size(); i++) {
     const Ball *ball = _balls->at(i);
     const uint16_t pixmap_origin_x = ball->get_pixmap_origin_x();
     const uint16_t pixmap_origin_y = ball->get_pixmap_origin_y();
-    const double px = ball->get_position()->get_x();
-    const double py = ball->get_position()->get_y();
+    double px, py;
+    get_drawn_position(&_snapshot->balls[i], &px, &py);
     const uint16_t x = (uint16_t)(current_width * px + 0.5) - pixmap_origin_x;
     const uint16_t y = (uint16_t)(current_height * py + 0.5) - pixmap_origin_y;
     painter->setPen(Qt::black);
-    const QPixmap *pixmap = ball->get_pixmap();
-    painter->drawPixmap(x, y, *pixmap);
+    painter->drawPixmap(x, y, *BALL_PIXMAP);
   }
 }
 
@@ -297,13 +356,15 @@ Playing_field::draw_velocities(QPainter *painter, const QRect rect)
 {
   const uint16_t current_width = width();
   const uint16_t current_height = height();
-  for (uint8_t i = 0; i < _balls->get_count(); i++) {
-    const Ball *ball = _balls->at(i);
+  for (uint16_t i = 0; i < _snapshot->balls.size(); i++) {
+    const Physics_thread::ball_state_t *ball_state = &_snapshot->balls[i];
     painter->setPen(Qt::black);
-    const double px = current_width * ball->get_position()->get_x();
-    const double py = current_height * ball->get_position()->get_y();
-    const double rx = ball->get_velocity()->get_x();
-    const double ry = ball->get_velocity()->get_y();
+    double drawn_px, drawn_py;
+    get_drawn_position(ball_state, &drawn_px, &drawn_py);
+    const double px = current_width * drawn_px;
+    const double py = current_height * drawn_py;
+    const double rx = ball_state->vx;
+    const double ry = ball_state->vy;
     const double v_norm = sqrt(rx * rx + ry * ry);
     double normed_rx, normed_ry;
     if (v_norm > 0.0) {
@@ -327,15 +388,35 @@ Playing_field::paintEvent(QPaintEvent *event)
   if (_background) {
     painter.drawImage(rect, *_background, rect);
   }
-  if (_ball_visible) {
+  if (_snapshot && _ball_visible) {
     draw_balls(&painter, rect);
   }
-  if (_velocity_visible) {
+  if (_snapshot && _velocity_visible) {
     draw_velocities(&painter, rect);
   }
   painter.end();
 }
 
+void
+Playing_field::invalidate_balls()
+{
+  if (!_snapshot) {
+    return;
+  }
+  for (uint16_t i = 0; i < _snapshot->balls.size(); i++) {
+    // pixmap geometry is fixed at construction, hence safe to read
+    // while the physics thread steps the balls
+    const Ball *ball = _balls->at(i);
+    double px, py;
+    get_drawn_position(&_snapshot->balls[i], &px, &py);
+    invalidate_rect(px, py,
+                    ball->get_pixmap_width(),
+                    ball->get_pixmap_height(),
+                    ball->get_pixmap_origin_x(),
+                    ball->get_pixmap_origin_y());
+  }
+}
+
 void
 Playing_field::invalidate_rect(const double px, const double py,
                                const uint16_t pixmap_width,
@@ -351,18 +432,6 @@ Playing_field::invalidate_rect(const double px, const double py,
   update(paintRect);
 }
 
-const bool
-Playing_field::matches_goal(const double px, const double py) const
-{
-  return _brush_field->matches_goal(px, py);
-}
-
-const bool
-Playing_field::is_exclusion_zone(const uint16_t x, const uint16_t y) const
-{
-  return _force_field->is_exclusion_zone(x, y);
-}
-
 const bool
 Playing_field::is_velocity_visible() const
 {
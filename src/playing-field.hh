@@ -32,6 +32,7 @@
 #include <QtGui/QColor>
 #include <QtGui/QImage>
 #include <QtGui/QPen>
+#include <QtGui/QPixmap>
 #include <QtWidgets/QAction>
 #include <QtWidgets/QMainWindow>
 #include <QtWidgets/QToolBar>
@@ -39,13 +40,11 @@
 #include <QtWidgets/QVBoxLayout>
 #include <QtWidgets/QWidget>
 #include <ifield-geometry-listener.hh>
-#include <iplaying-field.hh>
 #include <balls.hh>
 #include <brush-field.hh>
-#include <force-field.hh>
+#include <physics-thread.hh>
 
-class Playing_field :
-  public QWidget, public IPlaying_field, public IField_geometry_listener
+class Playing_field : public QWidget, public IField_geometry_listener
 {
   Q_OBJECT
 public:
@@ -53,8 +52,12 @@ public:
                          Balls *balls,
                          QWidget *parent = 0);
   virtual ~Playing_field();
-  virtual const uint16_t get_width() const;
-  virtual const uint16_t get_height() const;
+  const uint16_t get_width() const;
+  const uint16_t get_height() const;
+  Brush_field *get_brush_field() const;
+  void set_snapshot(const Physics_thread::snapshot_t *snapshot,
+                    const double interpolation,
+                    const bool is_field_current);
   void invalidate_rect(const double px, const double py,
                        const uint16_t pixmap_width,
                        const uint16_t pixmap_height,
@@ -62,8 +65,6 @@ public:
                        const uint16_t pixmap_origin_y);
   void invalidate_rect(const uint16_t px, const uint16_t py,
                        const uint16_t width, const uint16_t height);
-  const bool matches_goal(const double px, const double py) const;
-  const bool is_exclusion_zone(const uint16_t x, const uint16_t y) const;
   const bool is_velocity_visible() const;
   void set_velocity_visible(const bool velocity_visible);
   const bool is_force_field_visible() const;
@@ -76,13 +77,18 @@ protected:
   void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
 
 private:
-  const Balls *_balls;
+  static /*const*/ QPixmap *BALL_PIXMAP;
+  static /*const*/ QPixmap *create_ball_pixmap();
+  Balls *_balls;
   Brush_field *_brush_field;
-  Force_field *_force_field;
   QImage *_background;
   bool _velocity_visible;
   bool _force_field_visible;
   bool _ball_visible;
+  const Physics_thread::snapshot_t *_snapshot;
+  double _interpolation;
+  uint16_t _field_width;
+  uint16_t _field_height;
   std::vector<IField_geometry_listener *> *_field_geometry_listeners;
   void check_update_geometry();
   void create_background_normal(const uint16_t width,
@@ -96,6 +102,9 @@ private:
                                      QPainter *painter);
   QImage *create_background(const uint16_t width,
                             const uint16_t height);
+  void invalidate_balls();
+  void get_drawn_position(const Physics_thread::ball_state_t *ball_state,
+                          double *px, double *py) const;
   void draw_balls(QPainter *painter, const QRect rect);
   void draw_velocities(QPainter *painter, const QRect rect);
 };
@@ -0,0 +1,60 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef RING_BUFFER_HH
+#define RING_BUFFER_HH
+
+#include <inttypes.h>
+#include <atomic>
+
+/*
+ * Lock-free, bounded queue from a single producer thread to a single
+ * consumer thread.  Neither push() nor pop() ever blocks; they fail
+ * if the queue is full or empty, respectively.  The capacity is
+ * rounded up to a power of two.
+ */
+template<class T>
+class Ring_buffer
+{
+public:
+  Ring_buffer(const uint32_t capacity);
+  virtual ~Ring_buffer();
+  const uint32_t get_capacity() const;
+  const bool push(const T &item);
+  const bool pop(T *item);
+private:
+  uint32_t _mask;
+  T *_items;
+  std::atomic<uint32_t> _head;
+  std::atomic<uint32_t> _tail;
+};
+
+#endif /* RING_BUFFER_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
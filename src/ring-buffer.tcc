@@ -0,0 +1,105 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef RING_BUFFER_TCC
+#define RING_BUFFER_TCC
+
+#include <ring-buffer.hh>
+#include <log.hh>
+
+template<class T>
+Ring_buffer<T>::Ring_buffer(const uint32_t capacity)
+{
+  if (!capacity || (capacity > 0x80000000)) {
+    Log::fatal("Ring_buffer(): capacity out of range");
+  }
+  uint32_t size = 1;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  _mask = size - 1;
+  _items = new T[size];
+  if (!_items) {
+    Log::fatal("Ring_buffer(): not enough memory");
+  }
+  _head = 0;
+  _tail = 0;
+}
+
+template<class T>
+Ring_buffer<T>::~Ring_buffer()
+{
+  delete[] _items;
+  _items = 0;
+}
+
+template<class T>
+const uint32_t
+Ring_buffer<T>::get_capacity() const
+{
+  return _mask + 1;
+}
+
+/*
+ * Appends a copy of the item.  Returns false, if the queue is full.
+ * Must only be called by the producer thread.
+ */
+template<class T>
+const bool
+Ring_buffer<T>::push(const T &item)
+{
+  const uint32_t tail = _tail.load(std::memory_order_relaxed);
+  if (tail - _head.load(std::memory_order_acquire) > _mask) {
+    return false;
+  }
+  _items[tail & _mask] = item;
+  _tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+/*
+ * Removes the oldest item into *item.  Returns false, if the queue
+ * is empty.  Must only be called by the consumer thread.
+ */
+template<class T>
+const bool
+Ring_buffer<T>::pop(T *item)
+{
+  const uint32_t head = _head.load(std::memory_order_relaxed);
+  if (head == _tail.load(std::memory_order_acquire)) {
+    return false;
+  }
+  *item = _items[head & _mask];
+  _head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+#endif // RING_BUFFER_TCC
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -28,6 +28,7 @@
 #include <log.hh>
 
 #define DEMO_ACCELERATION 0
+#define HAVE_SENSE_HAT 0
 
 Sensors::Sensors(QObject *parent) : QTimer(parent)
 {
@@ -115,16 +116,24 @@ Sensors::sample_and_hold()
   }
 }
 
-const RTFLOAT
+const double
 Sensors::get_pitch() const
 {
+#if HAVE_SENSE_HAT
   return _pitch;
+#else
+  return 0.0;
+#endif
 }
 
-const RTFLOAT
+const double
 Sensors::get_roll() const
 {
+#if HAVE_SENSE_HAT
   return _roll;
+#else
+  return 0.0;
+#endif
 }
 
 const RTFLOAT
@@ -27,16 +27,19 @@
 
 #include <QtCore/QTimer>
 #include <RTIMULib.h>
+#include <atomic>
 #include <ifield-geometry-listener.hh>
+#include <isensors.hh>
 
-class Sensors : public QTimer, public IField_geometry_listener
+class Sensors :
+  public QTimer, public ISensors, public IField_geometry_listener
 {
   Q_OBJECT
 public:
   Sensors(QObject *parent = 0);
   virtual ~Sensors();
-  const RTFLOAT get_pitch() const;
-  const RTFLOAT get_roll() const;
+  virtual const double get_pitch() const;
+  virtual const double get_roll() const;
   const RTFLOAT get_accel_x() const;
   const RTFLOAT get_accel_y() const;
   const RTFLOAT get_temperature() const;
@@ -57,8 +60,9 @@ private:
   bool _sensors_ok;
   RTIMUSettings *_settings;
   RTIMU *_imu;
-  RTFLOAT _pitch;
-  RTFLOAT _roll;
+  // read by the physics thread
+  std::atomic<RTFLOAT> _pitch;
+  std::atomic<RTFLOAT> _roll;
   RTFLOAT _accel_x;
   RTFLOAT _accel_y;
   RTFLOAT _temperature;
@@ -23,13 +23,43 @@
  */
 
 #include <simulation.hh>
+#include <QtCore/QCoreApplication>
 #include <playing-field.hh>
 #include <log.hh>
 
-Simulation::Simulation(Balls *balls, Main_window *main_window)
+// about 60 frames per second
+const uint16_t
+Simulation::FRAME_INTERVAL = 16;
+
+// the former tick rate, for which speed (i.e. oversampling) is tuned
+const double
+Simulation::STEP_SECONDS = 0.05;
+
+const uint16_t
+Simulation::MAX_STEPS_PER_FRAME = 5;
+
+// CPU time per step for substeps, leaving headroom for catching up
+// after stalls
+const double
+Simulation::STEP_BUDGET_SECONDS = 0.025;
+
+const double
+Simulation::PACING_REPORT_SECONDS = 10.0;
+
+Simulation::Simulation(Balls *balls, Main_window *main_window,
+                       const uint16_t cells_per_tile)
   : QTimer(main_window)
 {
   set_status(starting);
+  _frame_pacing = new Frame_pacing(0.001 * FRAME_INTERVAL);
+  if (!_frame_pacing) {
+    Log::fatal("Simulation::Simulation(): not enough memory");
+  }
+  _last_frame = std::chrono::steady_clock::now();
+  _ball_event_listeners = new std::vector<IBall_event_listener *>();
+  if (!_ball_event_listeners) {
+    Log::fatal("Simulation::Simulation(): not enough memory");
+  }
   if (!balls) {
     Log::fatal("Simulation::Simulation(): "
                "balls is null");
@@ -40,8 +70,28 @@ Simulation::Simulation(Balls *balls, Main_window *main_window)
                "main_window is null");
   }
   _main_window = main_window;
+  _oversampling = _balls->get_oversampling();
+  _last_step_count = 0;
+  Playing_field *playing_field = _main_window->get_playing_field();
+  Brush_field *brush_field = playing_field->get_brush_field();
+  _physics_thread =
+    new Physics_thread(_balls, brush_field, brush_field,
+                       STEP_SECONDS, MAX_STEPS_PER_FRAME,
+                       STEP_BUDGET_SECONDS);
+  if (!_physics_thread) {
+    Log::fatal("Simulation::Simulation(): not enough memory");
+  }
+  _physics_thread->
+    geometry_changed(Balls::get_grid_width(brush_field->get_columns(),
+                                           cells_per_tile),
+                     Balls::get_grid_height(brush_field->get_rows(),
+                                            cells_per_tile));
   connect(this, SIGNAL(timeout()),
           this, SLOT(update()));
+  // the balls, sensors and trace recorder are deleted after the
+  // event loop has quit, hence stop physics before
+  connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()),
+          this, SLOT(slot_about_to_quit()));
   begin();
 }
 
@@ -50,6 +100,12 @@ Simulation::~Simulation()
   set_status(exiting);
   _main_window = 0;
   _balls = 0;
+  delete _physics_thread;
+  _physics_thread = 0;
+  delete _frame_pacing;
+  _frame_pacing = 0;
+  delete _ball_event_listeners;
+  _ball_event_listeners = 0;
 }
 
 void
@@ -94,6 +150,12 @@ Simulation::begin()
   set_status(running);
 }
 
+void
+Simulation::slot_about_to_quit()
+{
+  _physics_thread->stop();
+}
+
 const bool
 Simulation::is_running()
 {
@@ -105,6 +167,7 @@ Simulation::pause()
 {
   if (has_status(running)) {
     set_status(pausing);
+    _physics_thread->pause();
   } else {
     // pause function disabled during other states
   }
@@ -121,6 +184,7 @@ Simulation::resume()
 {
   if (has_status(pausing)) {
     set_status(running);
+    _physics_thread->resume();
   } else {
     // pause function disabled during other states
   }
@@ -133,6 +197,7 @@ Simulation::stop()
     Log::fatal("Simulation::stop(): invalid state change");
   }
   set_status(stopping);
+  _physics_thread->pause();
 }
 
 void
@@ -142,14 +207,14 @@ Simulation::set_speed(const double speed)
     Log::fatal("Simulation::set_speed(): speed out of range");
   }
   const uint16_t oversampling = (uint16_t)(exp(speed * log(UINT16_MAX)) + 0.5);
-  _balls->set_oversampling(oversampling);
+  _oversampling = oversampling;
+  _physics_thread->set_oversampling(oversampling);
 }
 
 const double
 Simulation::get_speed()
 {
-  const uint16_t oversampling = _balls->get_oversampling();
-  return log(oversampling) / log(UINT16_MAX);
+  return log(_oversampling) / log(UINT16_MAX);
 }
 
 const bool
@@ -194,28 +259,103 @@ Simulation::set_ball_visible(const bool ball_visible)
   playing_field->set_ball_visible(ball_visible);
 }
 
+void
+Simulation::add_ball_event_listener(IBall_event_listener *listener)
+{
+  _ball_event_listeners->push_back(listener);
+}
+
+/*
+ * Passes all events that the physics thread has emitted since the
+ * previous frame to the listeners.
+ */
+void
+Simulation::dispatch_ball_events()
+{
+  Balls::event_t event;
+  while (_balls->poll_event(&event)) {
+    if (event.type == Balls::EVENT_GOAL) {
+      std::stringstream msg;
+      msg << "ball " << event.ball_index << " reached goal";
+      Log::info(msg.str());
+    }
+    for (IBall_event_listener *listener : *_ball_event_listeners) {
+      listener->ball_event(&event);
+    }
+  }
+}
+
+/*
+ * Schedules redrawing the balls from the latest snapshot that the
+ * physics thread has published, without waiting for the physics
+ * thread, and dispatches pending ball events.  While running, also
+ * checks for the game being over, and keeps frame pacing statistics.
+ */
+void
+Simulation::draw_snapshot(const double elapsed_seconds)
+{
+  Playing_field *playing_field = _main_window->get_playing_field();
+  const Physics_thread::snapshot_t *snapshot =
+    _physics_thread->get_snapshot();
+  playing_field->set_snapshot(snapshot,
+                              _physics_thread->get_interpolation(snapshot),
+                              _physics_thread->is_field_current(snapshot));
+  dispatch_ball_events();
+  const uint32_t steps = snapshot->step_count - _last_step_count;
+  _last_step_count = snapshot->step_count;
+  if (!has_status(running)) {
+    // keep showing the field, e.g. after resizing while pausing
+    return;
+  }
+  if (snapshot->all_balls_in_goal) {
+    stop();
+    _main_window->show_overlay_message("Game\nover!");
+  }
+
+  _frame_pacing->add_frame(elapsed_seconds, steps);
+  if (_frame_pacing->get_frame_count() *
+      _frame_pacing->get_mean_interval() >= PACING_REPORT_SECONDS) {
+    Log::info("frame pacing: " + _frame_pacing->to_string() +
+              ", dropped steps=" +
+              std::to_string(snapshot->dropped_step_seconds) +
+              "s, substep overruns=" +
+              std::to_string(snapshot->overrun_count) +
+              ", dropped substeps=" +
+              std::to_string(snapshot->dropped_substep_seconds) + "s");
+#if PHYSICS_DIAGNOSTICS
+    std::stringstream msg;
+    msg << "ball stats: max |vx|=" << snapshot->stats.max_vx <<
+      ", max |vy|=" << snapshot->stats.max_vy <<
+      ", boundary hits=" << snapshot->stats.boundary_hit_count <<
+      ", clamps=" << snapshot->stats.clamp_count;
+    Log::info(msg.str());
+#endif
+    _frame_pacing->reset();
+  }
+}
+
 void
 Simulation::update()
 {
+  // measure frame intervals also while not running, such that the
+  // first frame after pausing is not reported as late
+  const std::chrono::steady_clock::time_point now =
+    std::chrono::steady_clock::now();
+  const std::chrono::duration<double> elapsed = now - _last_frame;
+  _last_frame = now;
   switch (_status)
   {
     case starting:
       // done => do nothing
       break;
     case running:
-      {
-        Playing_field *playing_field = _main_window->get_playing_field();
-        _balls->update(playing_field);
-        if (_balls->all_balls_in_goal()) {
-          set_status(stopping);
-          _main_window->show_overlay_message("Game\nover!");
-        }
-      }
+      draw_snapshot(elapsed.count());
       break;
     case pausing:
-      // pause => do nothing
+      draw_snapshot(elapsed.count());
       break;
     case stopping:
+      draw_snapshot(elapsed.count());
       {
         const uint64_t elapsed_time = get_time_since_last_state_change();
         if (elapsed_time >= 4200) {
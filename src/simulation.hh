@@ -27,15 +27,35 @@
 
 #include <isimulation.hh>
 #include <QtCore/QTimer>
+#include <chrono>
 #include <balls.hh>
+#include <iball-event-listener.hh>
+#include <frame-pacing.hh>
+#include <physics-thread.hh>
 #include <main-window.hh>
 #include <sys/timeb.h>
 
+/*
+ * Drives the game.  Physics advances on a dedicated thread in fixed
+ * steps of wall-clock time (see Physics_thread), while the timer
+ * fires at display rate and renders a frame from the latest
+ * published snapshot each time, interpolating between its last two
+ * physics states.  Hence, neither late frames slow down the game,
+ * nor slow physics steps block the GUI.
+ *
+ * The field is loaded once onto a grid of the given number of cells
+ * per tile, independent of the window's size, such that resizing the
+ * window only re-renders the field, and the cost of each step is the
+ * same on any display.
+ */
 class Simulation : public QTimer, public ISimulation
 {
   Q_OBJECT
 public:
-  explicit Simulation(Balls *balls, Main_window *main_window);
+  static const uint16_t FRAME_INTERVAL;
+  explicit Simulation(Balls *balls, Main_window *main_window,
+                      const uint16_t cells_per_tile =
+                      Balls::DEFAULT_CELLS_PER_TILE);
   virtual ~Simulation();
   void begin();
   const bool is_running();
@@ -51,14 +71,28 @@ public:
   void set_force_field_visible(const bool force_field_visible);
   const bool is_ball_visible() const;
   void set_ball_visible(const bool ball_visible);
+  void add_ball_event_listener(IBall_event_listener *listener);
 private slots:
   void update();
+  void slot_about_to_quit();
 private:
+  static const double STEP_SECONDS;
+  static const uint16_t MAX_STEPS_PER_FRAME;
+  static const double STEP_BUDGET_SECONDS;
+  static const double PACING_REPORT_SECONDS;
   enum Status {starting, running, pausing, stopping, stopped, exiting};
   Status _status;
   Main_window *_main_window;
   Balls *_balls;
   struct timeb _last_state_change_ftime;
+  Physics_thread *_physics_thread;
+  uint16_t _oversampling;
+  uint64_t _last_step_count;
+  Frame_pacing *_frame_pacing;
+  std::vector<IBall_event_listener *> *_ball_event_listeners;
+  std::chrono::steady_clock::time_point _last_frame;
+  void draw_snapshot(const double elapsed_seconds);
+  void dispatch_ball_events();
   void set_status(const Status status);
   const bool has_status(const Status status) const;
   const uint64_t get_time_since_last_state_change() const;
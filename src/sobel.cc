@@ -47,134 +47,83 @@ Sobel::GY[SIZE][SIZE] = {
   {-5.0,  -8.0, -10.0,  -8.0, -5.0},
 };
 
-Sobel::Sobel(const uint16_t width, const uint16_t height)
+Sobel::Sobel(const uint16_t width) :
+  _width(width)
 {
   if (width < SIZE) {
     std::stringstream msg;
     msg << "Sobel::Sobel(): minimum input array width is " << SIZE;
     Log::fatal(msg.str());
   }
-  _width = width;
-  if (height < SIZE) {
-    std::stringstream msg;
-    msg << "Sobel::Sobel(): minimum input array height is " << SIZE;
-    Log::fatal(msg.str());
-  }
-  _height = height;
-  _gx = (double *)calloc(width * height, sizeof(double));
-  if (!_gx) {
-    Log::fatal("Sobel::Sobel(): not enough memory");
-  }
-  _gy = (double *)calloc(width * height, sizeof(double));
-  if (!_gy) {
-    Log::fatal("Sobel::Sobel(): not enough memory");
-  }
 }
 
 Sobel::~Sobel()
 {
-  _width = 0;
-  _height = 0;
-  free(_gx);
-  _gx = 0;
-  free(_gy);
-  _gy = 0;
 }
 
-const double
-Sobel::convolute_with_kernel(const double *matrix,
-                             const uint32_t my0,
-                             const double *kernel) const
+const uint16_t
+Sobel::get_width() const
 {
-  double sum = 0.0;
-  for (uint8_t y = 0; y < SIZE; y++) {
-    const uint32_t mx0 = my0 + y * _width;
-    const uint8_t gy0 = y * SIZE;
-    for (uint8_t x = 0; x < SIZE; x++) {
-      sum += matrix[mx0 + x] * kernel[gy0 + x];
-    }
-  }
-  return NORM_SCALE * sum;
+  return _width;
 }
 
+/*
+ * Computes the gradients of the center row of the given SIZE
+ * consecutive input rows.  Each kernel element is applied to the
+ * whole row before the next one, in the same order as a per-pixel
+ * convolution would sum them up, such that results do not depend on
+ * vectorization.
+ */
 void
-Sobel::compute_convolution(const double *matrix)
+Sobel::convolute_row(const double * const *rows,
+                     double *gx, double *gy) const
 {
   const uint8_t padding_size = (SIZE - 1) / 2;
-  for (uint16_t y = 0; y < padding_size; y++) {
-    const uint32_t yb = (_height - padding_size) * _width;
-    for (uint16_t x = 0; x < _width; x++) {
-      _gx[x] = 0.0;
-      _gy[x] = 0.0;
-      _gx[yb + x] = 0.0;
-      _gy[yb + x] = 0.0;
-    }
+  const uint16_t count = _width - 2 * padding_size;
+  double * __restrict__ row_gx = gx + padding_size;
+  double * __restrict__ row_gy = gy + padding_size;
+  for (uint16_t x = 0; x < count; x++) {
+    row_gx[x] = 0.0;
+    row_gy[x] = 0.0;
   }
-  for (uint16_t y = padding_size; y < _height - padding_size; y++) {
-    const int32_t m0 = (y - padding_size) * _width - padding_size;
-    const uint32_t g0 = y * _width;
-    const uint32_t gr = g0 + _width - padding_size;
-    for (uint16_t x = 0; x < padding_size; x++) {
-      _gx[g0 + x] = 0.0;
-      _gy[g0 + x] = 0.0;
-      _gx[gr + x] = 0.0;
-      _gy[gr + x] = 0.0;
-    }
-    for (uint16_t x = padding_size; x < _width - padding_size; x++) {
-      _gx[g0 + x] = convolute_with_kernel(matrix, m0 + x, GX[0]);
-      _gy[g0 + x] = convolute_with_kernel(matrix, m0 + x, GY[0]);
+  for (uint8_t ky = 0; ky < SIZE; ky++) {
+    for (uint8_t kx = 0; kx < SIZE; kx++) {
+      const double * __restrict__ row = rows[ky] + kx;
+      const double wx = GX[ky][kx];
+      const double wy = GY[ky][kx];
+      for (uint16_t x = 0; x < count; x++) {
+        row_gx[x] += row[x] * wx;
+        row_gy[x] += row[x] * wy;
+      }
     }
   }
-}
-
-const double
-Sobel::get_gx(const uint16_t x, const uint16_t y) const
-{
-  if ((x < 0) || (x >= _width)) {
-    Log::fatal("Sobel::get_gx(): x out of range");
-  }
-  if ((y < 0) || (y >= _height)) {
-    Log::fatal("Sobel::get_gx(): y out of range");
-  }
-  return _gx[y * _width + x];
-}
-
-const double
-Sobel::get_gy(const uint16_t x, const uint16_t y) const
-{
-  if ((x < 0) || (x >= _width)) {
-    Log::fatal("Sobel::get_gx(): x out of range");
+  for (uint16_t x = 0; x < count; x++) {
+    row_gx[x] = NORM_SCALE * row_gx[x];
+    row_gy[x] = NORM_SCALE * row_gy[x];
   }
-  if ((y < 0) || (y >= _height)) {
-    Log::fatal("Sobel::get_gx(): y out of range");
+  for (uint8_t x = 0; x < padding_size; x++) {
+    gx[x] = 0.0;
+    gy[x] = 0.0;
+    gx[_width - padding_size + x] = 0.0;
+    gy[_width - padding_size + x] = 0.0;
   }
-  return _gy[y * _width + x];
-}
-
-const double
-Sobel::abs(const double x)
-{
-  return x >= 0 ? x : -x;
-}
-
-const double
-Sobel::get_edge_magnitude(const uint16_t x, const uint16_t y) const
-{
-  const double gx = get_gx(x, y);
-  const double gy = get_gy(x, y);
-  return sqrt(gx * gx + gy * gy);
 }
 
+/*
+ * Returns the orientation of the gradient in the field's pixel
+ * geometry, or NaN, if there is no gradient.
+ */
 const double
-Sobel::get_edge_orientation(const uint16_t x, const uint16_t y) const
+Sobel::get_edge_orientation(const double gx, const double gy,
+                            const uint16_t width, const uint16_t height)
 {
-  const double gx = _width * get_gx(x, y);
-  const double gy = _height * get_gy(x, y);
+  const double scaled_gx = width * gx;
+  const double scaled_gy = height * gy;
   double theta;
-  if ((gx == 0.0) && (gy == 0.0)) {
+  if ((scaled_gx == 0.0) && (scaled_gy == 0.0)) {
     theta = std::nan("");
   } else {
-    theta = atan2(gy, gx);
+    theta = atan2(scaled_gy, scaled_gx);
   }
   return theta;
 }
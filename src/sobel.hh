@@ -27,28 +27,31 @@
 
 #include <inttypes.h>
 
+/*
+ * Edge detection with 5x5 Sobel-like kernels.  The convolution
+ * streams over the input row by row: each output row is computed
+ * from a sliding window of five input rows, with both kernels in a
+ * single pass whose inner loop over the row auto-vectorizes.  Hence,
+ * neither the input nor the gradients need to be held for the whole
+ * field.  Two pixels at each end of a row have zero gradients.
+ */
 class Sobel
 {
 public:
-  Sobel(const uint16_t width, const uint16_t height);
+  static const uint8_t SIZE = 5;
+  Sobel(const uint16_t width);
   virtual ~Sobel();
-  void compute_convolution(const double *m);
-  const double get_gx(const uint16_t x, const uint16_t y) const;
-  const double get_gy(const uint16_t x, const uint16_t y) const;
-  const double get_edge_orientation(const uint16_t x, const uint16_t y) const;
-  const double get_edge_magnitude(const uint16_t x, const uint16_t y) const;
+  const uint16_t get_width() const;
+  void convolute_row(const double * const *rows,
+                     double *gx, double *gy) const;
+  static const double get_edge_orientation(const double gx, const double gy,
+                                           const uint16_t width,
+                                           const uint16_t height);
 private:
-  static const uint8_t SIZE = 5;
   static const double NORM_SCALE;
   static const double GX[SIZE][SIZE];
   static const double GY[SIZE][SIZE];
-  uint16_t _width;
-  uint16_t _height;
-  double *_gx, *_gy;
-  static const double abs(const double x);
-  const double convolute_with_kernel(const double *m,
-                                     const uint32_t my0,
-                                     const double *kernel) const;
+  const uint16_t _width;
 };
 
 #endif /* SOBEL_HH */
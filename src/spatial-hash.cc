@@ -0,0 +1,134 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <spatial-hash.hh>
+#include <cmath>
+#include <log.hh>
+
+Spatial_hash::Spatial_hash()
+{
+  _x = 0;
+  _y = 0;
+  _count = 0;
+  _cell_size = 1.0;
+  _mask = 0;
+}
+
+Spatial_hash::~Spatial_hash()
+{
+  _x = 0;
+  _y = 0;
+  _count = 0;
+}
+
+const uint32_t
+Spatial_hash::hash(const int32_t cell_x, const int32_t cell_y) const
+{
+  return (((uint32_t)cell_x) * 73856093u ^ ((uint32_t)cell_y) * 19349663u) &
+    _mask;
+}
+
+void
+Spatial_hash::build(const double *x, const double *y, const uint32_t count,
+                    const double cell_size)
+{
+  if (cell_size <= 0.0) {
+    Log::fatal("Spatial_hash::build(): cell_size <= 0");
+  }
+  _x = x;
+  _y = y;
+  _count = count;
+  _cell_size = cell_size;
+  uint32_t buckets = 1;
+  while (buckets < 2 * count) {
+    buckets <<= 1;
+  }
+  _mask = buckets - 1;
+
+  // counting sort of points by bucket
+  _bucket_start.assign(buckets + 1, 0);
+  _cell_x.resize(count);
+  _cell_y.resize(count);
+  _entries.resize(count);
+  for (uint32_t i = 0; i < count; i++) {
+    _cell_x[i] = (int32_t)floor(x[i] / cell_size);
+    _cell_y[i] = (int32_t)floor(y[i] / cell_size);
+    _bucket_start[hash(_cell_x[i], _cell_y[i]) + 1]++;
+  }
+  for (uint32_t bucket = 0; bucket < buckets; bucket++) {
+    _bucket_start[bucket + 1] += _bucket_start[bucket];
+  }
+  std::vector<uint32_t> fill(_bucket_start.begin(), _bucket_start.end() - 1);
+  for (uint32_t i = 0; i < count; i++) {
+    _entries[fill[hash(_cell_x[i], _cell_y[i])]++] = i;
+  }
+}
+
+/*
+ * Appends all pairs of points closer than max_distance, which must
+ * not exceed the cell size.  Each pair is reported once, ordered by
+ * its first point, such that the result is deterministic.
+ */
+void
+Spatial_hash::find_pairs(const double max_distance,
+                         std::vector<struct pair_t> *pairs) const
+{
+  if (max_distance > _cell_size) {
+    Log::fatal("Spatial_hash::find_pairs(): max_distance exceeds cell size");
+  }
+  const double max_distance2 = max_distance * max_distance;
+  for (uint32_t i = 0; i < _count; i++) {
+    for (int32_t dy = -1; dy <= 1; dy++) {
+      for (int32_t dx = -1; dx <= 1; dx++) {
+        const int32_t cell_x = _cell_x[i] + dx;
+        const int32_t cell_y = _cell_y[i] + dy;
+        const uint32_t bucket = hash(cell_x, cell_y);
+        for (uint32_t entry = _bucket_start[bucket];
+             entry < _bucket_start[bucket + 1]; entry++) {
+          const uint32_t j = _entries[entry];
+          // skip points of other cells that share the bucket
+          if ((j <= i) ||
+              (_cell_x[j] != cell_x) || (_cell_y[j] != cell_y)) {
+            continue;
+          }
+          const double delta_x = _x[j] - _x[i];
+          const double delta_y = _y[j] - _y[i];
+          if (delta_x * delta_x + delta_y * delta_y < max_distance2) {
+            struct pair_t pair;
+            pair.first = i;
+            pair.second = j;
+            pairs->push_back(pair);
+          }
+        }
+      }
+    }
+  }
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,71 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef SPATIAL_HASH_HH
+#define SPATIAL_HASH_HH
+
+#include <inttypes.h>
+#include <vector>
+
+/*
+ * Broad phase for finding pairs of nearby points: Points are sorted
+ * into the cells of a uniform grid, and the cells are hashed into a
+ * table with a number of buckets proportional to the number of
+ * points.  Hence, memory and time stay linear in the number of
+ * points, independent of the extent of the grid.
+ */
+class Spatial_hash
+{
+public:
+  struct pair_t {
+    uint32_t first;
+    uint32_t second;
+  };
+  Spatial_hash();
+  virtual ~Spatial_hash();
+  void build(const double *x, const double *y, const uint32_t count,
+             const double cell_size);
+  void find_pairs(const double max_distance,
+                  std::vector<struct pair_t> *pairs) const;
+private:
+  const double *_x;
+  const double *_y;
+  uint32_t _count;
+  double _cell_size;
+  uint32_t _mask;
+  std::vector<uint32_t> _bucket_start;
+  std::vector<uint32_t> _entries;
+  std::vector<int32_t> _cell_x;
+  std::vector<int32_t> _cell_y;
+  const uint32_t hash(const int32_t cell_x, const int32_t cell_y) const;
+};
+
+#endif /* SPATIAL_HASH_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,186 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <substep-budget.hh>
+#include <cmath>
+#include <log.hh>
+
+// weight of a lower measurement in the substep cost estimate
+const double
+Substep_budget::COST_SMOOTHING = 0.25;
+
+// substeps of the first step, while the substep cost is unknown
+const uint32_t
+Substep_budget::PROBE_SUBSTEPS = 64;
+
+Substep_budget::Substep_budget(const double step_seconds,
+                               const double budget_seconds,
+                               const uint16_t max_backlog_steps) :
+  _step_seconds(step_seconds),
+  _budget_seconds(budget_seconds),
+  _max_backlog_steps(max_backlog_steps)
+{
+  if (!(step_seconds > 0.0)) {
+    Log::fatal("Substep_budget(): step_seconds must be positive");
+  }
+  if (!(budget_seconds > 0.0)) {
+    Log::fatal("Substep_budget(): budget_seconds must be positive");
+  }
+  reset();
+}
+
+Substep_budget::~Substep_budget()
+{
+}
+
+/*
+ * Returns the number of substeps to run for the next step, given
+ * the number of substeps that the current speed requests per step.
+ * At least one substep is run, such that the cost estimate keeps
+ * being updated.
+ */
+const uint32_t
+Substep_budget::begin_step(const uint32_t requested_substeps)
+{
+  const uint64_t due = _backlog + requested_substeps;
+  uint64_t affordable;
+  if (_substep_seconds > 0.0) {
+    affordable = (uint64_t)floor(_budget_seconds / _substep_seconds);
+  } else {
+    affordable = PROBE_SUBSTEPS;
+  }
+  affordable = affordable > 0 ? affordable : 1;
+  const uint64_t substeps = due < affordable ? due : affordable;
+  _backlog = due - substeps;
+  const uint64_t max_backlog =
+    ((uint64_t)_max_backlog_steps) * requested_substeps;
+  if (_backlog > max_backlog) {
+    const uint64_t dropped = _backlog - max_backlog;
+    _dropped_substeps += dropped;
+    if (requested_substeps) {
+      // at the current speed, a step's worth of substeps corresponds
+      // to one step of game time
+      _dropped_seconds += _step_seconds * dropped / requested_substeps;
+    }
+    _backlog = max_backlog;
+  }
+  return (uint32_t)substeps;
+}
+
+/*
+ * Reports the wall-clock time that the step with the given number of
+ * substeps has taken.
+ */
+void
+Substep_budget::end_step(const uint32_t substeps,
+                         const double elapsed_seconds)
+{
+  _step_count++;
+  if (elapsed_seconds > _budget_seconds) {
+    _overrun_count++;
+  }
+  if (!substeps) {
+    return;
+  }
+  // follow rising costs immediately, such that a cost rise overruns
+  // at most one step, but falling costs only gradually
+  const double substep_seconds = elapsed_seconds / substeps;
+  if ((_substep_seconds > 0.0) && (substep_seconds < _substep_seconds)) {
+    _substep_seconds += COST_SMOOTHING * (substep_seconds - _substep_seconds);
+  } else {
+    _substep_seconds = substep_seconds;
+  }
+}
+
+const double
+Substep_budget::get_budget_seconds() const
+{
+  return _budget_seconds;
+}
+
+/*
+ * Returns the estimated wall-clock time per substep, or 0.0, if no
+ * step has been measured yet.
+ */
+const double
+Substep_budget::get_substep_seconds() const
+{
+  return _substep_seconds;
+}
+
+const uint64_t
+Substep_budget::get_backlog() const
+{
+  return _backlog;
+}
+
+const uint64_t
+Substep_budget::get_step_count() const
+{
+  return _step_count;
+}
+
+/*
+ * Returns the number of steps that took longer than the budget,
+ * e.g. because the substep cost rose faster than the estimate.
+ */
+const uint64_t
+Substep_budget::get_overrun_count() const
+{
+  return _overrun_count;
+}
+
+const uint64_t
+Substep_budget::get_dropped_substeps() const
+{
+  return _dropped_substeps;
+}
+
+/*
+ * Returns the game time lost by dropped substeps, measured in steps
+ * at the speed in effect when they were dropped.
+ */
+const double
+Substep_budget::get_dropped_seconds() const
+{
+  return _dropped_seconds;
+}
+
+void
+Substep_budget::reset()
+{
+  _substep_seconds = 0.0;
+  _backlog = 0;
+  _step_count = 0;
+  _overrun_count = 0;
+  _dropped_substeps = 0;
+  _dropped_seconds = 0.0;
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
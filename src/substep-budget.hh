@@ -0,0 +1,77 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef SUBSTEP_BUDGET_HH
+#define SUBSTEP_BUDGET_HH
+
+#include <inttypes.h>
+
+/*
+ * Limits the CPU time that each physics step may spend on substeps.
+ * The cost of a substep is measured online from the steps run so
+ * far.  Each step runs only as many of the requested substeps as fit
+ * into the budget; the remaining substeps are carried over to
+ * subsequent steps, which catch up as soon as there is time left.
+ * To not pile up an ever growing backlog, the carried substeps are
+ * limited to a few steps' worth; beyond, substeps are dropped,
+ * i.e. the game slows down rather than starving other work.
+ */
+class Substep_budget
+{
+public:
+  Substep_budget(const double step_seconds, const double budget_seconds,
+                 const uint16_t max_backlog_steps);
+  virtual ~Substep_budget();
+  const uint32_t begin_step(const uint32_t requested_substeps);
+  void end_step(const uint32_t substeps, const double elapsed_seconds);
+  const double get_budget_seconds() const;
+  const double get_substep_seconds() const;
+  const uint64_t get_backlog() const;
+  const uint64_t get_step_count() const;
+  const uint64_t get_overrun_count() const;
+  const uint64_t get_dropped_substeps() const;
+  const double get_dropped_seconds() const;
+  void reset();
+private:
+  static const double COST_SMOOTHING;
+  static const uint32_t PROBE_SUBSTEPS;
+  const double _step_seconds;
+  const double _budget_seconds;
+  const uint16_t _max_backlog_steps;
+  double _substep_seconds;
+  uint64_t _backlog;
+  uint64_t _step_count;
+  uint64_t _overrun_count;
+  uint64_t _dropped_substeps;
+  double _dropped_seconds;
+};
+
+#endif /* SUBSTEP_BUDGET_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
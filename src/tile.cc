@@ -77,8 +77,8 @@ Tile::to_string() const
       << _foreground_brush_factory->to_string();
   str << ", background_brush_factory="
       << _background_brush_factory->to_string();
-  str << ", width=" << &_width;
-  str << ", height=" << &_height;
+  str << ", width=" << _width;
+  str << ", height=" << _height;
   str << ", foreground_potential=" << _foreground_potential;
   str << ", background_potential=" << _background_potential;
   str << ", shape=" << _shape->to_string();
@@ -137,6 +137,18 @@ Tile::get_shape() const
   return _shape;
 }
 
+const double
+Tile::get_foreground_potential() const
+{
+  return _foreground_potential;
+}
+
+const double
+Tile::get_background_potential() const
+{
+  return _background_potential;
+}
+
 /*
  * Local variables:
  *   mode: c++
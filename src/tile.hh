@@ -48,6 +48,8 @@ public:
   const double get_avg_tan(const double x, const double y) const;
   const Xml_string *get_id() const;
   const Shape *get_shape() const;
+  const double get_foreground_potential() const;
+  const double get_background_potential() const;
   void geometry_changed(const uint16_t width, const uint16_t height);
 private:
   const Xml_string *_id;
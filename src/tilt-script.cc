@@ -0,0 +1,102 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <tilt-script.hh>
+#include <cmath>
+#include <counter-rng.hh>
+
+// at the Qt front-end's rate of 20 steps per second
+const uint32_t
+Tilt_script::HOLD_STEPS = 10;
+
+const uint32_t
+Tilt_script::MIN_SWEEP_PERIOD_STEPS = 40;
+
+const uint32_t
+Tilt_script::MAX_SWEEP_PERIOD_STEPS = 400;
+
+Tilt_script::Tilt_script(const mode_t mode, const double max_tilt,
+                         const uint32_t random_seed, const uint32_t game) :
+  _mode(mode),
+  _max_tilt(max_tilt),
+  _random_seed(random_seed),
+  _game(game)
+{
+  const double period_range =
+    MAX_SWEEP_PERIOD_STEPS - MIN_SWEEP_PERIOD_STEPS;
+  // counters beyond 2^32 are never used for the random mode's holds
+  const uint64_t counter = ((uint64_t)1) << 32;
+  _pitch_frequency =
+    2.0 * M_PI / (MIN_SWEEP_PERIOD_STEPS + period_range * get_uniform(counter));
+  _pitch_phase = 2.0 * M_PI * get_uniform(counter + 1);
+  _roll_frequency =
+    2.0 * M_PI / (MIN_SWEEP_PERIOD_STEPS +
+                  period_range * get_uniform(counter + 2));
+  _roll_phase = 2.0 * M_PI * get_uniform(counter + 3);
+  set_step(0);
+}
+
+Tilt_script::~Tilt_script()
+{
+  _pitch = 0.0;
+  _roll = 0.0;
+}
+
+const double
+Tilt_script::get_uniform(const uint64_t counter) const
+{
+  return Counter_rng::get_uniform(_random_seed, _game, counter);
+}
+
+void
+Tilt_script::set_step(const uint32_t step)
+{
+  if (_mode == MODE_RANDOM) {
+    const uint64_t hold = step / HOLD_STEPS;
+    _pitch = _max_tilt * (2.0 * get_uniform(2 * hold) - 1.0);
+    _roll = _max_tilt * (2.0 * get_uniform(2 * hold + 1) - 1.0);
+  } else {
+    _pitch = _max_tilt * sin(_pitch_frequency * step + _pitch_phase);
+    _roll = _max_tilt * sin(_roll_frequency * step + _roll_phase);
+  }
+}
+
+const double
+Tilt_script::get_pitch() const
+{
+  return _pitch;
+}
+
+const double
+Tilt_script::get_roll() const
+{
+  return _roll;
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
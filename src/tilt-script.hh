@@ -0,0 +1,76 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef TILT_SCRIPT_HH
+#define TILT_SCRIPT_HH
+
+#include <inttypes.h>
+#include <isensors.hh>
+
+/*
+ * A synthetic player that tilts the field, for driving headless
+ * games.  In random mode, the player holds a random tilt for half a
+ * second, then turns to another one.  In sweep mode, the player
+ * tilts the field smoothly in a Lissajous figure with a random
+ * frequency and phase per axis.  The tilt depends only on the seed,
+ * the game's index and the step, such that games can be repeated.
+ */
+class Tilt_script : public ISensors
+{
+public:
+  enum mode_t {
+    MODE_RANDOM,
+    MODE_SWEEP
+  };
+  Tilt_script(const mode_t mode, const double max_tilt,
+              const uint32_t random_seed, const uint32_t game);
+  virtual ~Tilt_script();
+  void set_step(const uint32_t step);
+  virtual const double get_pitch() const;
+  virtual const double get_roll() const;
+private:
+  static const uint32_t HOLD_STEPS;
+  static const uint32_t MIN_SWEEP_PERIOD_STEPS;
+  static const uint32_t MAX_SWEEP_PERIOD_STEPS;
+  const mode_t _mode;
+  const double _max_tilt;
+  const uint32_t _random_seed;
+  const uint32_t _game;
+  double _pitch_frequency;
+  double _pitch_phase;
+  double _roll_frequency;
+  double _roll_phase;
+  double _pitch;
+  double _roll;
+  const double get_uniform(const uint64_t counter) const;
+};
+
+#endif /* TILT_SCRIPT_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
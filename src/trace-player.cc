@@ -0,0 +1,261 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <trace-player.hh>
+#include <cstdio>
+#include <cstring>
+#include <trace-recorder.hh>
+#include <log.hh>
+
+// size of a ball's snapshot in the trace header
+#define BALL_SNAPSHOT_SIZE (5 * 8 + 4 + 8 + 1)
+
+Trace_player::Trace_player(const char *path)
+{
+  if (!path) {
+    Log::fatal("Trace_player(): path is null");
+  }
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    Log::fatal(std::string("Trace_player(): failed opening ") + path);
+  }
+  uint8_t buffer[65536];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    _data.insert(_data.end(), buffer, buffer + count);
+  }
+  const bool has_error = ferror(file);
+  fclose(file);
+  if (has_error) {
+    Log::fatal(std::string("Trace_player(): failed reading ") + path);
+  }
+  _offset = 0;
+  for (uint8_t i = 0; i < sizeof(Trace_recorder::MAGIC); i++) {
+    if (read_uint8() != (uint8_t)Trace_recorder::MAGIC[i]) {
+      Log::fatal(std::string("Trace_player(): not a trace: ") + path);
+    }
+  }
+  if (read_uint16() != Trace_recorder::VERSION) {
+    Log::fatal(std::string("Trace_player(): unsupported version: ") + path);
+  }
+  _ball_count = read_uint16();
+  _events_offset = _offset + _ball_count * BALL_SNAPSHOT_SIZE;
+  _pitch = 0.0;
+  _roll = 0.0;
+  _step_count = 0;
+  _substep_count = 0;
+  _duration = 0;
+}
+
+Trace_player::~Trace_player()
+{
+}
+
+const uint16_t
+Trace_player::get_ball_count() const
+{
+  return _ball_count;
+}
+
+/*
+ * Restores the balls' recorded state and steps them through all
+ * recorded events.  The geometry listener, if not null, is notified
+ * of field geometry changes before the field is reloaded into the
+ * balls, like the Qt front-end does.
+ */
+void
+Trace_player::replay(Balls *balls, const IPotential_field *potential_field,
+                     IField_geometry_listener *geometry_listener)
+{
+  if (!balls) {
+    Log::fatal("Trace_player::replay(): balls is null");
+  }
+  if (!potential_field) {
+    Log::fatal("Trace_player::replay(): potential_field is null");
+  }
+  if (balls->get_count() != _ball_count) {
+    Log::fatal("Trace_player::replay(): number of balls does not match");
+  }
+  restore_snapshot(balls);
+  balls->set_sensors(this);
+  _step_count = 0;
+  _substep_count = 0;
+  _duration = 0;
+  uint32_t substeps = 0;
+  bool is_done = false;
+  while (!is_done) {
+    const uint8_t event = read_uint8();
+    switch (event) {
+    case Trace_recorder::EVENT_END:
+      _duration = read_uint32();
+      is_done = true;
+      break;
+    case Trace_recorder::EVENT_STEPS:
+      {
+        const uint32_t count = read_uint32();
+        for (uint32_t i = 0; i < count; i++) {
+          balls->step(substeps);
+        }
+        _step_count += count;
+        _substep_count += ((uint64_t)count) * substeps;
+      }
+      break;
+    case Trace_recorder::EVENT_SAMPLE:
+      read_uint32(); // timestamp
+      _pitch = read_double();
+      _roll = read_double();
+      break;
+    case Trace_recorder::EVENT_SPEED:
+      substeps = read_uint32();
+      break;
+    case Trace_recorder::EVENT_SEED:
+      balls->set_random_seed(read_uint32());
+      break;
+    case Trace_recorder::EVENT_FIELD:
+      {
+        const uint16_t width = read_uint16();
+        const uint16_t height = read_uint16();
+        if (geometry_listener) {
+          geometry_listener->geometry_changed(width, height);
+        }
+        balls->load_field(potential_field, width, height);
+      }
+      break;
+    case Trace_recorder::EVENT_MODE:
+      {
+        const uint8_t collision_mode = read_uint8();
+        if (collision_mode > Balls::COLLISION_ADAPTIVE) {
+          Log::fatal("Trace_player::replay(): unknown collision mode");
+        }
+        balls->set_collision_mode((Balls::collision_mode_t)collision_mode);
+        balls->set_colliding_balls(read_uint8() != 0);
+      }
+      break;
+    default:
+      Log::fatal("Trace_player::replay(): unknown event");
+    }
+  }
+}
+
+void
+Trace_player::restore_snapshot(Balls *balls)
+{
+  _offset = _events_offset - _ball_count * BALL_SNAPSHOT_SIZE;
+  for (uint16_t i = 0; i < _ball_count; i++) {
+    Ball *ball = balls->at(i);
+    const double px = read_double();
+    const double py = read_double();
+    const double vx = read_double();
+    const double vy = read_double();
+    const double mass = read_double();
+    if (mass != ball->get_mass()) {
+      Log::warn("Trace_player::restore_snapshot(): mass of ball differs");
+    }
+    ball->set_position(px, py);
+    ball->set_velocity(vx, vy);
+    ball->set_random_seed(read_uint32());
+    ball->set_substep_count(read_uint64());
+    ball->set_is_in_goal(read_uint8() != 0);
+  }
+}
+
+const uint64_t
+Trace_player::get_step_count() const
+{
+  return _step_count;
+}
+
+const uint64_t
+Trace_player::get_substep_count() const
+{
+  return _substep_count;
+}
+
+/*
+ * Returns the recorded wall-clock duration in milliseconds, as
+ * of the last replay.
+ */
+const uint32_t
+Trace_player::get_duration() const
+{
+  return _duration;
+}
+
+const double
+Trace_player::get_pitch() const
+{
+  return _pitch;
+}
+
+const double
+Trace_player::get_roll() const
+{
+  return _roll;
+}
+
+const uint8_t
+Trace_player::read_uint8()
+{
+  if (_offset >= _data.size()) {
+    Log::fatal("Trace_player::read_uint8(): trace truncated");
+  }
+  return _data[_offset++];
+}
+
+const uint16_t
+Trace_player::read_uint16()
+{
+  const uint16_t low = read_uint8();
+  return low | (((uint16_t)read_uint8()) << 8);
+}
+
+const uint32_t
+Trace_player::read_uint32()
+{
+  const uint32_t low = read_uint16();
+  return low | (((uint32_t)read_uint16()) << 16);
+}
+
+const uint64_t
+Trace_player::read_uint64()
+{
+  const uint64_t low = read_uint32();
+  return low | (((uint64_t)read_uint32()) << 32);
+}
+
+const double
+Trace_player::read_double()
+{
+  const uint64_t bits = read_uint64();
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,81 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef TRACE_PLAYER_HH
+#define TRACE_PLAYER_HH
+
+#include <inttypes.h>
+#include <vector>
+#include <isensors.hh>
+#include <ipotential-field.hh>
+#include <ifield-geometry-listener.hh>
+#include <balls.hh>
+
+/*
+ * Replays a trace written by Trace_recorder into a set of balls as
+ * fast as possible, i.e. without any timer.  The player restores the
+ * balls' snapshot from the trace, and acts as the balls' sensors
+ * while replaying the recorded samples.  The balls must have been
+ * created for the same level and with the same number of balls as
+ * the recorded ones.
+ */
+class Trace_player : private ISensors
+{
+public:
+  Trace_player(const char *path);
+  virtual ~Trace_player();
+  const uint16_t get_ball_count() const;
+  void replay(Balls *balls, const IPotential_field *potential_field,
+              IField_geometry_listener *geometry_listener);
+  const uint64_t get_step_count() const;
+  const uint64_t get_substep_count() const;
+  const uint32_t get_duration() const;
+  virtual const double get_pitch() const;
+  virtual const double get_roll() const;
+private:
+  std::vector<uint8_t> _data;
+  size_t _offset;
+  size_t _events_offset;
+  uint16_t _ball_count;
+  double _pitch;
+  double _roll;
+  uint64_t _step_count;
+  uint64_t _substep_count;
+  uint32_t _duration;
+  void restore_snapshot(Balls *balls);
+  const uint8_t read_uint8();
+  const uint16_t read_uint16();
+  const uint32_t read_uint32();
+  const uint64_t read_uint64();
+  const double read_double();
+};
+
+#endif /* TRACE_PLAYER_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,256 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <trace-recorder.hh>
+#include <cstring>
+#include <balls.hh>
+#include <log.hh>
+
+const char
+Trace_recorder::MAGIC[4] = { 'M', 'Z', 'T', 'R' };
+
+const uint16_t
+Trace_recorder::VERSION = 2;
+
+Trace_recorder::Trace_recorder(const char *path)
+{
+  if (!path) {
+    Log::fatal("Trace_recorder(): path is null");
+  }
+  _file = fopen(path, "wb");
+  if (!_file) {
+    Log::fatal(std::string("Trace_recorder(): failed opening ") + path);
+  }
+  _start = std::chrono::steady_clock::now();
+  _has_begun = false;
+  _has_sample = false;
+  _pitch = 0.0;
+  _roll = 0.0;
+  _substeps = 0;
+  _pending_steps = 0;
+  _step_count = 0;
+}
+
+Trace_recorder::~Trace_recorder()
+{
+  end();
+}
+
+/*
+ * Writes the trace header with a snapshot of the current state of
+ * all balls.  Must be called exactly once before any event.
+ */
+void
+Trace_recorder::begin(const Balls *balls)
+{
+  if (!balls) {
+    Log::fatal("Trace_recorder::begin(): balls is null");
+  }
+  if (!_file) {
+    Log::fatal("Trace_recorder::begin(): trace already ended");
+  }
+  if (_has_begun) {
+    Log::fatal("Trace_recorder::begin(): trace already begun");
+  }
+  _has_begun = true;
+  for (uint8_t i = 0; i < sizeof(MAGIC); i++) {
+    write_uint8(MAGIC[i]);
+  }
+  write_uint16(VERSION);
+  write_uint16(balls->get_count());
+  for (uint16_t i = 0; i < balls->get_count(); i++) {
+    const Ball *ball = balls->at(i);
+    write_double(ball->get_position()->get_x());
+    write_double(ball->get_position()->get_y());
+    write_double(ball->get_velocity()->get_x());
+    write_double(ball->get_velocity()->get_y());
+    write_double(ball->get_mass());
+    write_uint32(ball->get_random_seed());
+    write_uint64(ball->get_substep_count());
+    write_uint8(ball->get_is_in_goal() ? 1 : 0);
+  }
+}
+
+void
+Trace_recorder::record_step(const uint32_t substeps,
+                            const double pitch, const double roll)
+{
+  if (!_has_begun) {
+    Log::fatal("Trace_recorder::record_step(): trace not yet begun");
+  }
+  if (substeps != _substeps) {
+    flush_steps();
+    write_uint8(EVENT_SPEED);
+    write_uint32(substeps);
+    _substeps = substeps;
+  }
+  if (!_has_sample || (pitch != _pitch) || (roll != _roll)) {
+    flush_steps();
+    write_uint8(EVENT_SAMPLE);
+    write_uint32(get_timestamp());
+    write_double(pitch);
+    write_double(roll);
+    _has_sample = true;
+    _pitch = pitch;
+    _roll = roll;
+  }
+  if (_pending_steps == UINT32_MAX) {
+    flush_steps();
+  }
+  _pending_steps++;
+  _step_count++;
+}
+
+void
+Trace_recorder::record_seed(const uint32_t random_seed)
+{
+  if (!_has_begun) {
+    Log::fatal("Trace_recorder::record_seed(): trace not yet begun");
+  }
+  flush_steps();
+  write_uint8(EVENT_SEED);
+  write_uint32(random_seed);
+}
+
+void
+Trace_recorder::record_field(const uint16_t width, const uint16_t height)
+{
+  if (!_has_begun) {
+    Log::fatal("Trace_recorder::record_field(): trace not yet begun");
+  }
+  flush_steps();
+  write_uint8(EVENT_FIELD);
+  write_uint16(width);
+  write_uint16(height);
+}
+
+void
+Trace_recorder::record_mode(const uint8_t collision_mode,
+                            const bool colliding_balls)
+{
+  if (!_has_begun) {
+    Log::fatal("Trace_recorder::record_mode(): trace not yet begun");
+  }
+  flush_steps();
+  write_uint8(EVENT_MODE);
+  write_uint8(collision_mode);
+  write_uint8(colliding_balls ? 1 : 0);
+}
+
+/*
+ * Terminates the trace with the total recording time and closes the
+ * file.  Subsequent calls have no effect.
+ */
+void
+Trace_recorder::end()
+{
+  if (!_file) {
+    return;
+  }
+  if (_has_begun) {
+    flush_steps();
+    write_uint8(EVENT_END);
+    write_uint32(get_timestamp());
+  }
+  if (fclose(_file)) {
+    _file = 0;
+    Log::fatal("Trace_recorder::end(): failed closing trace");
+  }
+  _file = 0;
+}
+
+const uint64_t
+Trace_recorder::get_step_count() const
+{
+  return _step_count;
+}
+
+/*
+ * Returns the milliseconds since the recorder has been created.
+ */
+const uint32_t
+Trace_recorder::get_timestamp() const
+{
+  const std::chrono::milliseconds elapsed =
+    std::chrono::duration_cast<std::chrono::milliseconds>
+    (std::chrono::steady_clock::now() - _start);
+  return elapsed.count();
+}
+
+void
+Trace_recorder::flush_steps()
+{
+  if (_pending_steps) {
+    write_uint8(EVENT_STEPS);
+    write_uint32(_pending_steps);
+    _pending_steps = 0;
+  }
+}
+
+void
+Trace_recorder::write_uint8(const uint8_t value)
+{
+  if (!_file) {
+    Log::fatal("Trace_recorder::write_uint8(): trace already ended");
+  }
+  if (fputc(value, _file) == EOF) {
+    Log::fatal("Trace_recorder::write_uint8(): failed writing trace");
+  }
+}
+
+void
+Trace_recorder::write_uint16(const uint16_t value)
+{
+  write_uint8(value & 0xff);
+  write_uint8(value >> 8);
+}
+
+void
+Trace_recorder::write_uint32(const uint32_t value)
+{
+  write_uint16(value & 0xffff);
+  write_uint16(value >> 16);
+}
+
+void
+Trace_recorder::write_uint64(const uint64_t value)
+{
+  write_uint32(value & 0xffffffff);
+  write_uint32(value >> 32);
+}
+
+void
+Trace_recorder::write_double(const double value)
+{
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  write_uint64(bits);
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,99 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef TRACE_RECORDER_HH
+#define TRACE_RECORDER_HH
+
+#include <inttypes.h>
+#include <cstdio>
+#include <chrono>
+
+class Balls;
+
+/*
+ * Records all input that drives the physics into a compact binary
+ * trace, such that a game can be replayed deterministically (see
+ * Trace_player).  A trace starts with a snapshot of all balls,
+ * followed by events: timestamped sensor samples, changes of the
+ * number of substeps per step ("speed"), random seeds, field
+ * geometry and collision modes.  Steps without any change in
+ * between are run-length encoded, and sensor samples are written
+ * only when they change.  All values are stored in little endian
+ * byte order, independent of the host.
+ *
+ * The trace assumes that the sensors do not change during a step,
+ * which holds since Balls::step() reads the sensors only once per
+ * step, and holds their values for all substeps.
+ */
+class Trace_recorder
+{
+public:
+  static const char MAGIC[4];
+  static const uint16_t VERSION;
+  enum event_t {
+    EVENT_END = 0,
+    EVENT_STEPS = 1,
+    EVENT_SAMPLE = 2,
+    EVENT_SPEED = 3,
+    EVENT_SEED = 4,
+    EVENT_FIELD = 5,
+    EVENT_MODE = 6
+  };
+  Trace_recorder(const char *path);
+  virtual ~Trace_recorder();
+  void begin(const Balls *balls);
+  void record_step(const uint32_t substeps,
+                   const double pitch, const double roll);
+  void record_seed(const uint32_t random_seed);
+  void record_field(const uint16_t width, const uint16_t height);
+  void record_mode(const uint8_t collision_mode, const bool colliding_balls);
+  void end();
+  const uint64_t get_step_count() const;
+private:
+  FILE *_file;
+  std::chrono::steady_clock::time_point _start;
+  bool _has_begun;
+  bool _has_sample;
+  double _pitch;
+  double _roll;
+  uint32_t _substeps;
+  uint32_t _pending_steps;
+  uint64_t _step_count;
+  const uint32_t get_timestamp() const;
+  void flush_steps();
+  void write_uint8(const uint8_t value);
+  void write_uint16(const uint16_t value);
+  void write_uint32(const uint32_t value);
+  void write_uint64(const uint64_t value);
+  void write_double(const double value);
+};
+
+#endif /* TRACE_RECORDER_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
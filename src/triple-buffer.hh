@@ -0,0 +1,66 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef TRIPLE_BUFFER_HH
+#define TRIPLE_BUFFER_HH
+
+#include <inttypes.h>
+#include <atomic>
+
+/*
+ * Lock-free handoff of the latest state from a single writer thread
+ * to a single reader thread.  The writer fills the back slot and
+ * publishes it; the reader takes the most recently published slot.
+ * Neither side ever waits for the other: the writer may publish
+ * states that the reader never sees, and the reader keeps seeing the
+ * same state until a newer one is published.  A slot that the
+ * writer gets is not cleared; it holds some older state and must be
+ * overwritten completely.
+ */
+template<class T>
+class Triple_buffer
+{
+public:
+  Triple_buffer();
+  virtual ~Triple_buffer();
+  T *get_back();
+  void publish();
+  const T *get_front();
+private:
+  static const uint8_t INDEX_MASK = 0x3;
+  static const uint8_t FLAG_FRESH = 0x4;
+  T _slots[3];
+  uint8_t _back;
+  std::atomic<uint8_t> _middle;
+  uint8_t _front;
+};
+
+#endif /* TRIPLE_BUFFER_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,88 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef TRIPLE_BUFFER_TCC
+#define TRIPLE_BUFFER_TCC
+
+#include <triple-buffer.hh>
+
+template<class T>
+Triple_buffer<T>::Triple_buffer()
+{
+  _back = 0;
+  _middle = 1;
+  _front = 2;
+}
+
+template<class T>
+Triple_buffer<T>::~Triple_buffer()
+{
+}
+
+/*
+ * Returns the slot that the writer may fill.
+ */
+template<class T>
+T *
+Triple_buffer<T>::get_back()
+{
+  return &_slots[_back];
+}
+
+/*
+ * Makes the filled back slot the latest state, and hands a new back
+ * slot to the writer.
+ */
+template<class T>
+void
+Triple_buffer<T>::publish()
+{
+  _back =
+    _middle.exchange(_back | FLAG_FRESH, std::memory_order_acq_rel) &
+    INDEX_MASK;
+}
+
+/*
+ * Returns the latest published state.  The state remains valid until
+ * the reader's next call of this method.
+ */
+template<class T>
+const T *
+Triple_buffer<T>::get_front()
+{
+  if (_middle.load(std::memory_order_relaxed) & FLAG_FRESH) {
+    _front =
+      _middle.exchange(_front, std::memory_order_acq_rel) & INDEX_MASK;
+  }
+  return &_slots[_front];
+}
+
+#endif // TRIPLE_BUFFER_TCC
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
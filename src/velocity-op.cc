@@ -0,0 +1,86 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <velocity-op.hh>
+
+struct Velocity_op::reflection_t
+Velocity_op::REFLECTIONS[THETA_STEPS >> 1];
+
+struct Velocity_op::fixed_reflection_t
+Velocity_op::FIXED_REFLECTIONS[THETA_STEPS >> 1];
+
+struct Velocity_op::direction_t
+Velocity_op::DIRECTIONS[THETA_STEPS];
+
+const bool
+Velocity_op::TABLES_INITIALIZED = init_tables();
+
+const bool
+Velocity_op::init_tables()
+{
+  for (uint16_t index = 0; index < (THETA_STEPS >> 1); index++) {
+    const double theta = index * (2.0 * M_PI / THETA_STEPS);
+    REFLECTIONS[index].cos_2theta = cos(2.0 * theta);
+    REFLECTIONS[index].sin_2theta = sin(2.0 * theta);
+    FIXED_REFLECTIONS[index].cos_2theta =
+      Fixed_point::from_double(cos(2.0 * theta), Fixed_point::COEFFICIENT_BITS);
+    FIXED_REFLECTIONS[index].sin_2theta =
+      Fixed_point::from_double(sin(2.0 * theta), Fixed_point::COEFFICIENT_BITS);
+  }
+  for (uint16_t index = 0; index < THETA_STEPS; index++) {
+    const double theta = index * (2.0 * M_PI / THETA_STEPS);
+    DIRECTIONS[index].cos_theta = cos(theta);
+    DIRECTIONS[index].sin_theta = sin(theta);
+  }
+  return true;
+}
+
+const uint16_t
+Velocity_op::get_theta_index(const double theta)
+{
+  if (std::isnan(theta) || std::isinf(theta)) {
+    // undefined angle; only used with operations that do not reflect
+    return 0;
+  }
+  const double steps = theta * (THETA_STEPS / (2.0 * M_PI));
+  return ((int32_t)floor(steps + 0.5)) & THETA_MASK;
+}
+
+const uint16_t
+Velocity_op::encode(const double theta,
+                    const bool is_reflection,
+                    const bool is_exclusion_zone)
+{
+  return
+    get_theta_index(theta) |
+    (is_reflection ? FLAG_REFLECTION : 0) |
+    (is_exclusion_zone ? FLAG_EXCLUSION_ZONE : 0);
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,128 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef VELOCITY_OP_HH
+#define VELOCITY_OP_HH
+
+#include <inttypes.h>
+#include <cmath>
+#include <fixed-point.hh>
+
+/*
+ * Packed encoding of the velocity operation that a force field
+ * applies onto a ball at a specific pixel.  Each operation fits into
+ * 16 bits: The lower 12 bits hold the quantized angle theta of the
+ * wall's tangent, the upper bits hold flags.  The reflection matrix
+ * of an angle is looked up from a small precomputed table rather than
+ * stored per pixel.
+ */
+class Velocity_op
+{
+public:
+  static const uint8_t THETA_BITS = 12;
+  static const uint16_t THETA_STEPS = 1 << THETA_BITS;
+  static const uint16_t THETA_MASK = THETA_STEPS - 1;
+  static const uint16_t FLAG_REFLECTION = 0x1000;
+  static const uint16_t FLAG_EXCLUSION_ZONE = 0x2000;
+
+  /*
+   * Reflection on a line with angle theta maps velocity (vx, vy) to
+   * (-cos(2 theta) vx + sin(2 theta) vy,
+   *  sin(2 theta) vx + cos(2 theta) vy).
+   * Since the matrix depends only on 2 theta, the table covers half
+   * the angle range.
+   */
+  struct reflection_t {
+    double cos_2theta;
+    double sin_2theta;
+  };
+
+  /*
+   * Same as reflection_t, with coefficients in fixed-point.
+   */
+  struct fixed_reflection_t {
+    Fixed_point cos_2theta;
+    Fixed_point sin_2theta;
+  };
+
+  /*
+   * Unit vector of the wall's tangent, as used for averaging angles.
+   */
+  struct direction_t {
+    float cos_theta;
+    float sin_theta;
+  };
+
+  static const uint16_t encode(const double theta,
+                               const bool is_reflection,
+                               const bool is_exclusion_zone);
+  static const uint16_t get_theta_index(const double theta);
+
+  static inline const double get_theta(const uint16_t op)
+  {
+    return (op & THETA_MASK) * (2.0 * M_PI / THETA_STEPS);
+  }
+
+  static inline const bool is_reflection(const uint16_t op)
+  {
+    return op & FLAG_REFLECTION;
+  }
+
+  static inline const bool is_exclusion_zone(const uint16_t op)
+  {
+    return op & FLAG_EXCLUSION_ZONE;
+  }
+
+  static inline const struct reflection_t *get_reflection(const uint16_t op)
+  {
+    return &REFLECTIONS[op & (THETA_MASK >> 1)];
+  }
+
+  static inline const struct fixed_reflection_t *
+  get_fixed_reflection(const uint16_t op)
+  {
+    return &FIXED_REFLECTIONS[op & (THETA_MASK >> 1)];
+  }
+
+  static inline const struct direction_t *get_direction(const uint16_t op)
+  {
+    return &DIRECTIONS[op & THETA_MASK];
+  }
+
+private:
+  static struct reflection_t REFLECTIONS[THETA_STEPS >> 1];
+  static struct fixed_reflection_t FIXED_REFLECTIONS[THETA_STEPS >> 1];
+  static struct direction_t DIRECTIONS[THETA_STEPS];
+  static const bool init_tables();
+  static const bool TABLES_INITIALIZED;
+};
+
+#endif /* VELOCITY_OP_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
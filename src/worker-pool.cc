@@ -0,0 +1,148 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#include <worker-pool.hh>
+#include <log.hh>
+
+std::mutex
+Worker_pool::_default_lock;
+
+Worker_pool *
+Worker_pool::_default = 0;
+
+Worker_pool *
+Worker_pool::get_default()
+{
+  std::lock_guard<std::mutex> guard(_default_lock);
+  if (!_default) {
+    const uint16_t thread_count = std::thread::hardware_concurrency();
+    _default = new Worker_pool(thread_count > 0 ? thread_count : 1);
+    if (!_default) {
+      Log::fatal("Worker_pool::get_default(): not enough memory");
+    }
+  }
+  return _default;
+}
+
+Worker_pool::Worker_pool(const uint16_t thread_count) :
+  _task(0),
+  _task_count(0),
+  _next_task(0),
+  _busy_threads(0),
+  _round(0),
+  _is_shutting_down(false)
+{
+  if (thread_count < 1) {
+    Log::fatal("Worker_pool(): thread_count < 1");
+  }
+  // the calling thread of run() serves as one of the threads
+  for (uint16_t i = 1; i < thread_count; i++) {
+    _threads.push_back(std::thread(&Worker_pool::work, this));
+  }
+}
+
+Worker_pool::~Worker_pool()
+{
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    _is_shutting_down = true;
+  }
+  _work_available.notify_all();
+  for (std::thread &thread : _threads) {
+    thread.join();
+  }
+}
+
+const uint16_t
+Worker_pool::get_thread_count() const
+{
+  return _threads.size() + 1;
+}
+
+void
+Worker_pool::run_tasks()
+{
+  uint32_t index;
+  while ((index = _next_task++) < _task_count) {
+    _task->run_task(index);
+  }
+}
+
+void
+Worker_pool::work()
+{
+  uint32_t round = 0;
+  std::unique_lock<std::mutex> lock(_lock);
+  while (true) {
+    _work_available.wait(lock, [this, round] {
+        return _is_shutting_down || (_round != round);
+      });
+    if (_is_shutting_down) {
+      return;
+    }
+    round = _round;
+    lock.unlock();
+    run_tasks();
+    lock.lock();
+    if (!--_busy_threads) {
+      _work_done.notify_one();
+    }
+  }
+}
+
+void
+Worker_pool::run(IWorker_task *task, const uint32_t task_count)
+{
+  if (!task) {
+    Log::fatal("Worker_pool::run(): task is null");
+  }
+  std::lock_guard<std::mutex> run_guard(_run_lock);
+  if (_threads.empty() || (task_count < 2)) {
+    for (uint32_t index = 0; index < task_count; index++) {
+      task->run_task(index);
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    _task = task;
+    _task_count = task_count;
+    _next_task = 0;
+    _busy_threads = _threads.size();
+    _round++;
+  }
+  _work_available.notify_all();
+  run_tasks();
+  std::unique_lock<std::mutex> lock(_lock);
+  _work_done.wait(lock, [this] { return !_busy_threads; });
+  _task = 0;
+  _task_count = 0;
+}
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */
@@ -0,0 +1,75 @@
+/*
+ * Maze -- A maze / flipper game implementation for RPi with Sense Hat
+ * Copyright (C) 2016, 2017, 2018 Jürgen Reuter
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ *
+ * For updates and more info or contacting the author, visit:
+ * <https://github.com/soundpaint/maze>
+ *
+ * Author's web site: www.juergen-reuter.de
+ */
+
+#ifndef WORKER_POOL_HH
+#define WORKER_POOL_HH
+
+#include <inttypes.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <iworker-task.hh>
+
+/*
+ * A fixed set of threads that run the tasks of a job in parallel.
+ * The calling thread participates in running the tasks and returns
+ * only when all tasks are done.  Concurrent calls of run() are
+ * serialized; a task must not itself call run() on the same pool.
+ */
+class Worker_pool
+{
+public:
+  static Worker_pool *get_default();
+  Worker_pool(const uint16_t thread_count);
+  virtual ~Worker_pool();
+  const uint16_t get_thread_count() const;
+  void run(IWorker_task *task, const uint32_t task_count);
+private:
+  static std::mutex _default_lock;
+  static Worker_pool *_default;
+  std::vector<std::thread> _threads;
+  std::mutex _run_lock;
+  std::mutex _lock;
+  std::condition_variable _work_available;
+  std::condition_variable _work_done;
+  IWorker_task *_task;
+  uint32_t _task_count;
+  std::atomic<uint32_t> _next_task;
+  uint32_t _busy_threads;
+  uint32_t _round;
+  bool _is_shutting_down;
+  void work();
+  void run_tasks();
+};
+
+#endif /* WORKER_POOL_HH */
+
+/*
+ * Local variables:
+ *   mode: c++
+ *   coding: utf-8
+ * End:
+ */